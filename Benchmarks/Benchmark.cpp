@@ -0,0 +1,125 @@
+#include "Benchmark.h"
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#ifdef Q_OS_WIN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
+static std::atomic<qint64> allocated(0);
+
+void* operator new(size_t size)
+{
+	allocated++;
+	void* memory = std::malloc(size == 0 ? 1 : size);
+	if (memory == nullptr) throw std::bad_alloc();
+	return memory;
+}
+
+void operator delete(void* memory) noexcept
+{
+	std::free(memory);
+}
+
+
+BenchmarkResult Benchmark::measure(const QString& name, int runs, std::function<void()> work)
+{
+	work();
+
+	std::vector<double> times = std::vector<double>();
+	times.reserve(runs);
+
+	//counted over every timed run, the warm up one makes allocations the others reuse
+	qint64 start = allocationCount();
+	QElapsedTimer timer;
+	for (int i = 0; i < runs; ++i)
+	{
+		timer.start();
+		work();
+		times.push_back(timer.nsecsElapsed() / 1000000.0);
+	}
+	qint64 allocations = (allocationCount() - start) / runs;
+
+	std::sort(times.begin(), times.end());
+
+	BenchmarkResult result = BenchmarkResult();
+	result.name = name;
+	result.runs = runs;
+	result.min = times.front();
+	result.median = times[times.size() / 2];
+	result.max = times.back();
+	result.allocations = allocations;
+	measured.push_back(result);
+
+	QTextStream(stdout) << "  " << name.leftJustified(40) << " median " << QString::number(result.median, 'f', 3)
+		<< "ms  min " << QString::number(result.min, 'f', 3) << "ms  max " << QString::number(result.max, 'f', 3)
+		<< "ms  " << allocations << " allocs  (" << runs << " runs)" << endl;
+
+	return result;
+}
+
+void Benchmark::compare(const BenchmarkResult& before, const BenchmarkResult& after)
+{
+	if (after.median <= 0) return;
+
+	QTextStream(stdout) << "  " << after.name << " vs " << before.name << ": "
+		<< QString::number(before.median / after.median, 'f', 2) << "x" << endl;
+}
+
+qint64 Benchmark::allocationCount()
+{
+	return allocated.load();
+}
+
+QString Benchmark::argValue(const QStringList& args, const QString& key, const QString& fallback)
+{
+	int index = args.indexOf(key);
+	if (index < 0 || index + 1 >= args.size()) return fallback;
+
+	return args.at(index + 1);
+}
+
+qint64 Benchmark::peakMemory()
+{
+#ifdef Q_OS_WIN
+	PROCESS_MEMORY_COUNTERS counters;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+	return qint64(counters.PeakWorkingSetSize);
+#else
+	rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef Q_OS_MAC
+	return qint64(usage.ru_maxrss);
+#else
+	return qint64(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+double Benchmark::processCpuTime()
+{
+#ifdef Q_OS_WIN
+	FILETIME creation, exit, kernel, user;
+	if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) return 0;
+
+	ULARGE_INTEGER k, u;
+	k.LowPart = kernel.dwLowDateTime;
+	k.HighPart = kernel.dwHighDateTime;
+	u.LowPart = user.dwLowDateTime;
+	u.HighPart = user.dwHighDateTime;
+	return (k.QuadPart + u.QuadPart) / 10000.0;
+#else
+	rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+	return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000.0 + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000.0;
+#endif
+}
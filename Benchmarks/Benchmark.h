@@ -0,0 +1,47 @@
+#pragma once
+#include <QString>
+#include <QStringList>
+#include <functional>
+#include <vector>
+
+struct BenchmarkResult
+{
+	QString name;
+	int runs;
+	double min, median, max;
+	//heap allocations made by a timed run, on average
+	qint64 allocations;
+};
+
+//base for a benchmark suite, suites are registered in main and run by name
+class Benchmark
+{
+public:
+	virtual ~Benchmark() {}
+
+	virtual QString name() const = 0;
+	virtual QString description() const = 0;
+
+	//args are whatever was left on the command line after the suite name
+	virtual void run(const QStringList& args) = 0;
+
+	const std::vector<BenchmarkResult>& results() const { return measured; }
+
+protected:
+	//times the work over a number of runs (after one warm up run) and prints the result in milliseconds
+	BenchmarkResult measure(const QString& name, int runs, std::function<void()> work);
+	//prints the speed up of one result over another
+	static void compare(const BenchmarkResult& before, const BenchmarkResult& after);
+
+	//heap allocations made by the process so far, counted by the operator new in Benchmark.cpp
+	static qint64 allocationCount();
+	//largest the process has been so far in bytes, it never goes down so big cases are best run last
+	static qint64 peakMemory();
+	//user and kernel time of every thread in the process so far, in ms
+	static double processCpuTime();
+
+	static QString argValue(const QStringList& args, const QString& key, const QString& fallback = "");
+
+private:
+	std::vector<BenchmarkResult> measured;
+};
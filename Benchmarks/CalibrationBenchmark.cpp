@@ -0,0 +1,237 @@
+#include "CalibrationBenchmark.h"
+#include <qdir.h>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <algorithm>
+#include <map>
+#include <opencv2/calib3d.hpp>
+#include <opencv2/core/persistence.hpp>
+#include "CalibrationEngine.h"
+#include "ProjectSnapshot.h"
+
+static QByteArray readFile(const QString& path)
+{
+	QByteArray data;
+	QFile file(path);
+	if (file.open(QIODevice::ReadOnly)) data = file.readAll();
+
+	return data;
+}
+
+static QString ms(double value)
+{
+	return QString::number(value, 'f', 0) + "ms";
+}
+
+void CalibrationBenchmark::run(const QStringList& args)
+{
+	int runs = qMax(1, argValue(args, "--runs", "1").toInt());
+	int threads = argValue(args, "--threads", "0").toInt();
+	QString source = argValue(args, "--project");
+	QTextStream out(stdout);
+
+	QTemporaryDir corpus;
+	QString original = corpus.path() + "/original";
+	SyntheticChessboard* generator = nullptr;
+
+	QElapsedTimer clock;
+	clock.start();
+	if (source.isEmpty())
+	{
+		int sets = qMax(1, argValue(args, "--sets", "20").toInt());
+
+		GeneratorOptions options = GeneratorOptions();
+		options.cameras = qMax(1, argValue(args, "--pairs", "1").toInt()) * 2;
+		options.imageSize = cv::Size(argValue(args, "--width", "1280").toInt(), argValue(args, "--height", "960").toInt());
+		options.seed = argValue(args, "--seed", "1").toUInt();
+
+		generator = new SyntheticChessboard(options);
+		if (!generator->writeProject(original, sets))
+		{
+			out << "  unable to write the generated project" << endl;
+			delete generator;
+			return;
+		}
+		out << "  generated " << sets << " sets x " << options.cameras << " cameras at " << options.imageSize.width << "x"
+			<< options.imageSize.height << " in " << ms(clock.elapsed()) << endl;
+	}
+	else if (!copyProject(source, original))
+	{
+		out << "  unable to copy " << source << endl;
+		return;
+	}
+
+	ProjectSnapshotPtr project = ProjectSnapshot::parse(readFile(original + "/project.scan"));
+	std::vector<CameraPair> pairs = std::vector<CameraPair>();
+	CalibrationEngine::loadPairs(original, pairs);
+	if (project.isNull())
+	{
+		out << "  project.scan could not be parsed" << endl;
+		delete generator;
+		return;
+	}
+
+	//each stage runs until the next one starts
+	const QStringList stages = QStringList() << "Validating images" << "Calibrating cameras" << "Calibrating pairs";
+	std::map<QString, std::vector<double>> stageTimes = std::map<QString, std::vector<double>>();
+	std::vector<double> totals = std::vector<double>();
+	CalibrationSummary summary;
+	QString projectPath;
+
+	for (int pass = 0; pass < runs; ++pass)
+	{
+		//every run starts from the untouched images
+		projectPath = corpus.path() + "/run" + QString::number(pass);
+		if (!copyProject(original, projectPath))
+		{
+			out << "  unable to copy the project for run " << pass + 1 << endl;
+			delete generator;
+			return;
+		}
+
+		CalibrationEngine engine(threads);
+		QString stage = "";
+		QElapsedTimer stageClock;
+		QObject::connect(&engine, &CalibrationEngine::stageStarted, [&](QString next) {
+			if (!stage.isEmpty()) stageTimes[stage].push_back(stageClock.nsecsElapsed() / 1000000.0);
+			stage = next;
+			stageClock.start();
+		});
+
+		double cpu = processCpuTime();
+		clock.start();
+		summary = engine.run(projectPath, project, pairs);
+		double wall = clock.nsecsElapsed() / 1000000.0;
+		if (!stage.isEmpty()) stageTimes[stage].push_back(stageClock.nsecsElapsed() / 1000000.0);
+		totals.push_back(wall);
+
+		out << "  run " << pass + 1 << ": " << ms(wall) << " wall, " << ms(processCpuTime() - cpu) << " cpu, peak memory "
+			<< peakMemory() / (1024 * 1024) << "MB" << endl;
+	}
+
+	if (!summary.error.isEmpty())
+	{
+		out << "  calibration failed: " << summary.error << endl;
+		delete generator;
+		return;
+	}
+
+	std::sort(totals.begin(), totals.end());
+	out << "  " << summary.validImages << " valid and " << summary.invalidImages << " invalid images, "
+		<< summary.calibratedCameras << "/" << summary.calibratedCameras + summary.failedCameras << " cameras, "
+		<< summary.calibratedPairs << "/" << summary.calibratedPairs + summary.failedPairs << " pairs, median "
+		<< ms(totals[totals.size() / 2]) << endl;
+
+	for (int i = 0; i < stages.size(); ++i)
+	{
+		std::vector<double>& times = stageTimes[stages.at(i)];
+		if (times.empty()) continue;
+		std::sort(times.begin(), times.end());
+
+		double median = times[times.size() / 2];
+		out << "    " << stages.at(i).leftJustified(22) << "median " << ms(median) << "  min " << ms(times.front())
+			<< "  max " << ms(times.back());
+		if (i == 0 && median > 0)
+			out << "  " << QString::number((summary.validImages + summary.invalidImages) / (median / 1000), 'f', 1) << " images/s";
+		out << endl;
+	}
+
+	reportAccuracy(projectPath, pairs, generator);
+	delete generator;
+}
+
+void CalibrationBenchmark::reportAccuracy(const QString& projectPath, const std::vector<CameraPair>& pairs, const SyntheticChessboard* truth) const
+{
+	QTextStream out(stdout);
+	ProjectSnapshotPtr project = ProjectSnapshot::parse(readFile(projectPath + "/project.scan"));
+
+	for (int i = 0; project && i < project->cameraCount(); ++i)
+	{
+		QString name = project->camera(i).name;
+		cv::FileStorage file(CalibrationEngine::cameraConfigPath(projectPath, name).toStdString(), cv::FileStorage::READ);
+		if (!file.isOpened())
+		{
+			out << "    " << name << ": not calibrated" << endl;
+			continue;
+		}
+
+		cv::Mat K, D;
+		double rms = 0;
+		file["K"] >> K;
+		file["D"] >> D;
+		file["rms"] >> rms;
+
+		out << "    " << name << ": rms " << QString::number(rms, 'f', 3) << "px";
+		if (truth != nullptr && i < truth->getCameras().size() && K.rows == 3 && K.cols == 3 && D.total() >= 5)
+		{
+			const VirtualCamera& camera = truth->getCameras()[i];
+			double distortion = 0;
+			for (int j = 0; j < 5; ++j)
+				distortion = qMax(distortion, qAbs(D.at<double>(j) - camera.D(0, j)));
+
+			out << "  focal error " << QString::number(K.at<double>(0, 0) - camera.K(0, 0), 'f', 2) << "/"
+				<< QString::number(K.at<double>(1, 1) - camera.K(1, 1), 'f', 2) << "px  centre error "
+				<< QString::number(K.at<double>(0, 2) - camera.K(0, 2), 'f', 2) << "/"
+				<< QString::number(K.at<double>(1, 2) - camera.K(1, 2), 'f', 2) << "px  largest distortion error "
+				<< QString::number(distortion, 'f', 4);
+		}
+		out << endl;
+	}
+
+	for (int i = 0; i < pairs.size(); ++i)
+	{
+		cv::FileStorage file(CalibrationEngine::pairConfigPath(projectPath, pairs[i].id).toStdString(), cv::FileStorage::READ);
+		if (!file.isOpened())
+		{
+			out << "    pair " << pairs[i].id << ": not calibrated" << endl;
+			continue;
+		}
+
+		cv::Mat R;
+		std::vector<double> T;
+		double rms = 0;
+		file["R"] >> R;
+		file["T"] >> T;
+		file["rms"] >> rms;
+
+		out << "    pair " << pairs[i].id << ": rms " << QString::number(rms, 'f', 3) << "px";
+		if (truth != nullptr && i < truth->getPairs().size() && R.rows == 3 && R.cols == 3 && T.size() == 3)
+		{
+			cv::Matx33d trueR;
+			cv::Vec3d trueT;
+			truth->pairTruth(truth->getPairs()[i], trueR, trueT);
+
+			//angle of the rotation left between what was found and the truth
+			cv::Mat difference = R * cv::Mat(trueR).t();
+			cv::Vec3d axis;
+			cv::Rodrigues(difference, axis);
+
+			cv::Vec3d found = cv::Vec3d(T[0], T[1], T[2]);
+			double offset = cv::norm(found - trueT);
+			out << "  rotation error " << QString::number(cv::norm(axis) * 180 / CV_PI, 'f', 3) << "deg  translation error "
+				<< QString::number(offset, 'f', 2) << "mm (" << QString::number(offset / cv::norm(trueT) * 100, 'f', 2) << "% of baseline)";
+		}
+		out << endl;
+	}
+}
+
+bool CalibrationBenchmark::copyProject(const QString& from, const QString& to)
+{
+	QDir source(from);
+	if (!source.exists() || !QDir().mkpath(to)) return false;
+
+	QDirIterator files(from, QDir::Files, QDirIterator::Subdirectories);
+	while (files.hasNext())
+	{
+		QString path = files.next();
+		QString target = to + "/" + source.relativeFilePath(path);
+		if (!QDir().mkpath(QFileInfo(target).path())) return false;
+		if (!QFile::copy(path, target)) return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include "Benchmark.h"
+#include <vector>
+#include "SyntheticChessboard.h"
+#include "JsonTypes.h"
+
+//runs the whole calibration engine (validate, intrinsics, stereo) over a project and reports the time of each
+//stage, images/s, cpu, peak memory and reprojection rms. generated projects are rendered from known board poses,
+//so the intrinsics and extrinsics found are also compared to the truth.
+//options: --sets, --pairs, --width/--height, --seed to size the generated project (see ProjectGenerator),
+//--project <dir> to use a recorded one instead (copied first, pairs from its calibration/pairs.json), --threads, --runs
+class CalibrationBenchmark : public Benchmark
+{
+public:
+	QString name() const override { return "calibration"; }
+	QString description() const override { return "calibration pipeline timing and accuracy"; }
+
+	void run(const QStringList& args) override;
+
+private:
+	void reportAccuracy(const QString& projectPath, const std::vector<CameraPair>& pairs, const SyntheticChessboard* truth) const;
+	static bool copyProject(const QString& from, const QString& to);
+};
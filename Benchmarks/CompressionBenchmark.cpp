@@ -0,0 +1,54 @@
+#include "CompressionBenchmark.h"
+#include "SyntheticProject.h"
+#include <QFile>
+#include <QTextStream>
+#include <random>
+
+
+void CompressionBenchmark::run(const QStringList& args)
+{
+	int runs = argValue(args, "--runs", "10").toInt();
+	QString source = argValue(args, "--project");
+
+	QByteArray project;
+	if (source.isEmpty())
+		project = SyntheticProject::projectJson(1, argValue(args, "--sets", "1000").toInt(), argValue(args, "--cameras", "10").toInt());
+	else
+	{
+		QFile file(source);
+		if (file.open(QIODevice::ReadOnly)) project = file.readAll();
+	}
+
+	//random bytes stand in for jpeg data, which doesn't compress any further
+	QByteArray image = QByteArray(2 * 1024 * 1024, 0);
+	std::mt19937 random(42);
+	for (int i = 0; i < image.size(); ++i)
+		image[i] = char(random() & 0xFF);
+
+	comparePayload("ProjectDetails", project, runs);
+	comparePayload("getRecentLogFile", SyntheticProject::logJson(argValue(args, "--lines", "20000").toInt()), runs);
+	comparePayload("ImageSetImageData", image, runs);
+}
+
+void CompressionBenchmark::comparePayload(const QString& label, const QByteArray& payload, int runs)
+{
+	QByteArray compressed = qCompress(payload);
+
+	QTextStream out(stdout);
+	out << "  " << label << ": " << payload.size() / 1024 << "KB -> " << compressed.size() / 1024 << "KB ("
+		<< QString::number(double(payload.size()) / compressed.size(), 'f', 1) << "x)" << endl;
+
+	measure(label + " compress", runs, [&]() { qCompress(payload); });
+	BenchmarkResult decompress = measure(label + " decompress", runs, [&]() { qUncompress(compressed); });
+
+	const int speeds[] = { 1, 10, 100 };
+	for (int i = 0; i < 3; ++i)
+	{
+		double bytesPerMs = speeds[i] * 1000000.0 / 8.0 / 1000.0;
+		double raw = payload.size() / bytesPerMs;
+		double packed = compressed.size() / bytesPerMs + decompress.median;
+
+		out << "    " << speeds[i] << "Mbit/s: raw " << QString::number(raw, 'f', 1) << "ms, compressed "
+			<< QString::number(packed, 'f', 1) << "ms" << endl;
+	}
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include "Benchmark.h"
+#include <QByteArray>
+
+//ratio and decompression cost of qCompress on the scanner replies, with the time the payload
+//would take on a few link speeds so the trade off can be read off directly.
+//options: --project <project.scan>, --sets/--cameras, --lines, --runs
+class CompressionBenchmark : public Benchmark
+{
+public:
+	QString name() const override { return "compression"; }
+	QString description() const override { return "zlib payload compression against link speed"; }
+
+	void run(const QStringList& args) override;
+
+private:
+	void comparePayload(const QString& label, const QByteArray& payload, int runs);
+};
@@ -0,0 +1,89 @@
+#include "EncodingBenchmark.h"
+#include "SyntheticProject.h"
+#include "ProjectSnapshot.h"
+#include "ReplyReader.h"
+#include "Lib/json.hpp"
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+
+static QByteArray encode(const QByteArray& json, ReplyEncoding encoding)
+{
+	nlohmann::json document = nlohmann::json::parse(json.constData(), json.constData() + json.size());
+
+	std::vector<uint8_t> bytes;
+	if (encoding == ReplyEncoding::Cbor) bytes = nlohmann::json::to_cbor(document);
+	else if (encoding == ReplyEncoding::MsgPack) bytes = nlohmann::json::to_msgpack(document);
+	else return json;
+
+	return QByteArray(reinterpret_cast<const char*>(bytes.data()), int(bytes.size()));
+}
+
+static void printSizes(const QString& label, const QByteArray& json, const QByteArray& cbor, const QByteArray& msgpack)
+{
+	QTextStream(stdout) << "  " << label << ": json " << json.size() << "B, cbor " << cbor.size() << "B ("
+		<< QString::number(100.0 * cbor.size() / json.size(), 'f', 1) << "%), msgpack " << msgpack.size() << "B ("
+		<< QString::number(100.0 * msgpack.size() / json.size(), 'f', 1) << "%)" << endl;
+}
+
+void EncodingBenchmark::run(const QStringList& args)
+{
+	int runs = argValue(args, "--runs", "10").toInt();
+
+	bool real = false;
+	for (int i = 0; i < args.size() - 1; ++i)
+	{
+		if (args[i] != "--project") continue;
+
+		QFile file(args[i + 1]);
+		if (!file.open(QIODevice::ReadOnly))
+		{
+			QTextStream(stdout) << "  unable to read " << args[i + 1] << endl;
+			continue;
+		}
+
+		real = true;
+		compareProject(QFileInfo(args[i + 1]).fileName(), file.readAll(), runs);
+	}
+
+	if (!real)
+		compareProject("ProjectDetails", SyntheticProject::projectJson(1, argValue(args, "--sets", "1000").toInt(),
+			argValue(args, "--cameras", "10").toInt()), runs);
+
+	compareLog(SyntheticProject::logJson(argValue(args, "--lines", "20000").toInt()), runs);
+}
+
+void EncodingBenchmark::compareProject(const QString& label, const QByteArray& json, int runs)
+{
+	QByteArray cbor = encode(json, ReplyEncoding::Cbor);
+	QByteArray msgpack = encode(json, ReplyEncoding::MsgPack);
+	printSizes(label, json, cbor, msgpack);
+
+	BenchmarkResult text = measure(label + " json", runs, [&]() { ProjectSnapshot::parse(json, ReplyEncoding::Json); });
+	BenchmarkResult binary = measure(label + " cbor", runs, [&]() { ProjectSnapshot::parse(cbor, ReplyEncoding::Cbor); });
+	compare(text, binary);
+	BenchmarkResult packed = measure(label + " msgpack", runs, [&]() { ProjectSnapshot::parse(msgpack, ReplyEncoding::MsgPack); });
+	compare(text, packed);
+}
+
+void EncodingBenchmark::compareLog(const QByteArray& json, int runs)
+{
+	QByteArray cbor = encode(json, ReplyEncoding::Cbor);
+	QByteArray msgpack = encode(json, ReplyEncoding::MsgPack);
+	printSizes("getRecentLogFile", json, cbor, msgpack);
+
+	BenchmarkResult text = measure("getRecentLogFile json", runs, [&]() {
+		QStringList lines = QStringList();
+		ReplyReader::readStrings(json, lines, ReplyEncoding::Json);
+	});
+	BenchmarkResult binary = measure("getRecentLogFile cbor", runs, [&]() {
+		QStringList lines = QStringList();
+		ReplyReader::readStrings(cbor, lines, ReplyEncoding::Cbor);
+	});
+	compare(text, binary);
+	BenchmarkResult packed = measure("getRecentLogFile msgpack", runs, [&]() {
+		QStringList lines = QStringList();
+		ReplyReader::readStrings(msgpack, lines, ReplyEncoding::MsgPack);
+	});
+	compare(text, packed);
+}
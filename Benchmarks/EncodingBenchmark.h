@@ -0,0 +1,18 @@
+#pragma once
+#include "Benchmark.h"
+#include <QByteArray>
+
+//size and decode time of the json, cbor and msgpack reply encodings.
+//options: --project <project.scan> (can be repeated) to use real projects, --sets/--cameras, --lines, --runs
+class EncodingBenchmark : public Benchmark
+{
+public:
+	QString name() const override { return "encoding"; }
+	QString description() const override { return "json against cbor/msgpack replies, size and decode time"; }
+
+	void run(const QStringList& args) override;
+
+private:
+	void compareProject(const QString& label, const QByteArray& json, int runs);
+	void compareLog(const QByteArray& json, int runs);
+};
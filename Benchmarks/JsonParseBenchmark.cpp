@@ -0,0 +1,91 @@
+#include "JsonParseBenchmark.h"
+#include "SyntheticProject.h"
+#include "ProjectSnapshot.h"
+#include "ReplyReader.h"
+#include "Lib/json.hpp"
+#include <QFile>
+#include <QTextStream>
+
+
+void JsonParseBenchmark::run(const QStringList& args)
+{
+	int runs = argValue(args, "--runs", "10").toInt();
+	QString source = argValue(args, "--project");
+
+	QByteArray details;
+	if (source.isEmpty())
+		details = SyntheticProject::projectJson(1, argValue(args, "--sets", "1000").toInt(), argValue(args, "--cameras", "10").toInt());
+	else
+	{
+		QFile file(source);
+		if (file.open(QIODevice::ReadOnly)) details = file.readAll();
+	}
+	QByteArray projects = SyntheticProject::projectListJson(argValue(args, "--projects", "200").toInt());
+	QByteArray log = SyntheticProject::logJson(argValue(args, "--lines", "20000").toInt());
+
+	QTextStream(stdout) << "  ProjectDetails " << details.size() / 1024 << "KB, getLoadedProjects "
+		<< projects.size() / 1024 << "KB, getRecentLogFile " << log.size() / 1024 << "KB" << endl;
+
+	//ProjectDetails
+	BenchmarkResult domDetails = measure("ProjectDetails (DOM)", runs, [&]() {
+		QString response = QString(details);
+		nlohmann::json result = nlohmann::json::parse(response.toStdString().c_str());
+
+		std::vector<QString> names = std::vector<QString>();
+		nlohmann::json imageSets = result["ImageSets"];
+		for (int i = 0; i < imageSets.size(); ++i)
+		{
+			nlohmann::json imageSetJson = imageSets[i];
+			names.push_back(QString::fromStdString(imageSetJson["path"]));
+
+			nlohmann::json data = imageSetJson["images"];
+			for (int j = 0; j < data.size(); ++j)
+				names.push_back(QString::fromStdString(data[j]["path"]));
+		}
+	});
+	BenchmarkResult streamDetails = measure("ProjectDetails (stream)", runs, [&]() {
+		ProjectSnapshot::parse(details);
+	});
+	compare(domDetails, streamDetails);
+
+	//getLoadedProjects, each element used to be dumped and parsed again
+	BenchmarkResult domProjects = measure("getLoadedProjects (DOM)", runs, [&]() {
+		std::vector<project> list = std::vector<project>();
+		nlohmann::json result = nlohmann::json::parse(projects.toStdString().c_str());
+
+		for (int i = 0; i < result.size(); ++i)
+		{
+			std::string normal = result[i].dump();
+			nlohmann::json jsonProject = nlohmann::json::parse(normal.c_str());
+
+			project instance = project();
+			instance.id = jsonProject.at("Id").get<int>();
+			instance.name = jsonProject.at("Name").get<std::string>();
+			instance.imageCount = jsonProject.at("ImageCount").get<int>();
+			instance.imagesAvaliable = jsonProject.at("SavedCount").get<int>();
+			list.push_back(instance);
+		}
+	});
+	BenchmarkResult streamProjects = measure("getLoadedProjects (stream)", runs, [&]() {
+		std::vector<project> list = std::vector<project>();
+		ReplyReader::readProjects(projects, list);
+	});
+	compare(domProjects, streamProjects);
+
+	//log commands
+	BenchmarkResult domLog = measure("getRecentLogFile (DOM)", runs, [&]() {
+		QStringList lines = QStringList();
+		nlohmann::json j = nlohmann::json::parse(log.toStdString().c_str());
+
+		for (int i = 0; i < j.size(); ++i)
+		{
+			std::string normal = j[i];
+			lines.append(QString(normal.c_str()));
+		}
+	});
+	BenchmarkResult streamLog = measure("getRecentLogFile (stream)", runs, [&]() {
+		QStringList lines = QStringList();
+		ReplyReader::readStrings(log, lines);
+	});
+	compare(domLog, streamLog);
+}
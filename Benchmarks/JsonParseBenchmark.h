@@ -0,0 +1,13 @@
+#pragma once
+#include "Benchmark.h"
+
+//the DOM round trips the replies used to go through against the streaming readers (JsonStream)
+//options: --project <project.scan>, --sets/--cameras, --projects, --lines, --runs
+class JsonParseBenchmark : public Benchmark
+{
+public:
+	QString name() const override { return "json-parse"; }
+	QString description() const override { return "DOM against streaming parsing of scanner replies"; }
+
+	void run(const QStringList& args) override;
+};
@@ -0,0 +1,170 @@
+#include "ProjectSwitchBenchmark.h"
+#include "SyntheticProject.h"
+#include "ProjectSnapshot.h"
+#include "ProjectStore.h"
+#include "ScannerInteraction.h"
+#include "TransferEngine.h"
+#include "Lib/json.hpp"
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <vector>
+#include <map>
+
+//what every consumer did with the parsed document: pull out the set and image names
+static int walkProject(nlohmann::json& json)
+{
+	int images = 0;
+	std::vector<QString> names = std::vector<QString>();
+
+	nlohmann::json imageSets = json["ImageSets"];
+	for (int i = 0; i < imageSets.size(); ++i)
+	{
+		nlohmann::json imageSetJson = imageSets[i];
+		names.push_back(QString::fromStdString(imageSetJson["path"]));
+
+		nlohmann::json data = imageSetJson["images"];
+		for (int j = 0; j < data.size(); ++j)
+			names.push_back(QString::fromStdString(data[j]["path"]));
+		images += data.size();
+	}
+
+	return images;
+}
+
+static QString readText(const QString& path)
+{
+	QString text = "";
+	QFile file(path);
+	if (file.open(QIODevice::ReadOnly))
+		text = file.readAll();
+
+	return text;
+}
+
+void ProjectSwitchBenchmark::run(const QStringList& args)
+{
+	int runs = argValue(args, "--runs", "10").toInt();
+	QString source = argValue(args, "--project");
+
+	QByteArray reply;
+	if (source.isEmpty())
+		reply = SyntheticProject::projectJson(1, argValue(args, "--sets", "1000").toInt(), argValue(args, "--cameras", "10").toInt());
+	else
+	{
+		QFile file(source);
+		if (!file.open(QIODevice::ReadOnly))
+		{
+			QTextStream(stdout) << "  unable to read " << source << endl;
+			return;
+		}
+		reply = file.readAll();
+	}
+
+	//the old flow read project.scan back from the transfer directory
+	QTemporaryDir directory;
+	QString projectFile = directory.path() + "/project.scan";
+	QFile file(projectFile);
+	if (file.open(QIODevice::WriteOnly)) file.write(reply);
+	file.close();
+
+	ProjectSnapshotPtr snapshot = ProjectSnapshot::parse(reply);
+	if (snapshot.isNull())
+	{
+		QTextStream(stdout) << "  project could not be parsed" << endl;
+		return;
+	}
+	QTextStream(stdout) << "  " << snapshot->setCount() << " sets, " << snapshot->imageCount() << " images, "
+		<< reply.size() / 1024 << "KB" << endl;
+
+	BenchmarkResult legacy = measure("switch (parse per consumer)", runs, [&]() { legacySwitch(reply, projectFile); });
+	BenchmarkResult shared = measure("switch (shared snapshot)", runs, [&]() { snapshotSwitch(reply); });
+	compare(legacy, shared);
+
+	//the periodic refresh of the current project almost always returns the same document
+	BenchmarkResult legacyRefresh = measure("refresh (parse per consumer)", runs, [&]() {
+		QString response = QString(reply);
+		nlohmann::json result = nlohmann::json::parse(response.toStdString().c_str());
+		walkProject(result);
+
+		QString jsonText = readText(projectFile);
+		nlohmann::json json = nlohmann::json::parse(jsonText.toStdString().c_str());
+		walkProject(json);
+	});
+
+	//the same reply through the engine: the compare with the last reply, the hand-off of the stored snapshot and
+	//the signals to the consumers that hold it. the connection is never opened so the requests it makes are dropped
+	QTemporaryDir root;
+	ScannerInteraction connection;
+	TransferEngine engine(&connection);
+	ProjectSnapshotPtr held;
+	QObject consumers;
+	QObject::connect(&engine, &TransferEngine::projectChanged, &consumers, [&](QString, ProjectSnapshotPtr update) { held = update; });
+	QObject::connect(&engine, &TransferEngine::projectUpdated, &consumers, [&](QString, ProjectSnapshotPtr update) { held = update; });
+	QObject::connect(&engine, &TransferEngine::setsAppended, &consumers, [&](int) {});
+
+	engine.setTarget(root.path(), snapshot->projectId());
+	engine.respondToScanner(ScannerCommands::ProjectDetails, reply);
+	BenchmarkResult sharedRefresh = measure("refresh (unchanged snapshot)", runs, [&]() {
+		engine.respondToScanner(ScannerCommands::ProjectDetails, reply);
+	});
+	compare(legacyRefresh, sharedRefresh);
+}
+
+//processProjectDetails, CalibrationWindow::projectSelected and CameraCalibrationThread::extractImages
+void ProjectSwitchBenchmark::legacySwitch(const QByteArray& reply, const QString& projectFile) const
+{
+	QString response = QString(reply);
+	nlohmann::json result = nlohmann::json::parse(response.toStdString().c_str());
+	walkProject(result);
+
+	QString calibrationText = readText(projectFile);
+	nlohmann::json calibration = nlohmann::json::parse(calibrationText.toStdString().c_str());
+	walkProject(calibration);
+
+	QString threadText = readText(projectFile);
+	nlohmann::json json = nlohmann::json::parse(threadText.toStdString().c_str());
+	std::map<int, std::vector<QString>> imageLocations = std::map<int, std::vector<QString>>();
+	for (int i = 0; i < json["Cameras"].size(); ++i)
+	{
+		int camId = json["Cameras"][i]["id"];
+		std::vector<QString> paths = std::vector<QString>();
+
+		for (int j = 0; j < json["ImageSets"].size(); ++j)
+		{
+			for (int k = 0; k < json["ImageSets"][j]["images"].size(); ++k)
+			{
+				if (json["ImageSets"][j]["images"][k]["id"] == camId)
+				{
+					paths.push_back(QString::fromStdString(json["ImageSets"][j]["images"][k]["path"]));
+					break;
+				}
+			}
+		}
+
+		imageLocations.emplace(camId, paths);
+	}
+}
+
+void ProjectSwitchBenchmark::snapshotSwitch(const QByteArray& reply) const
+{
+	ProjectSnapshotPtr snapshot = ProjectSnapshot::parse(reply);
+
+	ProjectStore store;
+	store.reset(snapshot);
+
+	std::map<int, std::vector<QString>> imageLocations = std::map<int, std::vector<QString>>();
+	for (int i = 0; i < snapshot->cameraCount(); ++i)
+	{
+		int camId = snapshot->camera(i).id;
+		std::vector<QString> paths = std::vector<QString>();
+
+		for (int j = 0; j < snapshot->setCount(); ++j)
+		{
+			int image = snapshot->findImage(j, camId);
+			if (image >= 0) paths.push_back(snapshot->fileName(image));
+		}
+
+		imageLocations.emplace(camId, paths);
+	}
+}
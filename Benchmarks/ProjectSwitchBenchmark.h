@@ -0,0 +1,19 @@
+#pragma once
+#include "Benchmark.h"
+#include <QByteArray>
+
+//time taken for the tool to take on a project (project details reply to every consumer having the project)
+//compares the old flow, where each consumer parsed project.scan on its own, with the shared ProjectSnapshot.
+//options: --project <project.scan> to use a real project, --sets/--cameras to size the generated one, --runs
+class ProjectSwitchBenchmark : public Benchmark
+{
+public:
+	QString name() const override { return "project-switch"; }
+	QString description() const override { return "parse and distribute a project details reply"; }
+
+	void run(const QStringList& args) override;
+
+private:
+	void legacySwitch(const QByteArray& reply, const QString& projectFile) const;
+	void snapshotSwitch(const QByteArray& reply) const;
+};
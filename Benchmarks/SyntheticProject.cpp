@@ -0,0 +1,69 @@
+#include "SyntheticProject.h"
+#include "Lib/json.hpp"
+
+
+QByteArray SyntheticProject::projectJson(int projectId, int sets, int cameras)
+{
+	nlohmann::json project;
+	project["ProjectId"] = projectId;
+	project["ProjectName"] = "Synthetic " + std::to_string(projectId);
+
+	nlohmann::json cameraList = nlohmann::json::array();
+	for (int i = 0; i < cameras; ++i)
+	{
+		nlohmann::json camera;
+		camera["id"] = i;
+		camera["name"] = "camera" + std::to_string(i);
+		cameraList.push_back(camera);
+	}
+	project["Cameras"] = cameraList;
+
+	nlohmann::json imageSets = nlohmann::json::array();
+	for (int i = 0; i < sets; ++i)
+	{
+		nlohmann::json set;
+		set["id"] = i;
+		set["path"] = "set" + std::to_string(i);
+
+		nlohmann::json images = nlohmann::json::array();
+		for (int j = 0; j < cameras; ++j)
+		{
+			nlohmann::json image;
+			image["id"] = j;
+			image["path"] = "camera" + std::to_string(j) + ".jpg";
+			images.push_back(image);
+		}
+
+		set["images"] = images;
+		imageSets.push_back(set);
+	}
+	project["ImageSets"] = imageSets;
+
+	return QByteArray::fromStdString(project.dump());
+}
+
+QByteArray SyntheticProject::projectListJson(int projects)
+{
+	nlohmann::json list = nlohmann::json::array();
+	for (int i = 0; i < projects; ++i)
+	{
+		nlohmann::json project;
+		project["Id"] = i;
+		project["Name"] = "Project " + std::to_string(i);
+		project["ImageCount"] = 10 * i;
+		project["SavedCount"] = 10 * i;
+		list.push_back(project);
+	}
+
+	return QByteArray::fromStdString(list.dump());
+}
+
+QByteArray SyntheticProject::logJson(int lines)
+{
+	nlohmann::json log = nlohmann::json::array();
+	for (int i = 0; i < lines; ++i)
+		log.push_back("2017-11-0" + std::to_string(i % 9 + 1) + " 12:00:00 [Info] Camera " + std::to_string(i % 10)
+			+ " captured image " + std::to_string(i) + " for set " + std::to_string(i / 10));
+
+	return QByteArray::fromStdString(log.dump());
+}
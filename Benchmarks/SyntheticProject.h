@@ -0,0 +1,14 @@
+#pragma once
+#include <QByteArray>
+
+//builds documents in the same shape as the scanner replies
+class SyntheticProject
+{
+public:
+	//the default is a 10k image project: 1000 sets taken with 10 cameras
+	static QByteArray projectJson(int projectId = 1, int sets = 1000, int cameras = 10);
+	//getLoadedProjects reply
+	static QByteArray projectListJson(int projects);
+	//getRecentLogFile reply
+	static QByteArray logJson(int lines);
+};
@@ -0,0 +1,261 @@
+#include "TransferBenchmark.h"
+#include <QEventLoop>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSemaphore>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QThread>
+#include <QTimer>
+#include <algorithm>
+#include <vector>
+#include "MockScanner.h"
+#include "ScannerInteraction.h"
+#include "ScannerDeviceInformation.h"
+#include "TransferEngine.h"
+#include "ContentStore.h"
+
+static double percentile(const std::vector<double>& sorted, double fraction)
+{
+	if (sorted.empty()) return 0;
+	return sorted[std::min(sorted.size() - 1, size_t(fraction * sorted.size()))];
+}
+
+static QList<int> intList(const QString& text)
+{
+	QList<int> values = QList<int>();
+	QStringList parts = text.split(',', QString::SkipEmptyParts);
+	for (int i = 0; i < parts.size(); ++i)
+		if (parts.at(i).toInt() > 0) values.append(parts.at(i).toInt());
+
+	return values;
+}
+
+void TransferBenchmark::run(const QStringList& args)
+{
+	QList<int> setCounts = intList(argValue(args, "--sets", "10,100,1000"));
+	QList<int> imageSizes = intList(argValue(args, "--image-sizes", "65536,524288,2097152"));
+	int cameras = qMax(1, argValue(args, "--cameras", "4").toInt());
+	qint64 maxTotal = argValue(args, "--max-total", "2147483648").toLongLong();
+	QHostAddress address = QHostAddress(argValue(args, "--address", "127.0.0.1"));
+	double tolerance = argValue(args, "--tolerance", "0.1").toDouble();
+	QString baselinePath = argValue(args, "--baseline");
+	QString savePath = argValue(args, "--save-baseline");
+	QString batchMode = argValue(args, "--batch", "both");
+
+	QList<bool> batchModes = QList<bool>();
+	if (batchMode != "batched") batchModes.append(false);
+	if (batchMode != "single") batchModes.append(true);
+
+	std::sort(setCounts.begin(), setCounts.end());
+	std::sort(imageSizes.begin(), imageSizes.end());
+
+	QJsonObject baseline = QJsonObject();
+	if (!baselinePath.isEmpty())
+	{
+		QFile file(baselinePath);
+		if (file.open(QIODevice::ReadOnly)) baseline = QJsonDocument::fromJson(file.readAll()).object();
+		else QTextStream(stdout) << "  unable to read " << baselinePath << endl;
+	}
+
+	QTextStream out(stdout);
+	QJsonObject saved = QJsonObject();
+	int regressions = 0;
+
+	for (int i = 0; i < setCounts.size(); ++i)
+	{
+		for (int j = 0; j < imageSizes.size(); ++j)
+		{
+			qint64 total = qint64(setCounts.at(i)) * cameras * imageSizes.at(j);
+			if (total > maxTotal)
+			{
+				out << "  " << setCounts.at(i) << "x" << cameras << " @ " << imageSizes.at(j) / 1024
+					<< "KB skipped, " << total / (1024 * 1024) << "MB is over --max-total" << endl;
+				continue;
+			}
+
+			double single = 0;
+			for (int k = 0; k < batchModes.size(); ++k)
+			{
+				CaseResult result = transferCase(address, setCounts.at(i), cameras, imageSizes.at(j), batchModes.at(k));
+				print(result);
+				if (!result.complete) continue;
+
+				if (!batchModes.at(k)) single = result.imagesPerSecond();
+				else if (single > 0)
+					out << "    batched " << QString::number(result.imagesPerSecond() / single, 'f', 2) << "x the images/s of single requests" << endl;
+
+				QJsonObject entry = QJsonObject();
+				entry["imagesPerSecond"] = result.imagesPerSecond();
+				entry["mbPerSecond"] = result.mbPerSecond();
+				entry["p50"] = result.p50;
+				entry["p95"] = result.p95;
+				entry["p99"] = result.p99;
+				saved[result.name] = entry;
+
+				if (!baseline.contains(result.name)) continue;
+
+				double before = baseline[result.name].toObject()["imagesPerSecond"].toDouble();
+				if (before <= 0) continue;
+
+				double change = result.imagesPerSecond() / before - 1;
+				bool regressed = change < -tolerance;
+				if (regressed) regressions++;
+				out << "    " << (regressed ? "REGRESSION" : "baseline") << " " << QString::number(before, 'f', 1)
+					<< " images/s (" << (change >= 0 ? "+" : "") << QString::number(change * 100, 'f', 1) << "%)" << endl;
+			}
+		}
+	}
+
+	if (!baseline.isEmpty())
+		out << "  " << regressions << " regression(s) past " << QString::number(tolerance * 100, 'f', 0) << "%" << endl;
+
+	if (!savePath.isEmpty())
+	{
+		QFile file(savePath);
+		if (file.open(QIODevice::WriteOnly)) file.write(QJsonDocument(saved).toJson());
+		else out << "  unable to write " << savePath << endl;
+	}
+}
+
+TransferBenchmark::CaseResult TransferBenchmark::transferCase(const QHostAddress& address, int sets, int cameras, int imageSize, bool batch) const
+{
+	CaseResult result = CaseResult();
+	result.name = QString::number(sets) + "x" + QString::number(cameras) + " @ " + QString::number(imageSize / 1024) + "KB";
+	if (batch) result.name += " batched";
+
+	//the scanner gets a thread of its own so serving doesn't count against the client
+	QThread serverThread;
+	MockScanner* scanner = new MockScanner("benchmark");
+	scanner->addProject(MockProject::synthetic(1, sets, cameras, imageSize));
+	scanner->moveToThread(&serverThread);
+
+	QSemaphore ready;
+	bool listening = false;
+	QObject::connect(&serverThread, &QThread::started, scanner, [&]() {
+		listening = scanner->start(address, 8472, false);
+		ready.release();
+	});
+	QObject::connect(&serverThread, &QThread::finished, scanner, &QObject::deleteLater);
+	serverThread.start();
+	ready.acquire();
+
+	if (!listening)
+	{
+		QTextStream(stdout) << "  " << result.name << ": unable to listen on " << address.toString() << ":8472" << endl;
+		serverThread.quit();
+		serverThread.wait();
+		return result;
+	}
+
+	//same layout as a scanner session, without the log tail. the content store is the case's own so nothing is
+	//linked from earlier runs instead of transfered
+	QTemporaryDir root;
+	QTemporaryDir store;
+	QString previousStore = ContentStore::root();
+	ContentStore::setRoot(store.path());
+	ScannerDeviceInformation device;
+	device.name = "benchmark";
+	device.address = address;
+
+	QThread clientThread;
+	ScannerInteraction* connection = new ScannerInteraction();
+	TransferEngine* engine = new TransferEngine(connection);
+	engine->setFollowCapture(false);
+	engine->setBatching(batch);
+	connection->moveToThread(&clientThread);
+	clientThread.start();
+
+	QEventLoop loop;
+	QTimer timeout;
+	timeout.setSingleShot(true);
+	QObject::connect(&timeout, &QTimer::timeout, &loop, &QEventLoop::quit);
+	QObject::connect(connection, &ScannerInteraction::scannerConnected, &loop, &QEventLoop::quit);
+
+	timeout.start(5000);
+	connection->connectToScanner(&device);
+	loop.exec();
+
+	if (connection->isConnected())
+	{
+		std::vector<double> latencies = std::vector<double>();
+		latencies.reserve(sets * cameras);
+		QElapsedTimer clock, imageClock;
+
+		QObject::connect(engine, &TransferEngine::projectChanged, &loop, [&]() {
+			if (engine->isTransfering()) return;
+			connection->resetStatistics();
+			engine->resetTimings();
+			result.cpuMs = processCpuTime();
+			clock.start();
+			imageClock.start();
+			engine->start();
+		});
+		//images are pulled one after another, so the gap between two is the whole round trip for one.
+		//batched images arrive together, the round trip is on the first of each batch
+		QObject::connect(engine, &TransferEngine::imageTransfered, &loop, [&]() {
+			latencies.push_back(imageClock.nsecsElapsed() / 1000000.0);
+			imageClock.start();
+			timeout.start(30000);
+		});
+		QObject::connect(engine, &TransferEngine::transferComplete, &loop, [&]() {
+			result.complete = true;
+			loop.quit();
+		});
+		QObject::connect(engine, &TransferEngine::transferError, &loop, &QEventLoop::quit);
+
+		timeout.start(30000);
+		engine->setTarget(root.path(), 1);
+		loop.exec();
+
+		result.seconds = clock.isValid() ? clock.nsecsElapsed() / 1000000000.0 : 0;
+		result.cpuMs = processCpuTime() - result.cpuMs;
+		result.peakMemory = peakMemory();
+
+		std::sort(latencies.begin(), latencies.end());
+		result.p50 = percentile(latencies, 0.5);
+		result.p95 = percentile(latencies, 0.95);
+		result.p99 = percentile(latencies, 0.99);
+
+		TransferTimings timings = engine->timings();
+		CommandStatistics images = connection->statistics().value(int(ScannerCommands::ImageSetImageData));
+		CommandStatistics batches = connection->statistics().value(int(ScannerCommands::ImageSetImageBatch));
+		result.images = int(timings.images);
+		result.bytes = timings.bytes;
+		result.writeMs = timings.writeNs / 1000000.0;
+		result.modelMs = timings.modelNs / 1000000.0;
+		result.framingMs = (images.framingNs + batches.framingNs) / 1000000.0;
+		result.complete = result.complete && result.images == sets * cameras;
+	}
+	else QTextStream(stdout) << "  " << result.name << ": unable to connect to the mock scanner" << endl;
+
+	engine->pause();
+	clientThread.quit();
+	clientThread.wait();
+	delete connection;
+	delete engine;
+
+	serverThread.quit();
+	serverThread.wait();
+	ContentStore::setRoot(previousStore);
+	return result;
+}
+
+void TransferBenchmark::print(const CaseResult& result)
+{
+	QTextStream out(stdout);
+	out << "  " << result.name.leftJustified(20) << (result.complete ? "" : "INCOMPLETE ")
+		<< result.images << " images in " << QString::number(result.seconds, 'f', 2) << "s  "
+		<< QString::number(result.imagesPerSecond(), 'f', 1) << " images/s  "
+		<< QString::number(result.mbPerSecond(), 'f', 1) << "MB/s" << endl;
+	out << "    latency p50 " << QString::number(result.p50, 'f', 2) << "ms  p95 " << QString::number(result.p95, 'f', 2)
+		<< "ms  p99 " << QString::number(result.p99, 'f', 2) << "ms  peak memory " << result.peakMemory / (1024 * 1024) << "MB" << endl;
+
+	//the mock scanner is in the same process, its share is whatever isn't accounted for
+	double other = qMax(0.0, result.cpuMs - result.framingMs - result.writeMs - result.modelMs);
+	out << "    cpu " << QString::number(result.cpuMs, 'f', 0) << "ms: framing " << QString::number(result.framingMs, 'f', 0)
+		<< "ms, file writes " << QString::number(result.writeMs, 'f', 0) << "ms, transfer state "
+		<< QString::number(result.modelMs, 'f', 0) << "ms, mock scanner and other " << QString::number(other, 'f', 0) << "ms" << endl;
+}
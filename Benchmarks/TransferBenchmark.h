@@ -0,0 +1,39 @@
+#pragma once
+#include "Benchmark.h"
+#include <QHostAddress>
+
+//pulls whole projects through ScannerInteraction and TransferEngine from a mock scanner on its own thread,
+//for every combination of set count and image size. reports images/s, MB/s, per image latency percentiles,
+//peak memory and where the time went (framing on the connection thread, file writes, transfer state).
+//every case runs with images asked for one at a time and again batched a set at a time (ImageSetImageBatch).
+//options: --sets 10,100,1000, --cameras, --image-sizes <bytes,...>, --max-total <bytes> to skip huge cases,
+//--batch single|batched|both, --address for the mock (port 8472 has to be free), --save-baseline <file>,
+//--baseline <file>, --tolerance
+class TransferBenchmark : public Benchmark
+{
+public:
+	QString name() const override { return "transfer"; }
+	QString description() const override { return "end to end project transfer from a mock scanner"; }
+
+	void run(const QStringList& args) override;
+
+private:
+	struct CaseResult
+	{
+		QString name;
+		bool complete = false;
+		int images = 0;
+		qint64 bytes = 0;
+		double seconds = 0;
+		double p50 = 0, p95 = 0, p99 = 0; //ms
+		qint64 peakMemory = 0;
+		double cpuMs = 0;
+		double framingMs = 0, writeMs = 0, modelMs = 0;
+
+		double imagesPerSecond() const { return seconds > 0 ? images / seconds : 0; }
+		double mbPerSecond() const { return seconds > 0 ? bytes / seconds / (1024 * 1024) : 0; }
+	};
+
+	CaseResult transferCase(const QHostAddress& address, int sets, int cameras, int imageSize, bool batch) const;
+	static void print(const CaseResult& result);
+};
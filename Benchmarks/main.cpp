@@ -0,0 +1,54 @@
+#include <QCoreApplication>
+#include <QTextStream>
+#include <vector>
+#include "Benchmark.h"
+#include "ProjectSwitchBenchmark.h"
+#include "JsonParseBenchmark.h"
+#include "EncodingBenchmark.h"
+#include "CompressionBenchmark.h"
+#include "TransferBenchmark.h"
+#include "CalibrationBenchmark.h"
+
+//usage: Benchmarks [suite] [suite options]
+//no suite runs every suite with its default options
+int main(int argc, char *argv[])
+{
+	QCoreApplication a(argc, argv);
+	QStringList args = a.arguments().mid(1);
+
+	std::vector<Benchmark*> suites = std::vector<Benchmark*>();
+	suites.push_back(new ProjectSwitchBenchmark());
+	suites.push_back(new JsonParseBenchmark());
+	suites.push_back(new EncodingBenchmark());
+	suites.push_back(new CompressionBenchmark());
+	suites.push_back(new TransferBenchmark());
+	suites.push_back(new CalibrationBenchmark());
+
+	QString selected = args.isEmpty() ? "" : args.takeFirst();
+	QTextStream out(stdout);
+
+	if (selected == "--list" || selected == "-l")
+	{
+		for (int i = 0; i < suites.size(); ++i)
+			out << suites[i]->name().leftJustified(20) << suites[i]->description() << endl;
+	}
+	else
+	{
+		bool found = false;
+		for (int i = 0; i < suites.size(); ++i)
+		{
+			if (!selected.isEmpty() && suites[i]->name() != selected) continue;
+
+			found = true;
+			out << suites[i]->name() << endl;
+			suites[i]->run(args);
+		}
+
+		if (!found) out << "Unknown benchmark suite " << selected << endl;
+	}
+
+	for (int i = 0; i < suites.size(); ++i)
+		delete suites[i];
+
+	return 0;
+}
@@ -0,0 +1,17 @@
+TEMPLATE = app
+CONFIG += console c++11 link_pkgconfig
+CONFIG -= app_bundle
+QT = core network
+PKGCONFIG += opencv
+TARGET = CalibrationCli
+
+INCLUDEPATH += ../ScannerInspectionTool
+LIBS += -L$$OUT_PWD/../ScannerCore -lScannerCore
+PRE_TARGETDEPS += $$OUT_PWD/../ScannerCore/libScannerCore.a
+
+HEADERS += \
+	ProjectCalibration.h
+
+SOURCES += \
+	main.cpp \
+	ProjectCalibration.cpp
@@ -0,0 +1,69 @@
+#include "ProjectCalibration.h"
+#include <QFile>
+#include <cstdio>
+
+
+ProjectCalibration::ProjectCalibration(const QString& projectPath, const std::vector<CameraPair>& fallbackPairs, int threads, bool validate, bool yaml)
+{
+	path = projectPath;
+	pairs = fallbackPairs;
+	this->threads = threads;
+	this->validate = validate;
+	this->yaml = yaml;
+}
+
+ProjectCalibration::~ProjectCalibration()
+{
+}
+
+void ProjectCalibration::run()
+{
+	QFile projectFile(path + "/project.scan");
+	QByteArray data;
+
+	try {
+		if (projectFile.open(QIODevice::ReadOnly))
+		{
+			data = projectFile.readAll();
+			projectFile.close();
+		}
+	}
+	catch (std::exception) {}
+	if (projectFile.isOpen()) projectFile.close();
+
+	//project.scan is always written as json by the transfer
+	ProjectSnapshotPtr project = data.isEmpty() ? ProjectSnapshotPtr() : ProjectSnapshot::parse(data, ReplyEncoding::Json);
+	if (project.isNull())
+	{
+		summary.error = "No readable project.scan";
+		return;
+	}
+	projectId = project->projectId();
+
+	//pairs saved by an earlier calibration win over the ones given on the command line
+	std::vector<CameraPair> saved = std::vector<CameraPair>();
+	if (CalibrationEngine::loadPairs(path, saved) && !saved.empty()) pairs = saved;
+
+	fprintf(stderr, "Calibrating %s\n", qPrintable(path));
+	CalibrationEngine engine(threads);
+	engine.setValidateImages(validate);
+	engine.setWriteYaml(yaml);
+	summary = engine.run(path, project, pairs);
+}
+
+QJsonObject ProjectCalibration::results() const
+{
+	QJsonObject result = QJsonObject();
+	result["path"] = path;
+	result["id"] = projectId;
+	result["status"] = summary.succeeded() ? "complete" : "failed";
+	if (!summary.error.isEmpty()) result["error"] = summary.error;
+	result["validImages"] = summary.validImages;
+	result["invalidImages"] = summary.invalidImages;
+	result["cameras"] = summary.calibratedCameras;
+	result["failedCameras"] = summary.failedCameras;
+	result["pairs"] = summary.calibratedPairs;
+	result["failedPairs"] = summary.failedPairs;
+	result["ms"] = summary.ms;
+	return result;
+}
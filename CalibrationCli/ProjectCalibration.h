@@ -0,0 +1,30 @@
+#pragma once
+#include <qrunnable.h>
+#include <QString>
+#include <QJsonObject>
+#include <vector>
+#include "CalibrationEngine.h"
+
+//calibrates one transferred project directory, several of these run side by side on the batch pool
+class ProjectCalibration : public QRunnable
+{
+public:
+	ProjectCalibration(const QString& projectPath, const std::vector<CameraPair>& fallbackPairs, int threads, bool validate, bool yaml);
+	~ProjectCalibration();
+
+	void run() override;
+
+	//only valid once the task has run
+	bool succeeded() const { return summary.succeeded(); }
+	QJsonObject results() const;
+
+private:
+	QString path;
+	std::vector<CameraPair> pairs;
+	int threads;
+	bool validate;
+	bool yaml;
+
+	int projectId = -1;
+	CalibrationSummary summary;
+};
@@ -0,0 +1,109 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <qthreadpool.h>
+#include <QThread>
+#include <qdir.h>
+#include <QFile>
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <cstdio>
+#include "ProjectCalibration.h"
+#include "ReplyReader.h"
+#include "Trace.h"
+#include "MemoryBudget.h"
+#include "ContentStore.h"
+
+//calibrates transferred projects without the gui and prints the results as json.
+//exit code 0 when every project calibrated, 1 when some did not
+int main(int argc, char *argv[])
+{
+	QCoreApplication a(argc, argv);
+	QCoreApplication::setApplicationName("CalibrationCli");
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Validates the images of transferred projects and calibrates their cameras and camera pairs");
+	parser.addHelpOption();
+	parser.addPositionalArgument("projects", "Project directories written by a transfer (containing project.scan).", "<project>...");
+	parser.addOption(QCommandLineOption("pairs", "Camera pairs (the scanner's CameraPairs reply) for projects without calibration/pairs.json.", "file"));
+	parser.addOption(QCommandLineOption("jobs", "Projects calibrated at the same time, the cores are shared between them.", "n"));
+	parser.addOption(QCommandLineOption("skip-validation", "Use the chessboard points already found instead of searching every image again."));
+	parser.addOption(QCommandLineOption("yaml", "Write a yaml copy of every result next to the json."));
+	parser.addOption(QCommandLineOption("trace", "Record where the time goes and write it as a chrome trace when done.", "file"));
+	parser.addOption(QCommandLineOption("memory-budget", "Megabytes of decoded images held at once, decodes wait for room past it. 0 for no limit.", "MB"));
+	parser.addOption(QCommandLineOption("store", "Content store where validation and calibration results are kept, the one set in the inspection tool by default.", "dir"));
+	parser.process(a);
+
+	QStringList paths = parser.positionalArguments();
+	if (paths.isEmpty())
+	{
+		fprintf(stderr, "No project directories given\n");
+		parser.showHelp(1);
+	}
+
+	std::vector<CameraPair> pairs = std::vector<CameraPair>();
+	if (parser.isSet("pairs"))
+	{
+		QFile pairFile(parser.value("pairs"));
+		if (!pairFile.open(QIODevice::ReadOnly) || !ReplyReader::readCameraPairs(pairFile.readAll(), pairs))
+		{
+			fprintf(stderr, "Can't read camera pairs from %s\n", qPrintable(parser.value("pairs")));
+			return 1;
+		}
+	}
+
+	//every core is used, split evenly between the projects running at once
+	int cores = QThread::idealThreadCount();
+	if (cores < 1) cores = 1;
+	int jobs = parser.isSet("jobs") ? parser.value("jobs").toInt() : qMin(paths.size(), cores);
+	if (jobs < 1) jobs = 1;
+	int threads = qMax(1, cores / jobs);
+
+	if (parser.isSet("trace")) Trace::setEnabled(true);
+	if (parser.isSet("memory-budget"))
+		MemoryBudget::setBudget(MemoryCategory::Decode, parser.value("memory-budget").toLongLong() * 1024 * 1024);
+
+	ContentStore::loadSettings();
+	if (parser.isSet("store")) ContentStore::setRoot(parser.value("store"));
+
+	QThreadPool batch;
+	batch.setMaxThreadCount(jobs);
+	QElapsedTimer clock;
+	clock.start();
+
+	std::vector<ProjectCalibration*> projects = std::vector<ProjectCalibration*>();
+	for (int i = 0; i < paths.size(); ++i)
+	{
+		ProjectCalibration* project = new ProjectCalibration(QDir(paths.at(i)).absolutePath(), pairs, threads,
+			!parser.isSet("skip-validation"), parser.isSet("yaml"));
+		project->setAutoDelete(false);
+		projects.push_back(project);
+		batch.start(project);
+	}
+	batch.waitForDone();
+
+	bool success = true;
+	QJsonArray results = QJsonArray();
+	for (int i = 0; i < projects.size(); ++i)
+	{
+		success &= projects[i]->succeeded();
+		results.append(projects[i]->results());
+		delete projects[i];
+	}
+
+	QJsonObject stats = QJsonObject();
+	stats["projects"] = results;
+	stats["jobs"] = jobs;
+	stats["threadsPerJob"] = threads;
+	stats["ms"] = clock.elapsed();
+
+	QByteArray json = QJsonDocument(stats).toJson(QJsonDocument::Indented);
+	fwrite(json.constData(), 1, json.size(), stdout);
+	fflush(stdout);
+
+	if (parser.isSet("trace") && !Trace::writeChromeJson(parser.value("trace")))
+		fprintf(stderr, "Can't write the trace to %s\n", qPrintable(parser.value("trace")));
+
+	return success ? 0 : 1;
+}
@@ -0,0 +1,6 @@
+# builds the core library and the command line tools with qmake, for machines without visual studio
+TEMPLATE = subdirs
+SUBDIRS = ScannerCore TransferCli CalibrationCli MockScanner ProjectGenerator
+TransferCli.depends = ScannerCore
+CalibrationCli.depends = ScannerCore
+ProjectGenerator.depends = ScannerCore
@@ -0,0 +1,173 @@
+#include "MockConnection.h"
+#include <QTcpSocket>
+#include <QTimer>
+#include <vector>
+#include "ScannerInteraction.h"
+
+
+MockConnection::MockConnection(QTcpSocket* socket, MockScanner* scanner) : QObject(scanner)
+{
+	this->socket = socket;
+	this->scanner = scanner;
+	socket->setParent(this);
+
+	pump = new QTimer(this);
+	connect(pump, &QTimer::timeout, this, &MockConnection::writePending);
+	connect(socket, &QTcpSocket::readyRead, this, &MockConnection::readRequest);
+	connect(socket, &QTcpSocket::disconnected, this, &MockConnection::socketClosed);
+}
+
+MockConnection::~MockConnection()
+{
+}
+
+QString MockConnection::peer() const
+{
+	return socket->peerAddress().toString() + ":" + QString::number(socket->peerPort());
+}
+
+//the client sends one request and waits for its reply, so whatever has arrived is the whole request
+void MockConnection::readRequest()
+{
+	QString request = QString::fromUtf8(socket->readAll());
+	if (request.isEmpty()) return;
+
+	QStringList parts = request.split('&');
+	int command = parts.takeFirst().trimmed().toInt();
+
+	QMap<QString, QString> params = QMap<QString, QString>();
+	for (int i = 0; i < parts.size(); ++i)
+		params.insert(parts.at(i).section('=', 0, 0), parts.at(i).section('=', 1));
+
+	QByteArray reply;
+	if (ScannerCommands(command) == ScannerCommands::ApiVersion)
+	{
+		MockReply version = MockReply();
+		version.data = negotiate(params).toUtf8();
+		reply = encode(command, params, version);
+	}
+	else reply = encode(command, params, scanner->handle(command, params));
+
+	emit scanner->requestHandled(command, reply.size());
+
+	int latency = scanner->getFaults().latency;
+	if (latency > 0) QTimer::singleShot(latency, this, [this, reply]() { queueReply(reply); });
+	else queueReply(reply);
+}
+
+//whatever both sides understand, an older scanner ignores the parameters and just sends its version
+QString MockConnection::negotiate(const QMap<QString, QString>& params)
+{
+	binary = false;
+	compression = false;
+
+	QString reply = "1";
+	if (!scanner->allowsBinary()) return reply;
+
+	QStringList encodings = params.value("encodings").split(',');
+	if (encodings.contains("cbor")) reply += "&encoding=cbor";
+	else if (encodings.contains("msgpack")) reply += "&encoding=msgpack";
+	binary = reply.contains("encoding=");
+
+	if (params.value("compression") == "zlib")
+	{
+		compression = true;
+		reply += "&compression=zlib";
+	}
+
+	return reply;
+}
+
+QByteArray MockConnection::encode(int, const QMap<QString, QString>& params, const MockReply& reply) const
+{
+	QByteArray payload = reply.data;
+	if (reply.structured)
+	{
+		QString encoding = binary ? params.value("encoding") : "json";
+		if (encoding == "cbor" || encoding == "msgpack")
+		{
+			std::vector<uint8_t> data = encoding == "cbor" ? nlohmann::json::to_cbor(reply.document) : nlohmann::json::to_msgpack(reply.document);
+			payload = QByteArray(reinterpret_cast<const char*>(data.data()), int(data.size()));
+		}
+		else payload = QByteArray::fromStdString(reply.document.dump());
+	}
+
+	bool compressed = compression && params.value("compress") == "zlib";
+	if (compressed) payload = qCompress(payload);
+
+	QByteArray header = "Ok:" + QByteArray::number(payload.size()) + (compressed ? ":z>" : ">");
+	return header + payload;
+}
+
+void MockConnection::queueReply(QByteArray reply)
+{
+	const MockFaults& faults = scanner->getFaults();
+
+	replies++;
+	if (faults.disconnectAfter > 0 && replies == faults.disconnectAfter)
+		dropAt = written + (pending.size() - sent) + reply.size() / 2;
+
+	//nothing to shape, straight onto the socket
+	if (faults.bandwidth <= 0 && faults.splitSize <= 0 && dropAt < 0)
+	{
+		written += reply.size();
+		socket->write(reply);
+		return;
+	}
+
+	pending.append(reply);
+	if (pump->isActive()) return;
+
+	budget = 0;
+	pumpClock.start();
+	pump->start(faults.splitSize > 0 ? faults.splitGap : 10);
+	writePending();
+}
+
+void MockConnection::writePending()
+{
+	const MockFaults& faults = scanner->getFaults();
+	qint64 chunk = pending.size() - sent;
+
+	//a token bucket refilled from the time since the last write, at most a tenth of a second can be saved up
+	if (faults.bandwidth > 0)
+	{
+		budget += faults.bandwidth * pumpClock.nsecsElapsed() / 1000000000;
+		pumpClock.restart();
+		budget = qMin(budget, qMax<qint64>(faults.bandwidth / 10, 1));
+		chunk = qMin(chunk, budget);
+	}
+	if (faults.splitSize > 0) chunk = qMin<qint64>(chunk, faults.splitSize);
+	if (dropAt >= 0) chunk = qMin(chunk, dropAt - written);
+
+	if (chunk > 0)
+	{
+		socket->write(pending.constData() + sent, chunk);
+		socket->flush();
+		sent += chunk;
+		written += chunk;
+		budget -= qMin(budget, chunk);
+	}
+
+	if (dropAt >= 0 && written >= dropAt)
+	{
+		//half a reply and then nothing, the client has to notice on its own
+		pump->stop();
+		socket->abort();
+		return;
+	}
+
+	if (sent >= pending.size())
+	{
+		pending.clear();
+		sent = 0;
+		pump->stop();
+	}
+}
+
+void MockConnection::socketClosed()
+{
+	pump->stop();
+	emit scanner->clientDisconnected(peer());
+	deleteLater();
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <QObject>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include "MockScanner.h"
+
+QT_BEGIN_NAMESPACE
+class QTcpSocket;
+class QTimer;
+QT_END_NAMESPACE
+
+//one client of the mock scanner. requests are answered in order, each reply goes through the faults
+//(latency, bandwidth cap, split writes, dropped connection) before it reaches the socket
+class MockConnection : public QObject
+{
+	Q_OBJECT
+
+public:
+	MockConnection(QTcpSocket* socket, MockScanner* scanner);
+	~MockConnection();
+
+	QString peer() const;
+
+	private slots:
+	void readRequest();
+	void writePending();
+	void socketClosed();
+
+private:
+	void queueReply(QByteArray reply);
+	QByteArray encode(int command, const QMap<QString, QString>& params, const MockReply& reply) const;
+	QString negotiate(const QMap<QString, QString>& params);
+
+	QTcpSocket* socket;
+	MockScanner* scanner;
+	QTimer* pump;
+	QElapsedTimer pumpClock;
+
+	QByteArray pending;
+	qint64 sent = 0; //of pending
+	qint64 budget = 0;
+	qint64 written = 0;
+	qint64 dropAt = -1;
+	int replies = 0;
+	bool binary = false;
+	bool compression = false;
+};
@@ -0,0 +1,247 @@
+#include "MockProject.h"
+#include <QFile>
+#include <QCryptographicHash>
+#include <random>
+#include <cstring>
+
+
+MockProject::~MockProject()
+{
+}
+
+MockProject* MockProject::synthetic(int id, int sets, int cameras, int imageBytes)
+{
+	MockProject* project = new MockProject();
+	project->projectId = id;
+	project->projectName = "Mock " + QString::number(id);
+
+	for (int i = 0; i < cameras; ++i)
+		project->cameras.append(MockCamera{ i, "camera" + QString::number(i) });
+
+	//random bytes don't compress, the same as real jpeg data. starts with a jpeg marker so viewers try to open it
+	project->imageData = QByteArray(qMax(imageBytes, 4), Qt::Uninitialized);
+	std::mt19937 random(id);
+	char* data = project->imageData.data();
+	for (int i = 0; i < project->imageData.size(); ++i)
+		data[i] = char(random() & 0xff);
+	data[0] = char(0xff);
+	data[1] = char(0xd8);
+
+	for (int i = 0; i < sets; ++i)
+		project->capture();
+
+	return project;
+}
+
+MockProject* MockProject::load(const QString& directory, int id)
+{
+	QFile projectFile(directory + "/project.scan");
+	QByteArray data;
+
+	try {
+		if (projectFile.open(QIODevice::ReadOnly))
+		{
+			data = projectFile.readAll();
+			projectFile.close();
+		}
+	}
+	catch (std::exception) {}
+	if (projectFile.isOpen()) projectFile.close();
+
+	if (data.isEmpty()) return nullptr;
+
+	nlohmann::json document;
+	try {
+		document = nlohmann::json::parse(data.constData());
+	}
+	catch (std::exception) {
+		return nullptr;
+	}
+
+	MockProject* project = new MockProject();
+	project->directory = directory;
+	project->projectId = id >= 0 ? id : document.value("ProjectId", 0);
+	project->projectName = QString::fromStdString(document.value("ProjectName", std::string("Recorded")));
+
+	nlohmann::json cameras = document.value("Cameras", nlohmann::json::array());
+	for (int i = 0; i < cameras.size(); ++i)
+		project->cameras.append(MockCamera{ cameras[i].value("id", i), QString::fromStdString(cameras[i].value("name", std::string())) });
+
+	nlohmann::json imageSets = document.value("ImageSets", nlohmann::json::array());
+	for (int i = 0; i < imageSets.size(); ++i)
+	{
+		MockSet set = MockSet();
+		set.id = imageSets[i].value("id", i);
+		set.path = QString::fromStdString(imageSets[i].value("path", std::string()));
+
+		nlohmann::json images = imageSets[i].value("images", nlohmann::json::array());
+		for (int j = 0; j < images.size(); ++j)
+			set.images.append(MockImage{ images[j].value("id", j), QString::fromStdString(images[j].value("path", std::string())) });
+
+		project->sets.append(set);
+	}
+
+	//written by a calibration or by ProjectGenerator, in the same shape as the scanner's reply
+	QFile pairFile(directory + "/calibration/pairs.json");
+	try {
+		if (pairFile.open(QIODevice::ReadOnly))
+		{
+			nlohmann::json pairs = nlohmann::json::parse(pairFile.readAll().constData());
+			if (pairs.is_array()) project->pairs = pairs;
+			pairFile.close();
+		}
+	}
+	catch (std::exception) {}
+	if (pairFile.isOpen()) pairFile.close();
+
+	return project;
+}
+
+int MockProject::imageCount() const
+{
+	int count = 0;
+	for (int i = 0; i < sets.size(); ++i)
+		count += sets.at(i).images.size();
+	return count;
+}
+
+nlohmann::json MockProject::details() const
+{
+	nlohmann::json project;
+	project["ProjectId"] = projectId;
+	project["ProjectName"] = projectName.toStdString();
+
+	nlohmann::json cameraList = nlohmann::json::array();
+	for (int i = 0; i < cameras.size(); ++i)
+		cameraList.push_back({ { "id", cameras.at(i).id },{ "name", cameras.at(i).name.toStdString() } });
+	project["Cameras"] = cameraList;
+
+	nlohmann::json setList = nlohmann::json::array();
+	for (int i = 0; i < sets.size(); ++i)
+		setList.push_back(setDetails(sets.at(i).id));
+	project["ImageSets"] = setList;
+
+	return project;
+}
+
+nlohmann::json MockProject::imageSets() const
+{
+	nlohmann::json setList = nlohmann::json::array();
+	for (int i = 0; i < sets.size(); ++i)
+		setList.push_back({ { "id", sets.at(i).id },{ "path", sets.at(i).path.toStdString() } });
+
+	return setList;
+}
+
+nlohmann::json MockProject::setDetails(int setId, bool content) const
+{
+	const MockSet* set = findSet(setId);
+	if (set == nullptr) return nlohmann::json();
+
+	nlohmann::json images = nlohmann::json::array();
+	for (int i = 0; i < set->images.size(); ++i)
+	{
+		const MockImage& image = set->images.at(i);
+		nlohmann::json details = { { "id", image.cameraId },{ "path", image.path.toStdString() } };
+		if (content)
+		{
+			details["size"] = directory.isEmpty() ? imageData.size() : QFile(directory + "/" + set->path + "/" + image.path).size();
+			details["hash"] = hash(set, image).toHex().toStdString();
+		}
+		images.push_back(details);
+	}
+
+	return { { "id", set->id },{ "path", set->path.toStdString() },{ "images", images } };
+}
+
+QByteArray MockProject::hash(const MockSet* set, const MockImage& image) const
+{
+	QString key = set->path + "/" + image.path;
+	if (hashes.contains(key)) return hashes.value(key);
+
+	QCryptographicHash hasher(QCryptographicHash::Sha256);
+	hasher.addData(this->image(set->id, image.cameraId));
+
+	QByteArray result = hasher.result();
+	hashes.insert(key, result);
+	return result;
+}
+
+QByteArray MockProject::image(int setId, int cameraId) const
+{
+	const MockSet* set = findSet(setId);
+	if (set == nullptr) return QByteArray();
+
+	for (int i = 0; i < set->images.size(); ++i)
+	{
+		if (set->images.at(i).cameraId != cameraId) continue;
+		if (directory.isEmpty())
+		{
+			//the set and camera go after the jpeg marker so every image has its own content, like real ones
+			QByteArray data = imageData;
+			if (data.size() >= 6) memcpy(data.data() + 2, &setId, 4);
+			if (data.size() >= 10) memcpy(data.data() + 6, &cameraId, 4);
+			return data;
+		}
+
+		QFile imageFile(directory + "/" + set->path + "/" + set->images.at(i).path);
+		QByteArray data;
+		try {
+			if (imageFile.open(QIODevice::ReadOnly))
+			{
+				data = imageFile.readAll();
+				imageFile.close();
+			}
+		}
+		catch (std::exception) {}
+		if (imageFile.isOpen()) imageFile.close();
+
+		return data;
+	}
+
+	return QByteArray();
+}
+
+QByteArray MockProject::images(int setId, const QList<int>& cameraIds) const
+{
+	const MockSet* set = findSet(setId);
+	if (set == nullptr) return QByteArray();
+
+	QList<int> wanted = cameraIds;
+	if (wanted.isEmpty())
+		for (int i = 0; i < set->images.size(); ++i)
+			wanted.append(set->images.at(i).cameraId);
+
+	QByteArray reply;
+	for (int i = 0; i < wanted.size(); ++i)
+	{
+		QByteArray data = image(setId, wanted.at(i));
+		if (data.isEmpty()) continue;
+
+		reply += QByteArray::number(wanted.at(i)) + ":" + QByteArray::number(data.size()) + ">";
+		reply += data;
+	}
+
+	return reply;
+}
+
+int MockProject::capture()
+{
+	MockSet set = MockSet();
+	set.id = sets.isEmpty() ? 1 : sets.back().id + 1;
+	set.path = "set-" + QString::number(set.id);
+
+	for (int i = 0; i < cameras.size(); ++i)
+		set.images.append(MockImage{ cameras.at(i).id, cameras.at(i).name + ".jpg" });
+
+	sets.append(set);
+	return set.id;
+}
+
+const MockProject::MockSet* MockProject::findSet(int setId) const
+{
+	for (int i = 0; i < sets.size(); ++i)
+		if (sets.at(i).id == setId) return &sets.at(i);
+
+	return nullptr;
+}
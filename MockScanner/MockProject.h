@@ -0,0 +1,77 @@
+#pragma once
+#include <QString>
+#include <QByteArray>
+#include <QList>
+#include <QHash>
+#include "Lib/json.hpp"
+
+//a project served by the mock scanner, either generated or read from a project directory written by a transfer.
+//generated images all share one buffer of random bytes so large projects cost no memory, only the few bytes
+//that make each image different are changed as they are sent
+class MockProject
+{
+public:
+	~MockProject();
+
+	static MockProject* synthetic(int id, int sets, int cameras, int imageBytes);
+	//reads <directory>/project.scan, images are read from disk when asked for. null if it can't be read
+	static MockProject* load(const QString& directory, int id = -1);
+
+	int id() const { return projectId; }
+	QString name() const { return projectName; }
+	void setName(const QString& name) { projectName = name; }
+	int setCount() const { return sets.size(); }
+	int cameraCount() const { return cameras.size(); }
+	int imageCount() const;
+
+	//ProjectDetails reply, the same document as project.scan
+	nlohmann::json details() const;
+	//getAllImageSets reply
+	nlohmann::json imageSets() const;
+	//a set of the ProjectDetails reply, null if there is no such set.
+	//the ImageSetMetaData reply also has the size and sha-256 hash of every image so clients can verify their copies
+	nlohmann::json setDetails(int setId, bool content = false) const;
+	//empty if there is no such image
+	QByteArray image(int setId, int cameraId) const;
+	//ImageSetImageBatch reply, every image framed as "<camera id>:<size>>" then its data. all of the set's images when
+	//no cameras are given, cameras the set doesn't have are left out. empty if there is no such set
+	QByteArray images(int setId, const QList<int>& cameraIds) const;
+	//CameraPairs reply from the project's calibration/pairs.json, empty for generated projects
+	const nlohmann::json& cameraPairs() const { return pairs; }
+
+	//adds a set with an image from every camera, like a capture on the scanner
+	int capture();
+
+private:
+	struct MockImage
+	{
+		int cameraId;
+		QString path;
+	};
+
+	struct MockSet
+	{
+		int id;
+		QString path;
+		QList<MockImage> images;
+	};
+
+	struct MockCamera
+	{
+		int id;
+		QString name;
+	};
+
+	MockProject() {}
+	const MockSet* findSet(int setId) const;
+	QByteArray hash(const MockSet* set, const MockImage& image) const;
+
+	int projectId = 0;
+	QString projectName;
+	QString directory; //empty for generated projects
+	QByteArray imageData;
+	QList<MockCamera> cameras;
+	QList<MockSet> sets;
+	mutable QHash<QString, QByteArray> hashes; //image files don't change once written
+	nlohmann::json pairs = nlohmann::json::array();
+};
@@ -0,0 +1,266 @@
+#include "MockScanner.h"
+#include <QTcpServer>
+#include <QUdpSocket>
+#include <QNetworkDatagram>
+#include <QTimer>
+#include <QDateTime>
+#include "MockConnection.h"
+#include "ScannerInteraction.h"
+
+
+MockScanner::MockScanner(const QString& name, QObject* parent) : QObject(parent)
+{
+	scannerName = name;
+
+	server = new QTcpServer(this);
+	discoverySocket = new QUdpSocket(this);
+	replySocket = new QUdpSocket(this);
+	captureTimer = new QTimer(this);
+
+	connect(server, &QTcpServer::newConnection, this, &MockScanner::newConnection);
+	connect(discoverySocket, &QUdpSocket::readyRead, this, &MockScanner::discoveryRequest);
+	connect(captureTimer, &QTimer::timeout, this, &MockScanner::captureSet);
+}
+
+MockScanner::~MockScanner()
+{
+	for (int i = 0; i < projects.size(); ++i)
+		delete projects.at(i);
+	projects.clear();
+}
+
+void MockScanner::addProject(MockProject* project)
+{
+	if (project == nullptr) return;
+
+	projects.append(project);
+	if (currentProject < 0) currentProject = project->id();
+}
+
+void MockScanner::setCaptureInterval(int ms)
+{
+	if (ms > 0) captureTimer->start(ms);
+	else captureTimer->stop();
+}
+
+bool MockScanner::start(const QHostAddress& address, quint16 port, bool discovery)
+{
+	this->address = address;
+	if (!server->listen(address, port)) return false;
+	if (!discovery) return true;
+
+	//several mock scanners on different loopback addresses can share the broadcast port
+	if (!discoverySocket->bind(QHostAddress::AnyIPv4, discoveryPort, QUdpSocket::ShareAddress | QUdpSocket::ReuseAddressHint))
+		return false;
+
+	//replies have to come from the scanner's own address, the client connects to whoever answered
+	QHostAddress replyAddress = address == QHostAddress::Any ? QHostAddress(QHostAddress::AnyIPv4) : address;
+	return replySocket->bind(replyAddress, 0);
+}
+
+quint16 MockScanner::port() const
+{
+	return server->serverPort();
+}
+
+void MockScanner::newConnection()
+{
+	while (server->hasPendingConnections())
+	{
+		MockConnection* client = new MockConnection(server->nextPendingConnection(), this);
+		emit clientConnected(client->peer());
+	}
+}
+
+void MockScanner::discoveryRequest()
+{
+	while (discoverySocket->hasPendingDatagrams())
+	{
+		QNetworkDatagram request = discoverySocket->receiveDatagram();
+		if (request.data() != discoveryMessage) continue;
+
+		replySocket->writeDatagram(scannerName.toUtf8(), request.senderAddress(), replyPort);
+	}
+}
+
+void MockScanner::captureSet()
+{
+	MockProject* project = findProject(currentProject);
+	if (project != nullptr) project->capture();
+}
+
+MockReply MockScanner::handle(int command, const QMap<QString, QString>& params)
+{
+	int id = params.value("id", "-1").toInt();
+
+	switch (ScannerCommands(command))
+	{
+	case ScannerCommands::ApiCompatability:
+		return text("1");
+	case ScannerCommands::setName:
+		if (params.value("name").isEmpty()) return fail("No name given");
+		scannerName = params.value("name");
+		return text("Ok");
+	case ScannerCommands::getRecentLogFile:
+	{
+		MockReply reply = MockReply();
+		reply.structured = true;
+		reply.document = logLines(200);
+		return reply;
+	}
+	case ScannerCommands::getRecentLogDiff:
+	{
+		MockReply reply = MockReply();
+		reply.structured = true;
+		reply.document = logLines(logLine % 3 + 1);
+		return reply;
+	}
+	case ScannerCommands::getLoadedProjects:
+	{
+		MockReply reply = MockReply();
+		reply.structured = true;
+		reply.document = nlohmann::json::array();
+		for (int i = 0; i < projects.size(); ++i)
+		{
+			MockProject* project = projects.at(i);
+			reply.document.push_back({ { "Id", project->id() },{ "Name", project->name().toStdString() },
+				{ "ImageCount", project->imageCount() },{ "SavedCount", project->imageCount() } });
+		}
+		return reply;
+	}
+	case ScannerCommands::CameraPairs:
+	{
+		//the project's own pairs if it has them, otherwise neighbouring cameras make up a pair
+		MockProject* project = findProject(currentProject);
+		MockReply reply = MockReply();
+		reply.structured = true;
+		reply.document = nlohmann::json::array();
+		if (project != nullptr && !project->cameraPairs().empty())
+		{
+			reply.document = project->cameraPairs();
+			return reply;
+		}
+		for (int i = 0; project != nullptr && i + 1 < project->cameraCount(); i += 2)
+			reply.document.push_back({ { "pairId", i / 2 },{ "LeftCamera", i },{ "RightCamera", i + 1 } });
+		return reply;
+	}
+	case ScannerCommands::getCameraPairConfiguration:
+		if (!pairConfigs.contains(id)) return fail("No configuration for pair " + QString::number(id));
+		return text(pairConfigs.value(id));
+	case ScannerCommands::setCameraPairConfiguration:
+		pairConfigs.insert(id, params.value("config"));
+		return text("Ok");
+	case ScannerCommands::getCapacity:
+		return text("1099511627776");
+	case ScannerCommands::CaptureImageSet:
+	{
+		MockProject* project = findProject(currentProject);
+		if (project == nullptr) return fail("No project to capture into");
+		return text(QString::number(project->capture()));
+	}
+	case ScannerCommands::RemoveProject:
+	{
+		MockProject* project = findProject(id);
+		if (project == nullptr) return fail("Unknown project");
+		projects.removeOne(project);
+		delete project;
+		if (currentProject == id) currentProject = projects.isEmpty() ? -1 : projects.first()->id();
+		return text("Ok");
+	}
+	case ScannerCommands::getAllImageSets:
+	{
+		MockProject* project = findProject(id);
+		if (project == nullptr) return fail("Unknown project");
+		MockReply reply = MockReply();
+		reply.structured = true;
+		reply.document = project->imageSets();
+		return reply;
+	}
+	case ScannerCommands::ImageSetMetaData:
+	{
+		MockProject* project = findProject(id);
+		if (project == nullptr) return fail("Unknown project");
+		MockReply reply = MockReply();
+		reply.structured = true;
+		reply.document = project->setDetails(params.value("set").toInt(), true);
+		if (reply.document.is_null()) return fail("Unknown image set");
+		return reply;
+	}
+	case ScannerCommands::ImageSetImageData:
+	{
+		MockProject* project = findProject(id);
+		if (project == nullptr) return fail("Unknown project");
+		MockReply reply = MockReply();
+		reply.data = project->image(params.value("set").toInt(), params.value("image").toInt());
+		if (reply.data.isEmpty()) return fail("Unknown image");
+		return reply;
+	}
+	case ScannerCommands::ImageSetImageBatch:
+	{
+		if (jsonOnly) return fail("Unknown command " + QString::number(command));
+		MockProject* project = findProject(id);
+		if (project == nullptr) return fail("Unknown project");
+
+		QList<int> cameraIds = QList<int>();
+		QStringList images = params.value("images").split(',', QString::SkipEmptyParts);
+		for (int i = 0; i < images.size(); ++i)
+			cameraIds.append(images.at(i).toInt());
+
+		MockReply reply = MockReply();
+		reply.data = project->images(params.value("set").toInt(), cameraIds);
+		if (reply.data.isEmpty()) return fail("Unknown image set");
+		return reply;
+	}
+	case ScannerCommands::ProjectDetails:
+	{
+		MockProject* project = findProject(id);
+		if (project == nullptr) return fail("Unknown project");
+		MockReply reply = MockReply();
+		reply.structured = true;
+		reply.document = project->details();
+		return reply;
+	}
+	case ScannerCommands::CurrentProject:
+		return text(QString::number(currentProject));
+	case ScannerCommands::setProjectNiceName:
+	{
+		MockProject* project = findProject(id);
+		if (project == nullptr) return fail("Unknown project");
+		project->setName(params.value("name"));
+		return text("Ok");
+	}
+	default:
+		return fail("Unknown command " + QString::number(command));
+	}
+}
+
+MockProject* MockScanner::findProject(int id) const
+{
+	for (int i = 0; i < projects.size(); ++i)
+		if (projects.at(i)->id() == id) return projects.at(i);
+
+	return nullptr;
+}
+
+MockReply MockScanner::fail(const QString& message)
+{
+	return text("Fail?" + message);
+}
+
+MockReply MockScanner::text(const QString& reply)
+{
+	MockReply result = MockReply();
+	result.data = reply.toUtf8();
+	return result;
+}
+
+nlohmann::json MockScanner::logLines(int count)
+{
+	QString time = QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss");
+
+	nlohmann::json lines = nlohmann::json::array();
+	for (int i = 0; i < count; ++i, ++logLine)
+		lines.push_back((time + " [Info] Camera " + QString::number(logLine % 10) + " heartbeat " + QString::number(logLine)).toStdString());
+
+	return lines;
+}
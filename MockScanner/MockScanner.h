@@ -0,0 +1,94 @@
+#pragma once
+#include <QObject>
+#include <QList>
+#include <QMap>
+#include <QStringList>
+#include <QHostAddress>
+#include "MockProject.h"
+
+QT_BEGIN_NAMESPACE
+class QTcpServer;
+class QUdpSocket;
+class QTimer;
+QT_END_NAMESPACE
+
+//faults put between the mock scanner and the client, all off by default
+struct MockFaults
+{
+	int latency = 0; //ms before every reply starts
+	qint64 bandwidth = 0; //bytes per second, 0 for no cap
+	int splitSize = 0; //replies are written in pieces of this many bytes, 0 for one write
+	int splitGap = 1; //ms between pieces
+	int disconnectAfter = 0; //the connection is dropped half way through this reply, 0 to never drop
+};
+
+//reply to one request before it is encoded
+struct MockReply
+{
+	bool structured = false; //document is sent in the agreed encoding, otherwise data is sent as it is
+	nlohmann::json document;
+	QByteArray data;
+};
+
+//stands in for a MultiCapture scanner: answers discovery broadcasts and serves the command set over tcp
+//from generated or recorded projects, with optional faults on the link. everything runs on one thread
+class MockScanner : public QObject
+{
+	Q_OBJECT
+
+public:
+	MockScanner(const QString& name, QObject* parent = Q_NULLPTR);
+	~MockScanner();
+
+	//takes ownership, the first project added is the current one
+	void addProject(MockProject* project);
+	void setFaults(const MockFaults& faults) { this->faults = faults; }
+	const MockFaults& getFaults() const { return faults; }
+	//refuse binary encodings, compression and batched images, like an older scanner
+	void setJsonOnly(bool jsonOnly) { this->jsonOnly = jsonOnly; }
+	//capture a set into the current project every interval, 0 to stop
+	void setCaptureInterval(int ms);
+
+	//false if the ports couldn't be bound
+	bool start(const QHostAddress& address = QHostAddress::Any, quint16 port = 8472, bool discovery = true);
+	quint16 port() const;
+	QString name() const { return scannerName; }
+
+	MockReply handle(int command, const QMap<QString, QString>& params);
+	bool allowsBinary() const { return !jsonOnly; }
+
+	signals:
+	void clientConnected(QString address);
+	void clientDisconnected(QString address);
+	void requestHandled(int command, qint64 bytes);
+
+	private slots:
+	void newConnection();
+	void discoveryRequest();
+	void captureSet();
+
+private:
+	MockProject* findProject(int id) const;
+	static MockReply fail(const QString& message);
+	static MockReply text(const QString& reply);
+	nlohmann::json logLines(int count);
+
+	QString scannerName;
+	QList<MockProject*> projects;
+	int currentProject = -1;
+	QMap<int, QString> pairConfigs;
+	int logLine = 0;
+
+	MockFaults faults;
+	bool jsonOnly = false;
+
+	QHostAddress address;
+	QTcpServer* server;
+	QUdpSocket* discoverySocket;
+	QUdpSocket* replySocket;
+	QTimer* captureTimer;
+
+	const QByteArray discoveryMessage = "InspectionApp";
+	const quint16 discoveryPort = 8470;
+	const quint16 replyPort = 8471;
+};
@@ -0,0 +1,18 @@
+TEMPLATE = app
+CONFIG += console c++11
+CONFIG -= app_bundle
+QT = core network
+TARGET = MockScanner
+
+INCLUDEPATH += ../ScannerInspectionTool
+
+HEADERS += \
+	MockConnection.h \
+	MockProject.h \
+	MockScanner.h
+
+SOURCES += \
+	main.cpp \
+	MockConnection.cpp \
+	MockProject.cpp \
+	MockScanner.cpp
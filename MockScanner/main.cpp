@@ -0,0 +1,88 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QHostAddress>
+#include <cstdio>
+#include "MockScanner.h"
+
+//stands in for a scanner on the local machine so transfers can be benchmarked and tried without hardware.
+//a scanner listens on a fixed port, so several mocks on one machine need their own loopback address each
+int main(int argc, char *argv[])
+{
+	QCoreApplication a(argc, argv);
+	QCoreApplication::setApplicationName("MockScanner");
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Serves generated or recorded projects the way a scanner does");
+	parser.addHelpOption();
+	parser.addOption(QCommandLineOption("name", "Name given to discovery requests.", "name", "MockScanner"));
+	parser.addOption(QCommandLineOption("address", "Address to listen on, e.g. 127.0.0.2 for a second mock.", "address", "0.0.0.0"));
+	parser.addOption(QCommandLineOption("port", "Tcp port for requests.", "port", "8472"));
+	parser.addOption(QCommandLineOption("no-discovery", "Don't answer discovery broadcasts."));
+	parser.addOption(QCommandLineOption("project", "Project directory (with a project.scan) to serve, can be repeated.", "dir"));
+	parser.addOption(QCommandLineOption("projects", "Number of generated projects.", "n", "1"));
+	parser.addOption(QCommandLineOption("sets", "Image sets in each generated project.", "n", "20"));
+	parser.addOption(QCommandLineOption("cameras", "Cameras in each generated project.", "n", "8"));
+	parser.addOption(QCommandLineOption("image-size", "Bytes in each generated image.", "bytes", "2000000"));
+	parser.addOption(QCommandLineOption("capture-every", "Capture a new set into the current project every so many ms.", "ms", "0"));
+	parser.addOption(QCommandLineOption("json-only", "Refuse binary encodings, compression and batched images, like an older scanner."));
+	parser.addOption(QCommandLineOption("latency", "Milliseconds before every reply.", "ms", "0"));
+	parser.addOption(QCommandLineOption("bandwidth", "Cap on bytes per second sent to each client.", "bytes", "0"));
+	parser.addOption(QCommandLineOption("split", "Write replies in pieces of this many bytes.", "bytes", "0"));
+	parser.addOption(QCommandLineOption("split-gap", "Milliseconds between split pieces.", "ms", "1"));
+	parser.addOption(QCommandLineOption("disconnect-after", "Drop the connection half way through this reply.", "n", "0"));
+	parser.process(a);
+
+	QHostAddress address;
+	if (!address.setAddress(parser.value("address")))
+	{
+		fprintf(stderr, "Invalid address: %s\n", qPrintable(parser.value("address")));
+		return 1;
+	}
+
+	MockScanner scanner(parser.value("name"));
+
+	QStringList directories = parser.values("project");
+	for (int i = 0; i < directories.size(); ++i)
+	{
+		MockProject* project = MockProject::load(directories.at(i));
+		if (project == nullptr)
+		{
+			fprintf(stderr, "Couldn't read project: %s\n", qPrintable(directories.at(i)));
+			return 1;
+		}
+		scanner.addProject(project);
+	}
+
+	//generated projects are only used when nothing was recorded
+	if (directories.isEmpty())
+	{
+		int count = parser.value("projects").toInt();
+		int sets = qMax(0, parser.value("sets").toInt());
+		int cameras = qMax(1, parser.value("cameras").toInt());
+		int imageSize = qMax(16, parser.value("image-size").toInt());
+		for (int i = 0; i < count; ++i)
+			scanner.addProject(MockProject::synthetic(i, sets, cameras, imageSize));
+	}
+
+	MockFaults faults = MockFaults();
+	faults.latency = qMax(0, parser.value("latency").toInt());
+	faults.bandwidth = qMax<qint64>(0, parser.value("bandwidth").toLongLong());
+	faults.splitSize = qMax(0, parser.value("split").toInt());
+	faults.splitGap = qMax(1, parser.value("split-gap").toInt());
+	faults.disconnectAfter = qMax(0, parser.value("disconnect-after").toInt());
+	scanner.setFaults(faults);
+	scanner.setJsonOnly(parser.isSet("json-only"));
+	scanner.setCaptureInterval(parser.value("capture-every").toInt());
+
+	if (!scanner.start(address, quint16(parser.value("port").toUInt()), !parser.isSet("no-discovery")))
+	{
+		fprintf(stderr, "Couldn't listen on %s:%s\n", qPrintable(address.toString()), qPrintable(parser.value("port")));
+		return 1;
+	}
+
+	QObject::connect(&scanner, &MockScanner::clientConnected, [](QString client) { fprintf(stderr, "connected %s\n", qPrintable(client)); });
+	QObject::connect(&scanner, &MockScanner::clientDisconnected, [](QString client) { fprintf(stderr, "disconnected %s\n", qPrintable(client)); });
+	fprintf(stderr, "%s listening on %s:%d\n", qPrintable(scanner.name()), qPrintable(address.toString()), scanner.port());
+
+	return a.exec();
+}
@@ -0,0 +1,319 @@
+#include "SyntheticChessboard.h"
+#include <qdir.h>
+#include <QFile>
+#include <cmath>
+#include <opencv2/calib3d.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+#include "CalibrationEngine.h"
+#include "Lib/json.hpp"
+
+const int SyntheticChessboard::boardWidth;
+const int SyntheticChessboard::boardHeight;
+const float SyntheticChessboard::squareSize = 24.23f;
+
+template<int rows, int cols>
+static nlohmann::json toJson(const cv::Matx<double, rows, cols>& matrix)
+{
+	nlohmann::json values = nlohmann::json::array();
+	for (int i = 0; i < rows * cols; ++i)
+		values.push_back(matrix.val[i]);
+
+	return values;
+}
+
+SyntheticChessboard::SyntheticChessboard(const GeneratorOptions& options) : random(options.seed)
+{
+	this->options = options;
+	const cv::Size& size = options.imageSize;
+	double focal = options.focal > 0 ? options.focal : size.width * 0.85;
+	double spread = options.variation;
+
+	for (int i = 0; i < options.cameras; ++i)
+	{
+		VirtualCamera camera = VirtualCamera();
+		camera.id = i;
+		camera.name = "camera" + std::to_string(i);
+
+		double fx = focal * (1 + random.uniform(-spread, spread));
+		double fy = fx * (1 + random.uniform(-spread, spread) / 10);
+		double cx = (size.width - 1) / 2.0 + random.uniform(-spread, spread) * size.width;
+		double cy = (size.height - 1) / 2.0 + random.uniform(-spread, spread) * size.height;
+		camera.K = cv::Matx33d(fx, 0, cx, 0, fy, cy, 0, 0, 1);
+		camera.D = options.distortion * (1 + random.uniform(-spread, spread) * 5);
+
+		//the left camera of a pair is where the pair's poses are measured from
+		camera.R = cv::Matx33d::eye();
+		camera.T = cv::Vec3d(0, 0, 0);
+		if (i % 2 == 1)
+		{
+			cv::Vec3d rotation = cv::Vec3d(random.uniform(-spread, spread), options.toeIn * (1 + random.uniform(-spread, spread)), random.uniform(-spread, spread));
+			cv::Rodrigues(rotation, camera.R);
+			camera.T = cv::Vec3d(-options.baseline * (1 + random.uniform(-spread, spread)),
+				options.baseline * random.uniform(-spread, spread), options.baseline * random.uniform(-spread, spread));
+
+			VirtualPair pair = VirtualPair();
+			pair.id = i / 2;
+			pair.left = i - 1;
+			pair.right = i;
+			pairs.push_back(pair);
+		}
+
+		cameras.push_back(camera);
+	}
+
+	//10x7 squares around the inner corners and a square of white border outside them
+	int width = int((boardWidth + 3) * squareSize * textureScale);
+	int height = int((boardHeight + 3) * squareSize * textureScale);
+	texture = cv::Mat(height, width, CV_8UC1, cv::Scalar(220));
+
+	for (int y = 0; y < height; ++y)
+	{
+		uchar* row = texture.ptr<uchar>(y);
+		int square = int(floor(y / textureScale / squareSize)) - 1;
+		if (square < 0 || square > boardHeight) continue;
+
+		for (int x = 0; x < width; ++x)
+		{
+			int column = int(floor(x / textureScale / squareSize)) - 1;
+			if (column < 0 || column > boardWidth) continue;
+			if ((column + square) % 2 == 0) row[x] = 25;
+		}
+	}
+}
+
+void SyntheticChessboard::pairTruth(const VirtualPair& pair, cv::Matx33d& R, cv::Vec3d& T) const
+{
+	const VirtualCamera& left = cameras[pair.left];
+	const VirtualCamera& right = cameras[pair.right];
+
+	R = right.R * left.R.t();
+	T = right.T - R * left.T;
+}
+
+cv::Mat SyntheticChessboard::render(int camera, const cv::Matx33d& R, const cv::Vec3d& t)
+{
+	//every pixel's ray is followed back onto the board, which takes care of the distortion. the tilt is
+	//kept small enough that no ray in view meets the board's plane behind the camera
+	cv::Matx33d plane = cv::Matx33d(R(0, 0), R(0, 1), t[0], R(1, 0), R(1, 1), t[1], R(2, 0), R(2, 1), t[2]);
+	double offset = -2 * squareSize;
+	cv::Matx33d board = cv::Matx33d(1 / textureScale, 0, offset, 0, 1 / textureScale, offset, 0, 0, 1);
+	cv::Matx33d rayToTexture = (plane * board).inv();
+
+	cv::Mat coordinates;
+	cv::perspectiveTransform(cameraRays(camera), coordinates, cv::Mat(rayToTexture));
+
+	//drawn at twice the size and averaged down so the edges are anti aliased
+	cv::Mat large;
+	cv::remap(texture, large, coordinates, cv::noArray(), cv::INTER_LINEAR, cv::BORDER_CONSTANT, cv::Scalar(90));
+
+	cv::Mat image;
+	cv::resize(large, image, options.imageSize, 0, 0, cv::INTER_AREA);
+
+	if (options.noise > 0)
+	{
+		cv::Mat noise = cv::Mat(image.size(), CV_16SC1);
+		random.fill(noise, cv::RNG::NORMAL, cv::Scalar(0), cv::Scalar(options.noise));
+		image.convertTo(image, CV_16SC1);
+		image += noise;
+		image.convertTo(image, CV_8UC1);
+	}
+
+	cv::Mat colour;
+	cv::cvtColor(image, colour, cv::COLOR_GRAY2BGR);
+	return colour;
+}
+
+const cv::Mat& SyntheticChessboard::cameraRays(int camera)
+{
+	if (camera == rayCamera) return rays;
+
+	//pixel x of the final image covers 2x and 2x+1 of the large one
+	cv::Size large = options.imageSize * 2;
+	cv::Mat pixels = cv::Mat(large.area(), 1, CV_32FC2);
+	cv::Vec2f* pixel = pixels.ptr<cv::Vec2f>();
+	for (int y = 0; y < large.height; ++y)
+		for (int x = 0; x < large.width; ++x)
+			*pixel++ = cv::Vec2f((x - 0.5f) / 2, (y - 0.5f) / 2);
+
+	cv::undistortPoints(pixels, rays, cv::Mat(cameras[camera].K), cv::Mat(cameras[camera].D));
+	rays = rays.reshape(2, large.height);
+	rayCamera = camera;
+	return rays;
+}
+
+bool SyntheticChessboard::writeProject(const QString& directory, int sets, int projectId)
+{
+	if (!QDir().mkpath(directory + "/calibration")) return false;
+
+	std::vector<int> quality = std::vector<int>();
+	quality.push_back(cv::IMWRITE_JPEG_QUALITY);
+	quality.push_back(options.quality);
+
+	//poses[set][camera], a camera without a pair sees the board on its own
+	std::vector<std::vector<std::pair<cv::Matx33d, cv::Vec3d>>> poses =
+		std::vector<std::vector<std::pair<cv::Matx33d, cv::Vec3d>>>(sets, std::vector<std::pair<cv::Matx33d, cv::Vec3d>>(cameras.size()));
+	for (int i = 0; i < sets; ++i)
+	{
+		for (int j = 0; j < cameras.size(); j += 2)
+		{
+			VirtualPair group = VirtualPair();
+			group.left = j;
+			group.right = j + 1 < cameras.size() ? j + 1 : j;
+
+			cv::Matx33d R;
+			cv::Vec3d t;
+			randomPose(group, R, t);
+			poses[i][j] = std::make_pair(R, t);
+			if (group.right != j)
+				poses[i][group.right] = std::make_pair(cameras[group.right].R * R, cameras[group.right].R * t + cameras[group.right].T);
+		}
+	}
+
+	//camera by camera so the rays are only worked out once for each
+	for (int j = 0; j < cameras.size(); ++j)
+	{
+		for (int i = 0; i < sets; ++i)
+		{
+			QString setPath = directory + "/set-" + QString::number(i + 1);
+			if (!QDir().mkpath(setPath)) return false;
+
+			cv::Mat image = render(j, poses[i][j].first, poses[i][j].second);
+			QString path = setPath + "/" + QString::fromStdString(cameras[j].name) + ".jpg";
+			if (!cv::imwrite(path.toStdString(), image, quality)) return false;
+		}
+	}
+
+	//the stereo task matches sets by a "set-<n>" name counted from 1
+	nlohmann::json project;
+	project["ProjectId"] = projectId;
+	project["ProjectName"] = "Synthetic chessboard";
+
+	nlohmann::json truth;
+	truth["imageSize"] = { options.imageSize.width, options.imageSize.height };
+	truth["squareSize"] = squareSize;
+	truth["board"] = { boardWidth, boardHeight };
+
+	nlohmann::json cameraList = nlohmann::json::array();
+	nlohmann::json cameraTruth = nlohmann::json::array();
+	for (int j = 0; j < cameras.size(); ++j)
+	{
+		cameraList.push_back({ { "id", cameras[j].id },{ "name", cameras[j].name } });
+		cameraTruth.push_back({ { "id", cameras[j].id },{ "name", cameras[j].name },{ "K", toJson(cameras[j].K) },{ "D", toJson(cameras[j].D) } });
+	}
+	project["Cameras"] = cameraList;
+	truth["Cameras"] = cameraTruth;
+
+	std::vector<CameraPair> cameraPairs = std::vector<CameraPair>();
+	nlohmann::json pairTruths = nlohmann::json::array();
+	for (int i = 0; i < pairs.size(); ++i)
+	{
+		CameraPair pair = CameraPair();
+		pair.id = pairs[i].id;
+		pair.leftId = cameras[pairs[i].left].id;
+		pair.rightId = cameras[pairs[i].right].id;
+		cameraPairs.push_back(pair);
+
+		cv::Matx33d R;
+		cv::Vec3d T;
+		pairTruth(pairs[i], R, T);
+		pairTruths.push_back({ { "pairId", pair.id },{ "LeftCamera", pair.leftId },{ "RightCamera", pair.rightId },
+			{ "R", toJson(R) },{ "T", { T[0], T[1], T[2] } } });
+	}
+	truth["Pairs"] = pairTruths;
+
+	nlohmann::json imageSets = nlohmann::json::array();
+	nlohmann::json poseTruth = nlohmann::json::array();
+	for (int i = 0; i < sets; ++i)
+	{
+		std::string setName = "set-" + std::to_string(i + 1);
+		nlohmann::json images = nlohmann::json::array();
+		nlohmann::json setPoses = nlohmann::json::array();
+
+		for (int j = 0; j < cameras.size(); ++j)
+		{
+			images.push_back({ { "id", cameras[j].id },{ "path", cameras[j].name + ".jpg" } });
+
+			cv::Vec3d rotation;
+			cv::Rodrigues(poses[i][j].first, rotation);
+			const cv::Vec3d& t = poses[i][j].second;
+			setPoses.push_back({ { "camera", cameras[j].id },{ "rvec", { rotation[0], rotation[1], rotation[2] } },{ "tvec", { t[0], t[1], t[2] } } });
+		}
+
+		imageSets.push_back({ { "id", i + 1 },{ "path", setName },{ "images", images } });
+		poseTruth.push_back({ { "set", setName },{ "poses", setPoses } });
+	}
+	project["ImageSets"] = imageSets;
+	truth["Poses"] = poseTruth;
+
+	if (!CalibrationEngine::savePairs(directory, cameraPairs)) return false;
+
+	const char* names[] = { "/project.scan", "/truth.json" };
+	const nlohmann::json* documents[] = { &project, &truth };
+	for (int i = 0; i < 2; ++i)
+	{
+		QFile file(directory + names[i]);
+		bool saved = false;
+		try {
+			if (file.open(QIODevice::WriteOnly))
+				saved = file.write(QByteArray::fromStdString(documents[i]->dump())) > 0;
+			file.close();
+		}
+		catch (std::exception) {}
+		if (file.isOpen()) file.close();
+
+		if (!saved) return false;
+	}
+
+	return true;
+}
+
+void SyntheticChessboard::randomPose(const VirtualPair& pair, cv::Matx33d& R, cv::Vec3d& t)
+{
+	const VirtualCamera& right = cameras[pair.right];
+	double distance = options.baseline * 4;
+
+	for (int attempt = 0; attempt < 1000; ++attempt)
+	{
+		//the board stays roughly upright so the corners are found in the same order in every view
+		cv::Vec3d rotation = cv::Vec3d(random.uniform(-0.4, 0.4), random.uniform(-0.4, 0.4), random.uniform(-0.15, 0.15));
+		cv::Rodrigues(rotation, R);
+
+		cv::Vec3d centre = cv::Vec3d(random.uniform(-0.6, 1.0), random.uniform(-0.5, 0.5), random.uniform(1.0, 1.5)) * distance;
+		if (attempt > 500) centre *= 1.5;
+		cv::Vec3d middle = cv::Vec3d((boardWidth - 1) * squareSize / 2, (boardHeight - 1) * squareSize / 2, 0);
+		t = centre - R * middle;
+
+		if (inView(pair.left, R, t) && inView(pair.right, right.R * R, right.R * t + right.T)) return;
+	}
+}
+
+bool SyntheticChessboard::inView(int camera, const cv::Matx33d& R, const cv::Vec3d& t) const
+{
+	const double margin = 20;
+	std::vector<cv::Point3d> corners = std::vector<cv::Point3d>();
+	corners.push_back(cv::Point3d(-2 * squareSize, -2 * squareSize, 0));
+	corners.push_back(cv::Point3d((boardWidth + 1) * squareSize, -2 * squareSize, 0));
+	corners.push_back(cv::Point3d(-2 * squareSize, (boardHeight + 1) * squareSize, 0));
+	corners.push_back(cv::Point3d((boardWidth + 1) * squareSize, (boardHeight + 1) * squareSize, 0));
+
+	for (int i = 0; i < corners.size(); ++i)
+	{
+		cv::Vec3d point = R * cv::Vec3d(corners[i].x, corners[i].y, corners[i].z) + t;
+		if (point[2] <= 0) return false;
+	}
+
+	cv::Vec3d rotation;
+	cv::Rodrigues(R, rotation);
+	std::vector<cv::Point2d> pixels = std::vector<cv::Point2d>();
+	cv::projectPoints(corners, rotation, t, cv::Mat(cameras[camera].K), cv::Mat(cameras[camera].D), pixels);
+
+	for (int i = 0; i < pixels.size(); ++i)
+	{
+		const cv::Point2d& pixel = pixels[i];
+		if (pixel.x < margin || pixel.y < margin || pixel.x > options.imageSize.width - margin || pixel.y > options.imageSize.height - margin)
+			return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <QString>
+#include <vector>
+#include <opencv2/core.hpp>
+
+//how the virtual cameras are made, every camera gets its own spread around these values
+struct GeneratorOptions
+{
+	cv::Size imageSize = cv::Size(1280, 960);
+	int cameras = 2;
+	double focal = 0; //pixels, 0 for 0.85 of the width
+	cv::Matx<double, 1, 5> distortion = cv::Matx<double, 1, 5>(-0.1, 0.04, 0, 0, 0); //k1 k2 p1 p2 k3
+	double baseline = 150; //mm between the cameras of a pair
+	double toeIn = 0.12; //rad the right camera of a pair is turned towards the left one
+	double variation = 0.02; //spread of the intrinsics and the rig between cameras, as a fraction
+	double noise = 2; //standard deviation of the pixel noise in grey levels
+	int quality = 95; //jpeg
+	unsigned int seed = 1;
+};
+
+//one virtual camera, the pose takes points from the left camera of its pair into this camera
+struct VirtualCamera
+{
+	int id;
+	std::string name;
+	cv::Matx33d K;
+	cv::Matx<double, 1, 5> D;
+	cv::Matx33d R;
+	cv::Vec3d T;
+};
+
+//camera indices, the same pairing as the scanner's CameraPairs reply
+struct VirtualPair
+{
+	int id;
+	int left;
+	int right;
+};
+
+//renders the board the calibration tasks look for (9x6 inner corners, 24.23mm squares) through virtual cameras
+//with known intrinsics, distortion and stereo extrinsics, and writes projects of such images in the layout of a
+//transferred project. cameras 2i and 2i+1 form a pair and every set has the board somewhere both of them see it
+class SyntheticChessboard
+{
+public:
+	SyntheticChessboard(const GeneratorOptions& options);
+
+	const GeneratorOptions& getOptions() const { return options; }
+	const std::vector<VirtualCamera>& getCameras() const { return cameras; }
+	const std::vector<VirtualPair>& getPairs() const { return pairs; }
+	//left camera to right camera, as stereoCalibrate gives it
+	void pairTruth(const VirtualPair& pair, cv::Matx33d& R, cv::Vec3d& T) const;
+
+	//board to camera pose, the board origin is its first inner corner with the board lying in z = 0
+	cv::Mat render(int camera, const cv::Matx33d& R, const cv::Vec3d& t);
+
+	//project.scan, set-1..set-<sets> each with <camera name>.jpg, calibration/pairs.json and truth.json
+	//(intrinsics, pairs and the board pose of every image). false if anything couldn't be written
+	bool writeProject(const QString& directory, int sets, int projectId = 1);
+
+	static const int boardWidth = 9;
+	static const int boardHeight = 6;
+	static const float squareSize;
+
+private:
+	//a random pose in the frame of the pair's left camera where the whole board is in view of the pair
+	void randomPose(const VirtualPair& pair, cv::Matx33d& R, cv::Vec3d& t);
+	bool inView(int camera, const cv::Matx33d& R, const cv::Vec3d& t) const;
+	//undistorted ray of every pixel of the camera's image at twice the size, only one camera is kept
+	const cv::Mat& cameraRays(int camera);
+
+	GeneratorOptions options;
+	std::vector<VirtualCamera> cameras;
+	std::vector<VirtualPair> pairs;
+	cv::Mat texture;
+	cv::RNG random;
+
+	cv::Mat rays;
+	int rayCamera = -1;
+
+	const double textureScale = 4; //pixels per mm
+};
@@ -0,0 +1,77 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <qdir.h>
+#include <cstdio>
+#include "SyntheticChessboard.h"
+
+//writes a project of rendered chessboard images with known calibration, for testing and benchmarking the
+//calibration path without real captures. the project can be calibrated directly or served by MockScanner
+int main(int argc, char *argv[])
+{
+	QCoreApplication a(argc, argv);
+	QCoreApplication::setApplicationName("ProjectGenerator");
+
+	GeneratorOptions defaults = GeneratorOptions();
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Renders a calibration project from virtual cameras with known intrinsics and extrinsics");
+	parser.addHelpOption();
+	parser.addPositionalArgument("directory", "Directory the project is written to.", "<directory>");
+	parser.addOption(QCommandLineOption("sets", "Image sets to render.", "n", "20"));
+	parser.addOption(QCommandLineOption("cameras", "Cameras, 2i and 2i+1 are a pair.", "n", QString::number(defaults.cameras)));
+	parser.addOption(QCommandLineOption("size", "Image resolution.", "WxH", "1280x960"));
+	parser.addOption(QCommandLineOption("focal", "Focal length in pixels, 0.85 of the width by default.", "px"));
+	parser.addOption(QCommandLineOption("distortion", "Distortion coefficients k1,k2,p1,p2,k3.", "list", "-0.1,0.04,0,0,0"));
+	parser.addOption(QCommandLineOption("baseline", "Distance between the cameras of a pair in mm.", "mm", QString::number(defaults.baseline)));
+	parser.addOption(QCommandLineOption("toe-in", "Radians the right camera of a pair is turned in.", "rad", QString::number(defaults.toeIn)));
+	parser.addOption(QCommandLineOption("variation", "Spread of the cameras around these values, as a fraction.", "fraction", QString::number(defaults.variation)));
+	parser.addOption(QCommandLineOption("noise", "Standard deviation of the pixel noise.", "grey levels", QString::number(defaults.noise)));
+	parser.addOption(QCommandLineOption("quality", "Jpeg quality.", "0-100", QString::number(defaults.quality)));
+	parser.addOption(QCommandLineOption("seed", "Random seed, the same seed and options give the same project.", "n", QString::number(defaults.seed)));
+	parser.addOption(QCommandLineOption("project-id", "ProjectId written to project.scan.", "id", "1"));
+	parser.process(a);
+
+	if (parser.positionalArguments().size() != 1)
+	{
+		fprintf(stderr, "One output directory is needed\n");
+		parser.showHelp(1);
+	}
+
+	GeneratorOptions options = GeneratorOptions();
+	QStringList size = parser.value("size").split('x');
+	options.imageSize = size.size() == 2 ? cv::Size(size.at(0).toInt(), size.at(1).toInt()) : cv::Size();
+	options.cameras = parser.value("cameras").toInt();
+	options.focal = parser.value("focal").toDouble();
+	options.baseline = parser.value("baseline").toDouble();
+	options.toeIn = parser.value("toe-in").toDouble();
+	options.variation = qMax(0.0, parser.value("variation").toDouble());
+	options.noise = qMax(0.0, parser.value("noise").toDouble());
+	options.quality = qBound(0, parser.value("quality").toInt(), 100);
+	options.seed = parser.value("seed").toUInt();
+
+	QStringList coefficients = parser.value("distortion").split(',');
+	for (int i = 0; i < 5; ++i)
+		options.distortion(0, i) = i < coefficients.size() ? coefficients.at(i).toDouble() : 0;
+
+	int sets = parser.value("sets").toInt();
+	if (options.imageSize.width < 64 || options.imageSize.height < 64 || options.cameras < 1 || sets < 1 || options.baseline <= 0)
+	{
+		fprintf(stderr, "Invalid size, camera count, set count or baseline\n");
+		return 1;
+	}
+
+	QString directory = QDir(parser.positionalArguments().first()).absolutePath();
+	QElapsedTimer clock;
+	clock.start();
+
+	SyntheticChessboard generator(options);
+	if (!generator.writeProject(directory, sets, parser.value("project-id").toInt()))
+	{
+		fprintf(stderr, "Couldn't write the project to %s\n", qPrintable(directory));
+		return 1;
+	}
+
+	printf("%d images from %d cameras in %s (%lldms)\n", sets * options.cameras, options.cameras, qPrintable(directory), clock.elapsed());
+	return 0;
+}
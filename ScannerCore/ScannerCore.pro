@@ -0,0 +1,72 @@
+# scanner connection, discovery, logs, transfer and calibration without any widgets.
+# the visual studio project is used on windows, this is for building the headless tools elsewhere
+TEMPLATE = lib
+CONFIG += staticlib c++11
+QT = core network
+TARGET = ScannerCore
+
+SRC = ../ScannerInspectionTool
+INCLUDEPATH += $$SRC
+
+CONFIG += link_pkgconfig
+PKGCONFIG += opencv
+
+HEADERS += \
+	$$SRC/CalibrationEngine.h \
+	$$SRC/CalibrationImageValidityTask.h \
+	$$SRC/CameraCalibrationTask.h \
+	$$SRC/ContentStore.h \
+	$$SRC/DiscoveryService.h \
+	$$SRC/IDeviceResponder.h \
+	$$SRC/JsonStream.h \
+	$$SRC/JsonTypes.h \
+	$$SRC/LogArchive.h \
+	$$SRC/LogRingModel.h \
+	$$SRC/LogTail.h \
+	$$SRC/MemoryBudget.h \
+	$$SRC/Metrics.h \
+	$$SRC/MetricsServer.h \
+	$$SRC/parameterBuilder.h \
+	$$SRC/Project.h \
+	$$SRC/ProjectSnapshot.h \
+	$$SRC/ProjectStore.h \
+	$$SRC/ReplyEncoding.h \
+	$$SRC/ReplyReader.h \
+	$$SRC/ReplyRing.h \
+	$$SRC/ScannerDeviceInformation.h \
+	$$SRC/ScannerInteraction.h \
+	$$SRC/ScannerSession.h \
+	$$SRC/ScannerSessionManager.h \
+	$$SRC/StereoCalibrationTask.h \
+	$$SRC/Trace.h \
+	$$SRC/TrafficShaper.h \
+	$$SRC/TransferEngine.h \
+	$$SRC/TransferScheduler.h
+
+SOURCES += \
+	$$SRC/CalibrationEngine.cpp \
+	$$SRC/CalibrationImageValidityTask.cpp \
+	$$SRC/CameraCalibrationTask.cpp \
+	$$SRC/ContentStore.cpp \
+	$$SRC/DiscoveryService.cpp \
+	$$SRC/JsonStream.cpp \
+	$$SRC/LogArchive.cpp \
+	$$SRC/LogRingModel.cpp \
+	$$SRC/LogTail.cpp \
+	$$SRC/MemoryBudget.cpp \
+	$$SRC/Metrics.cpp \
+	$$SRC/MetricsServer.cpp \
+	$$SRC/parameterBuilder.cpp \
+	$$SRC/ProjectSnapshot.cpp \
+	$$SRC/ProjectStore.cpp \
+	$$SRC/ReplyReader.cpp \
+	$$SRC/ReplyRing.cpp \
+	$$SRC/ScannerDeviceInformation.cpp \
+	$$SRC/ScannerInteraction.cpp \
+	$$SRC/ScannerSession.cpp \
+	$$SRC/ScannerSessionManager.cpp \
+	$$SRC/StereoCalibrationTask.cpp \
+	$$SRC/Trace.cpp \
+	$$SRC/TrafficShaper.cpp \
+	$$SRC/TransferEngine.cpp \
+	$$SRC/TransferScheduler.cpp
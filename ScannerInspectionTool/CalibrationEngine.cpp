@@ -0,0 +1,281 @@
+#include "CalibrationEngine.h"
+#include <qdir.h>
+#include <QFile>
+#include <qthreadpool.h>
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include "CalibrationImageValidityTask.h"
+#include "CameraCalibrationTask.h"
+#include "StereoCalibrationTask.h"
+#include "ReplyReader.h"
+#include "Lib/json.hpp"
+#include "Trace.h"
+#include "Metrics.h"
+
+
+CalibrationEngine::CalibrationEngine(int threads, QObject* parent) : QObject(parent)
+{
+	pool = new QThreadPool(this);
+	if (threads > 0) pool->setMaxThreadCount(threads);
+	workers()->add(pool->maxThreadCount());
+}
+
+CalibrationEngine::~CalibrationEngine()
+{
+	pool->waitForDone();
+	workers()->add(-pool->maxThreadCount());
+	delete pool;
+}
+
+CalibrationSummary CalibrationEngine::run(const QString& projectPath, ProjectSnapshotPtr project, const std::vector<CameraPair>& pairs)
+{
+	CalibrationSummary summary = CalibrationSummary();
+	QElapsedTimer clock;
+	clock.start();
+
+	if (project.isNull())
+	{
+		summary.error = "No project";
+		return summary;
+	}
+	if (!QDir().mkpath(projectPath + "/calibration"))
+	{
+		summary.error = "Can't write to " + projectPath;
+		return summary;
+	}
+
+	collectImages(projectPath, project);
+
+	if (validateImages)
+	{
+		emit stageStarted("Validating images");
+		TraceSpan span("validate images", "calibration");
+		validate(projectPath, project, summary);
+	}
+
+	{
+		emit stageStarted("Calibrating cameras");
+		TraceSpan span("calibrate cameras", "calibration");
+		calibrateCameras(projectPath, summary);
+	}
+
+	{
+		emit stageStarted("Calibrating pairs");
+		TraceSpan span("calibrate pairs", "calibration");
+		calibratePairs(projectPath, pairs, summary);
+		if (!pairs.empty()) savePairs(projectPath, pairs);
+	}
+
+	summary.ms = clock.elapsed();
+	return summary;
+}
+
+MetricGauge* CalibrationEngine::validationQueue()
+{
+	static MetricGauge* metric = Metrics::gauge("calibration_validation_queue", "Images waiting for the chessboard search");
+	return metric;
+}
+
+MetricGauge* CalibrationEngine::busyWorkers()
+{
+	static MetricGauge* metric = Metrics::gauge("calibration_busy_workers", "Calibration pool threads running a task");
+	return metric;
+}
+
+MetricGauge* CalibrationEngine::workers()
+{
+	static MetricGauge* metric = Metrics::gauge("calibration_workers", "Threads in the calibration pools");
+	return metric;
+}
+
+MetricCounter* CalibrationEngine::finishedTasks(const QString& task)
+{
+	return Metrics::counter("calibration_tasks_total", "Calibration tasks finished", "task=\"" + task + "\"");
+}
+
+QString CalibrationEngine::cameraConfigPath(const QString& projectPath, const QString& cameraName)
+{
+	return projectPath + "/calibration/" + cameraName + "-calibration.json";
+}
+
+QString CalibrationEngine::pairConfigPath(const QString& projectPath, int pairId)
+{
+	return projectPath + "/calibration/" + QString::number(pairId) + ".json";
+}
+
+bool CalibrationEngine::savePairs(const QString& projectPath, const std::vector<CameraPair>& pairs)
+{
+	nlohmann::json save = nlohmann::json::array();
+	for (int i = 0; i < pairs.size(); ++i)
+		save.push_back({ { "pairId", pairs[i].id },{ "LeftCamera", pairs[i].leftId },{ "RightCamera", pairs[i].rightId } });
+
+	QFile pairFile(projectPath + "/calibration/pairs.json");
+	bool saved = false;
+	try {
+		if (pairFile.open(QIODevice::WriteOnly))
+			saved = pairFile.write(QByteArray::fromStdString(save.dump())) >= 0;
+		pairFile.close();
+	}
+	catch (std::exception) {}
+	if (pairFile.isOpen()) pairFile.close();
+
+	return saved;
+}
+
+bool CalibrationEngine::loadPairs(const QString& projectPath, std::vector<CameraPair>& pairs)
+{
+	QFile pairFile(projectPath + "/calibration/pairs.json");
+	QByteArray data;
+
+	try {
+		if (pairFile.open(QIODevice::ReadOnly))
+		{
+			data = pairFile.readAll();
+			pairFile.close();
+		}
+	}
+	catch (std::exception) {}
+	if (pairFile.isOpen()) pairFile.close();
+
+	if (data.isEmpty()) return false;
+	return ReplyReader::readCameraPairs(data, pairs);
+}
+
+void CalibrationEngine::collectImages(const QString& projectPath, ProjectSnapshotPtr project)
+{
+	pointFiles.clear();
+	sampleImages.clear();
+	cameraNames.clear();
+	calibrated.clear();
+
+	for (int i = 0; i < project->cameraCount(); ++i)
+	{
+		int camId = project->camera(i).id;
+		std::vector<QString> paths = std::vector<QString>();
+
+		for (int j = 0; j < project->setCount(); ++j)
+		{
+			int image = project->findImage(j, camId);
+			if (image < 0) continue;
+
+			QString setPath = projectPath + "/" + project->setName(j);
+			QString name = project->fileName(image).section('.', 0, 0) + ".conf";
+			paths.push_back(setPath + "/calibration/" + name);
+
+			if (!sampleImages.count(camId) && QFile::exists(setPath + "/" + project->fileName(image)))
+				sampleImages.emplace(camId, setPath + "/" + project->fileName(image));
+		}
+
+		pointFiles.emplace(camId, paths);
+		cameraNames.emplace(camId, project->camera(i).name);
+	}
+}
+
+void CalibrationEngine::validate(const QString& projectPath, ProjectSnapshotPtr project, CalibrationSummary& summary)
+{
+	QAtomicInt valid = QAtomicInt(0);
+	QAtomicInt invalid = QAtomicInt(0);
+
+	for (int i = 0; i < project->setCount(); ++i)
+	{
+		QString basePath = projectPath + "/" + project->setName(i) + "/";
+		QString savePath = basePath + "calibration/";
+		if (!QDir().exists(basePath)) continue;
+		if (!QDir().exists(savePath)) QDir().mkdir(savePath);
+
+		int end = project->firstImage(i) + project->imageCount(i);
+		for (int j = project->firstImage(i); j < end; ++j)
+		{
+			QString name = project->fileName(j);
+
+			//a point file left from an earlier run would be calibrated with even if the image is no longer valid
+			QFile::remove(savePath + name.section('.', 0, 0) + ".conf");
+			if (!QFile::exists(basePath + name)) continue;
+
+			//the task signals from the pool thread, the counters are read once the pool is done
+			CalibrationImageValidityTask* task = new CalibrationImageValidityTask(basePath + name, savePath, name, project->setId(i), project->cameraId(j));
+			connect(task, &CalibrationImageValidityTask::complete, this, [this, &valid](int set, int img)
+			{
+				valid.ref();
+				emit imageValidated(set, img, true);
+			}, Qt::DirectConnection);
+			connect(task, &CalibrationImageValidityTask::failed, this, [this, &invalid](int set, int img)
+			{
+				invalid.ref();
+				emit imageValidated(set, img, false);
+			}, Qt::DirectConnection);
+			pool->start(task);
+		}
+	}
+
+	pool->waitForDone();
+	summary.validImages = valid.load();
+	summary.invalidImages = invalid.load();
+}
+
+void CalibrationEngine::calibrateCameras(const QString& projectPath, CalibrationSummary& summary)
+{
+	std::map<int, CameraCalibrationTask*> tasks = std::map<int, CameraCalibrationTask*>();
+	for (std::map<int, std::vector<QString>>::iterator it = pointFiles.begin(); it != pointFiles.end(); ++it)
+	{
+		QString savePath = cameraConfigPath(projectPath, cameraNames[it->first]);
+		QFile::remove(savePath);
+
+		//kept after running so the result can be read
+		CameraCalibrationTask* task = new CameraCalibrationTask(savePath, it->second, writeYaml);
+		task->setAutoDelete(false);
+		tasks.emplace(it->first, task);
+		pool->start(task);
+	}
+	pool->waitForDone();
+
+	for (std::map<int, CameraCalibrationTask*>::iterator it = tasks.begin(); it != tasks.end(); ++it)
+	{
+		bool success = it->second->succeeded();
+		calibrated[it->first] = success;
+
+		if (success) summary.calibratedCameras++;
+		else summary.failedCameras++;
+		emit cameraCalibrated(it->first, success, it->second->failure());
+
+		delete it->second;
+	}
+}
+
+void CalibrationEngine::calibratePairs(const QString& projectPath, const std::vector<CameraPair>& pairs, CalibrationSummary& summary)
+{
+	std::vector<std::pair<int, StereoCalibrationTask*>> tasks = std::vector<std::pair<int, StereoCalibrationTask*>>();
+	for (int i = 0; i < pairs.size(); ++i)
+	{
+		const CameraPair& pair = pairs[i];
+		QString savePath = pairConfigPath(projectPath, pair.id);
+		QFile::remove(savePath);
+
+		//a pair can't be calibrated without the intrinsics of both cameras
+		if (!calibrated[pair.leftId] || !calibrated[pair.rightId] || !sampleImages.count(pair.leftId))
+		{
+			summary.failedPairs++;
+			emit pairCalibrated(pair.id, false, "Camera not calibrated");
+			continue;
+		}
+
+		StereoCalibrationTask* task = new StereoCalibrationTask(
+			cameraConfigPath(projectPath, cameraNames[pair.leftId]), pointFiles[pair.leftId],
+			cameraConfigPath(projectPath, cameraNames[pair.rightId]), pointFiles[pair.rightId],
+			sampleImages[pair.leftId], savePath, writeYaml);
+		task->setAutoDelete(false);
+		tasks.push_back(std::make_pair(pair.id, task));
+		pool->start(task);
+	}
+	pool->waitForDone();
+
+	for (int i = 0; i < tasks.size(); ++i)
+	{
+		StereoCalibrationTask* task = tasks[i].second;
+		if (task->succeeded()) summary.calibratedPairs++;
+		else summary.failedPairs++;
+		emit pairCalibrated(tasks[i].first, task->succeeded(), task->failure());
+
+		delete task;
+	}
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <QObject>
+#include <QString>
+#include <vector>
+#include <map>
+#include "JsonTypes.h"
+#include "ProjectSnapshot.h"
+
+class MetricGauge;
+class MetricCounter;
+QT_BEGIN_NAMESPACE
+class QThreadPool;
+QT_END_NAMESPACE
+
+//what a calibration run managed, error is set when the run couldn't start at all
+struct CalibrationSummary
+{
+	int validImages = 0;
+	int invalidImages = 0;
+	int calibratedCameras = 0;
+	int failedCameras = 0;
+	int calibratedPairs = 0;
+	int failedPairs = 0;
+	qint64 ms = 0;
+	QString error;
+
+	bool succeeded() const { return error.isEmpty() && calibratedCameras > 0 && failedCameras == 0 && failedPairs == 0; }
+};
+
+//calibrates the cameras and camera pairs of a transferred project without any widgets.
+//runs in three stages, each spread over the engine's own thread pool and finished before the next starts:
+//finding the chessboard in every image, the intrinsics of every camera, then every stereo pair.
+//results go to <project>/calibration, json always and yaml when asked for
+class CalibrationEngine : public QObject
+{
+	Q_OBJECT
+
+public:
+	//0 threads uses every core
+	CalibrationEngine(int threads = 0, QObject* parent = Q_NULLPTR);
+	~CalibrationEngine();
+
+	//off when the .conf point files of the images are already there (the calibration window writes them)
+	void setValidateImages(bool validate) { validateImages = validate; }
+	void setWriteYaml(bool yaml) { writeYaml = yaml; }
+
+	//blocks until the whole project has been calibrated
+	CalibrationSummary run(const QString& projectPath, ProjectSnapshotPtr project, const std::vector<CameraPair>& pairs);
+
+	static QString cameraConfigPath(const QString& projectPath, const QString& cameraName);
+	static QString pairConfigPath(const QString& projectPath, int pairId);
+	//the scanner's camera pairs are kept with the results so the project can be calibrated again without it
+	static bool savePairs(const QString& projectPath, const std::vector<CameraPair>& pairs);
+	static bool loadPairs(const QString& projectPath, std::vector<CameraPair>& pairs);
+
+	//shared by every calibration task whichever pool it runs on
+	static MetricGauge* validationQueue();
+	static MetricGauge* busyWorkers();
+	static MetricGauge* workers();
+	static MetricCounter* finishedTasks(const QString& task);
+
+	signals:
+	void stageStarted(QString stage);
+	void imageValidated(int setId, int cameraId, bool valid);
+	void cameraCalibrated(int cameraId, bool success, QString error);
+	void pairCalibrated(int pairId, bool success, QString error);
+
+private:
+	void collectImages(const QString& projectPath, ProjectSnapshotPtr project);
+	void validate(const QString& projectPath, ProjectSnapshotPtr project, CalibrationSummary& summary);
+	void calibrateCameras(const QString& projectPath, CalibrationSummary& summary);
+	void calibratePairs(const QString& projectPath, const std::vector<CameraPair>& pairs, CalibrationSummary& summary);
+
+	QThreadPool* pool;
+	bool validateImages = true;
+	bool writeYaml = false;
+
+	//per camera, the .conf point file of every image and the first image that exists
+	std::map<int, std::vector<QString>> pointFiles;
+	std::map<int, QString> sampleImages;
+	std::map<int, QString> cameraNames;
+	std::map<int, bool> calibrated;
+};
@@ -1,12 +1,25 @@
 #include "CalibrationImageValidityTask.h"
 #include <opencv2/opencv.hpp>
 #include "opencv2/imgcodecs.hpp"
-#include <QFileDialog>
+#include <QFile>
+#include <QFileInfo>
 #include "Lib/json.hpp"
+#include "Trace.h"
+#include "Metrics.h"
+#include "CalibrationEngine.h"
+#include "MemoryBudget.h"
+#include "ContentStore.h"
+#include <QAtomicInteger>
 
 
 using namespace std;
 
+namespace
+{
+	//the images of a project are all the same size, so the last one decoded is a good guess at the next
+	QAtomicInteger<qint64> lastDecodeSize(0);
+}
+
 CalibrationImageValidityTask::CalibrationImageValidityTask(QString loadPath, QString savePath, QString imageName, int setId, int imgId)
 {
 	path = loadPath;
@@ -15,43 +28,87 @@ CalibrationImageValidityTask::CalibrationImageValidityTask(QString loadPath, QSt
 
 	set = setId;
 	img = imgId;
+
+	CalibrationEngine::validationQueue()->add(1);
 }
 
 CalibrationImageValidityTask::~CalibrationImageValidityTask()
 {
+	//dropped from the pool before it ran
+	if (queued) CalibrationEngine::validationQueue()->add(-1);
 }
 
 void CalibrationImageValidityTask::run()
 {
+	queued = false;
+	CalibrationEngine::validationQueue()->add(-1);
+	MetricHold busy(CalibrationEngine::busyWorkers(), CalibrationEngine::finishedTasks("validate"));
+
 	if (!QFile::exists(path))
 	{
 		emit failed(set, img);
 		return;
 	}
 
-	Mat image = imread(path.toStdString(), 1); // 0 = greayscale, 1 = colour
-	if (image.empty())
+	//an image is only checked once whichever project it's in, the results are kept in the content store
+	QString kind = "corners-" + QString::number(board.width) + "x" + QString::number(board.height);
+	QString pointsPath = saveRoot + fileName.section('.', 0, 0) + ".conf";
+	QString cornersPath = saveRoot + fileName;
+	QString cornersKind = kind + "." + QFileInfo(fileName).suffix();
+	{
+		TraceSpan span("hash image", "disk");
+		key = ContentStore::hashFile(path);
+	}
+	if (ContentStore::has(key, kind + ".invalid"))
 	{
 		emit failed(set, img);
 		return;
 	}
+	if (ContentStore::reuse(key, kind + ".conf", pointsPath))
+	{
+		ContentStore::reuse(key, cornersKind, cornersPath);
+		emit complete(set, img);
+		return;
+	}
 
-	vector<Point2f>& corners = vector<Point2f>();
+	//fewer images are decoded at once when they would go over the decode budget
+	MemoryCharge decoded(MemoryCategory::Decode, lastDecodeSize.loadAcquire(), true);
+	Mat image;
+	{
+		TraceSpan span("imread", "opencv");
+		image = imread(path.toStdString(), 1); // 0 = greayscale, 1 = colour
+	}
+	decoded.resize(qint64(image.total() * image.elemSize()));
+	if (decoded.size() > 0) lastDecodeSize.storeRelease(decoded.size());
+	if (image.empty())
+	{
+		fail(kind);
+		return;
+	}
+
+	vector<Point2f> corners = vector<Point2f>();
 
 	//quick validity check
-	bool found = findChessboardCorners(image, board, corners, CALIB_CB_FAST_CHECK);
+	bool found;
+	{
+		TraceSpan span("find corners fast", "opencv");
+		found = findChessboardCorners(image, board, corners, CALIB_CB_FAST_CHECK);
+	}
 	if (!found)
 	{
-		emit failed(set, img);
+		fail(kind);
 		return;
 	}
 	corners.clear();
 
-	found = findChessboardCorners(image, board, corners,
-		CALIB_CB_ADAPTIVE_THRESH | CALIB_CB_NORMALIZE_IMAGE);
+	{
+		TraceSpan span("find corners", "opencv");
+		found = findChessboardCorners(image, board, corners,
+			CALIB_CB_ADAPTIVE_THRESH | CALIB_CB_NORMALIZE_IMAGE);
+	}
 	if (!found)
 	{
-		emit failed(set, img);
+		fail(kind);
 		return;
 	}
 
@@ -64,7 +121,12 @@ void CalibrationImageValidityTask::run()
 	compression_params.push_back(CV_IMWRITE_JPEG_QUALITY);
 	compression_params.push_back(100);
 	drawChessboardCorners(image, board, corners, found);
-	imwrite((saveRoot + fileName).toStdString(), image);
+	{
+		TraceSpan span("imwrite", "opencv");
+		//an earlier result may be a link into the store
+		QFile::remove(cornersPath);
+		imwrite(cornersPath.toStdString(), image);
+	}
 
 	//save points
 	json save;
@@ -75,15 +137,28 @@ void CalibrationImageValidityTask::run()
 	}
 	string jsonString = save.dump();
 
-	QString resultSavePath = saveRoot + fileName.section('.', 0, 0) + ".conf";
-	QFile calibrationFile(resultSavePath);
+	QFile::remove(pointsPath);
+	QFile calibrationFile(pointsPath);
+	TraceSpan span("write points", "disk");
+	bool saved = false;
 	try {
-		calibrationFile.open(QIODevice::WriteOnly);
-		calibrationFile.write(QString::fromStdString(jsonString).toUtf8());
+		if (calibrationFile.open(QIODevice::WriteOnly))
+			saved = calibrationFile.write(QString::fromStdString(jsonString).toUtf8()) > 0;
 		calibrationFile.close();
 	}
 	catch (std::exception) {}
 	if (calibrationFile.isOpen()) calibrationFile.close();
 
+	if (saved)
+	{
+		ContentStore::keep(key, cornersKind, cornersPath);
+		ContentStore::keep(key, kind + ".conf", pointsPath);
+	}
 	emit complete(set, img);
 }
+
+void CalibrationImageValidityTask::fail(const QString& kind)
+{
+	ContentStore::mark(key, kind + ".invalid");
+	emit failed(set, img);
+}
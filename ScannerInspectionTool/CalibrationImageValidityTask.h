@@ -23,8 +23,13 @@ public:
 	void failed(int, int);
 
 private:
+	//remembers the image as invalid in the content store
+	void fail(const QString& kind);
+
 	const Size board = Size(9, 6);
 
 	QString path, saveRoot, fileName;
+	QByteArray key; //the image's content hash
 	int set, img;
+	bool queued = true;
 };
\ No newline at end of file
@@ -12,20 +12,20 @@ CalibrationListModel::~CalibrationListModel()
 
 int CalibrationListModel::rowCount(const QModelIndex& parent) const
 {
-	return sets->size();
+	return rows;
 }
 
 QVariant CalibrationListModel::data(const QModelIndex& index, int role) const
 {
 	if (role == Qt::DisplayRole)
-		return sets->at(index.row())->name;
+		return store->setName(index.row());
 
 	if (role == Qt::DecorationRole)
 	{
 		CalibrationValidity icon = Missing;
-		for (int i = 0; i < sets->at(index.row())->pairs->size(); ++i)
+		for (int i = 0; i < store->pairCount(); ++i)
 		{
-			switch (sets->at(index.row())->pairs->at(i))
+			switch (store->pairValidity(index.row(), i))
 			{
 			case Pending:
 				icon = Pending;
@@ -64,41 +64,43 @@ Qt::ItemFlags CalibrationListModel::flags(const QModelIndex& index) const
 	return Qt::ItemIsEnabled;
 }
 
-void CalibrationListModel::addItem(CalibrationSet* set)
+//the store is about to be replaced, resetSets or clearData ends the reset
+void CalibrationListModel::aboutToReset()
 {
-	beginInsertRows(QModelIndex(), rowCount(), rowCount());
-	sets->append(set);
-	endInsertRows();
-}
+	if (resetting) return;
 
-void CalibrationListModel::clearData()
-{
 	beginResetModel();
+	resetting = true;
+}
 
-	for (int i = 0; i < sets->size(); ++i)
-		delete sets->at(i);
-	sets->clear();
-
+void CalibrationListModel::resetSets()
+{
+	if (!resetting) beginResetModel();
+	rows = store == nullptr ? 0 : store->setCount();
+	resetting = false;
 	endResetModel();
 }
 
-bool CalibrationListModel::containsSet(int id) const
+void CalibrationListModel::setsAppended(int first)
 {
-	for (int i = 0; i < sets->size(); ++i)
-		if (sets->at(i)->setId == id) return true;
-	return false;
+	int last = store->setCount() - 1;
+	if (last < first) return;
+
+	beginInsertRows(QModelIndex(), first, last);
+	rows = store->setCount();
+	endInsertRows();
 }
 
-CalibrationSet* CalibrationListModel::getSet(int set)
+void CalibrationListModel::setChanged(int row)
 {
-	if (sets->size() >= set)
-		return sets->at(set - 1);
-	else return nullptr;
+	QModelIndex changed = index(row);
+	emit dataChanged(changed, changed);
 }
 
-CalibrationSet* CalibrationListModel::getRow(int row)
+void CalibrationListModel::clearData()
 {
-	if (row >= 0 && sets->size() > row)
-		return sets->at(row);
-	else return nullptr;
+	if (!resetting) beginResetModel();
+	rows = 0;
+	resetting = false;
+	endResetModel();
 }
@@ -1,5 +1,8 @@
 #pragma once
+#include <QAbstractListModel>
+#include <QIcon>
 #include "JsonTypes.h"
+#include "ProjectStore.h"
 
 class CalibrationListModel : public QAbstractListModel
 {
@@ -13,17 +16,19 @@ public:
 	QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
 	Qt::ItemFlags flags(const QModelIndex &index) const override;
 
-	void addItem(CalibrationSet* set);
+	void setStore(ProjectStore* projectStore) { store = projectStore; }
+	void aboutToReset();
+	void resetSets();
+	void setsAppended(int first);
+	void setChanged(int row);
 	void clearData();
-	bool containsSet(int id) const;
-	CalibrationSet* getSet(int row);
-	CalibrationSet* getRow(int row);
 
 private:
-	QList<CalibrationSet*>* sets = new QList<CalibrationSet*>();
+	ProjectStore* store = nullptr;
+	int rows = 0;
+	bool resetting = false;
 
 	const QIcon pending = QIcon("pending");
 	const QIcon done = QIcon("transferComplete");
 	const QIcon failed = QIcon("transferNeeded");
 };
-
@@ -1,10 +1,12 @@
 #include "CalibrationWindow.h"
 #include <QFileDialog>
-#include "Lib/json.hpp"
-#include "JsonTypes.h"
 #include <QGraphicsPixmapItem>
 #include "CalibrationImageValidityTask.h"
 #include "CameraCalibrationThread.h"
+#include "ReplyReader.h"
+#include "CalibrationEngine.h"
+#include "Metrics.h"
+#include "PreviewCache.h"
 
 
 CalibrationWindow::CalibrationWindow(QWidget *parent) : QWidget(parent)
@@ -43,6 +45,11 @@ CalibrationWindow::CalibrationWindow(QWidget *parent) : QWidget(parent)
 
 	configureButton = findChild<QPushButton*>("genButton");
 	connect(configureButton, &QPushButton::pressed, this, &CalibrationWindow::startConfigGeneration);
+
+	calibrationError = new QErrorMessage();
+	calibrationError->setWindowTitle("Calibration Error");
+
+	CalibrationEngine::workers()->add(workQueue->maxThreadCount());
 }
 
 
@@ -52,6 +59,7 @@ CalibrationWindow::~CalibrationWindow()
 	delete spacer;
 	delete leftCam;
 	delete rightCam;
+	delete pairModel;
 
 	for (int i = 0; i < buttons->size(); ++i)
 		delete buttons->at(i);
@@ -60,20 +68,54 @@ CalibrationWindow::~CalibrationWindow()
 
 	cameras->clear();
 	delete cameras;
+	delete calibrationError;
 
 	finishThread->quit();
 	finishThread->quit();
+
+	workQueue->clear();
+	workQueue->waitForDone();
+	CalibrationEngine::workers()->add(-workQueue->maxThreadCount());
+}
+
+//binds the window to a scanner session, the camera pairs are reloaded from the new scanner
+void CalibrationWindow::setConnection(ScannerInteraction* scanner)
+{
+	if (connection == scanner) return;
+
+	for (int i = 0; i < connectionLinks.size(); ++i)
+		disconnect(connectionLinks[i]);
+	connectionLinks.clear();
+
+	if (connection != nullptr) scannerDisconnected();
+	connection = scanner;
+	if (connection == nullptr) return;
+
+	connectionLinks.append(connect(connection, &ScannerInteraction::scannerConnected, this, &CalibrationWindow::scannerConnected));
+	connectionLinks.append(connect(connection, &ScannerInteraction::scannerConnectionLost, this, &CalibrationWindow::scannerDisconnected));
+	if (connection->isConnected()) scannerConnected();
 }
 
-//clear the existing imagesets and load a new project
-void CalibrationWindow::projectSelected(QString project)
+void CalibrationWindow::setProjectStore(ProjectStore* projectStore)
+{
+	store = projectStore;
+	model->setStore(projectStore);
+}
+
+void CalibrationWindow::projectAboutToChange()
+{
+	model->aboutToReset();
+}
+
+//the project store has been refilled with a new project
+void CalibrationWindow::projectSelected(QString project, ProjectSnapshotPtr snapshot)
 {
 	projectPath = project;
-	QString data = getProjectJsonString();
+	this->snapshot = snapshot;
 	configureButton->setEnabled(false);
 	confBtnEnable = false;
+	activeSet = -1;
 
-	if (model->rowCount() > 0) model->clearData();
 	for (int i = 0; i < cameras->size(); ++i)
 	{
 		cameras->at(i).workingCount = 0;
@@ -82,35 +124,30 @@ void CalibrationWindow::projectSelected(QString project)
 		pairModel->setItem(i, 1, qty);
 	}
 
-	json json = json::parse(data.toStdString().c_str());
-	for (int i = 0; i < json["ImageSets"].size(); ++i) {
-		CalibrationSet* newSet = generateCalibrationSet(json["ImageSets"][i]);
-
-		if (QDir().exists(projectPath + newSet->name) + "/") generateCalibrationTasks(newSet);
-		model->addItem(newSet);
+	for (int i = 0; i < store->setCount(); ++i) {
+		initialiseCalibrationSet(i);
+		generateCalibrationTasks(i);
 	}
+
+	model->resetSets();
 }
 
-//add imagesets to the existing sets
-void CalibrationWindow::updateProject()
+//new imagesets have been added to the end of the project store
+void CalibrationWindow::updateProject(QString project, ProjectSnapshotPtr snapshot)
 {
-	QString data = getProjectJsonString();
-	json json = json::parse(data.toStdString().c_str());
-
-	if (json["ImageSets"].size() <= model->rowCount()) return;
-
-	for (int i = 0; i < json["ImageSets"].size(); ++i) {
-		nlohmann::json imageSetJson = json["ImageSets"][i];
-
-		int setId = imageSetJson["id"];
-		if (model->containsSet(setId)) continue;
-		//todo check if the amount of images match and add any new ones if they do (can happen if scanner is queried while taking a new image)
+	projectPath = project;
+	this->snapshot = snapshot;
 
-		CalibrationSet* newSet = generateCalibrationSet(json["ImageSets"][i]);
+	int first = model->rowCount();
+	if (store->setCount() <= first) return;
 
-		generateCalibrationTasks(newSet);
-		model->addItem(newSet);
+	//todo check if the amount of images match and add any new ones if they do (can happen if scanner is queried while taking a new image)
+	for (int i = first; i < store->setCount(); ++i) {
+		initialiseCalibrationSet(i);
+		generateCalibrationTasks(i);
 	}
+
+	model->setsAppended(first);
 }
 
 void CalibrationWindow::scannerConnected()
@@ -123,7 +160,7 @@ void CalibrationWindow::scannerDisconnected()
 	cameras->clear();
 	model->clearData();
 
-	activeSet = nullptr;
+	activeSet = -1;
 	activePair = -1;
 
 	for (int i = 0; i < buttons->size(); ++i)
@@ -136,7 +173,8 @@ void CalibrationWindow::scannerDisconnected()
 
 void CalibrationWindow::selctionChanged(QModelIndex index)
 {
-	activeSet = model->getRow(index.row());
+	if (index.row() < 0 || index.row() >= model->rowCount()) return;
+	activeSet = index.row();
 
 	calculateButtonStates();
 
@@ -169,10 +207,11 @@ void CalibrationWindow::startConfigGeneration()
 {
 	if (finishThread->isRunning()) return;
 
-	CameraCalibrationThread* work = new CameraCalibrationThread(projectPath, rawPairs, connection);
+	CameraCalibrationThread* work = new CameraCalibrationThread(projectPath, snapshot, *cameras, connection);
 	work->moveToThread(finishThread);
 
 	connect(work, &CameraCalibrationThread::complete, this, &CalibrationWindow::configGenComplete);
+	connect(work, &CameraCalibrationThread::failed, calibrationError, static_cast<void(QErrorMessage::*)(const QString&)>(&QErrorMessage::showMessage));
 	connect(finishThread, &QThread::started, work, &CameraCalibrationThread::start);
 
 	finishThread->start();
@@ -191,25 +230,19 @@ void CalibrationWindow::configGenComplete()
 
 void CalibrationWindow::newImageTransfered(int setId, int imageId)
 {
-	CalibrationSet* set = model->getSet(setId);
-	if (set == nullptr) return;
+	int set = store->setRow(setId);
+	if (set < 0 || set >= model->rowCount()) return;
 
-	for (int i = 0; i < set->images->size(); ++i)
-	{
-		if (set->images->at(i)->cameraId == imageId)
-		{
-			if (QFile().exists(projectPath + "/" + set->name + "/" + set->images->at(i)->fileName))
-				set->images->at(i)->valid = Pending;
-			break;
-		}
-	}
+	int image = store->findImage(set, imageId);
+	if (image >= 0 && store->isTransfered(image))
+		store->setValidity(image, Pending);
 
 	//check if new images complete a pair
 	checkImagePairs(set);
 	generateCalibrationTasks(set);
 
 	//rescan the buttons and enable any new pairs that now (potentially) exist
-	if (activeSet != nullptr && activeSet->setId == setId)
+	if (activeSet == set)
 		calculateButtonStates();
 }
 
@@ -218,14 +251,8 @@ void CalibrationWindow::windowOpened()
 	enabled = true;
 	if(cameras->size() > 0) resizeControlSplitter();
 
-	if (model->rowCount() > 0)
-	{
-		for (int i = 0; i < model->rowCount(); ++i)
-		{
-			CalibrationSet* set = model->getRow(i);
-			generateCalibrationTasks(set);
-		}
-	}
+	for (int i = 0; i < model->rowCount(); ++i)
+		generateCalibrationTasks(i);
 }
 
 void CalibrationWindow::respondToScanner(ScannerCommands command, QByteArray data)
@@ -234,45 +261,21 @@ void CalibrationWindow::respondToScanner(ScannerCommands command, QByteArray dat
 	{
 	case ScannerCommands::CameraPairs:
 		processCameraPairs(data);
-		rawPairs = data;
 		break;
 	}
 }
 
-QString CalibrationWindow::getProjectJsonString()
-{
-	QFile text(projectPath + "/" + "project.scan");
-	QString jsonText = "";
-
-	try {
-		if (text.open(QIODevice::ReadOnly))
-		{
-			jsonText = text.readAll();
-			text.close();
-		}
-	}
-	catch (std::exception) {}
-	if (text.isOpen()) text.close();
-
-	return jsonText;
-}
-
 void CalibrationWindow::processCameraPairs(QByteArray data)
 {
-	QString jsonText = data;
-	if (jsonText.startsWith("Fail")) return;
+	std::vector<CameraPair> pairs = std::vector<CameraPair>();
+	if (!ReplyReader::readCameraPairs(data, pairs, connection->replyEncoding())) return;
 
 	if (cameras->size() > 0) cameras->clear();
 	if (pairModel->rowCount() > 0) pairModel->clear();
 
-	json pairs = json::parse(jsonText.toStdString().c_str());
 	for (int i = 0; i < pairs.size(); ++i)
 	{
-		CameraPair pair = CameraPair();
-		pair.leftId = pairs.at(i)["LeftCamera"];
-		pair.rightId = pairs.at(i)["RightCamera"];
-		pair.id = pairs.at(i)["pairId"];
-
+		CameraPair pair = pairs[i];
 		cameras->push_back(pair);
 
 		QStandardItem* item = new QStandardItem(QString::number(pair.leftId) + " - " + QString::number(pair.rightId));
@@ -281,6 +284,11 @@ void CalibrationWindow::processCameraPairs(QByteArray data)
 		pairModel->setItem(i, 1, qty);
 	}
 
+	//pair states of the loaded sets need recalculating for the new configuration
+	store->setPairCount(cameras->size());
+	for (int i = 0; i < model->rowCount(); ++i)
+		checkImagePairs(i);
+
 	resizeControlSplitter();
 
 	//button setup
@@ -322,7 +330,7 @@ void CalibrationWindow::processCameraPairs(QByteArray data)
 
 void CalibrationWindow::updateCameraImages()
 {
-	if (activePair == -1 || activePair > cameras->size())
+	if (activeSet == -1 || activePair == -1 || activePair >= cameras->size())
 	{
 		leftCam->clear();
 		leftCam->addText("No image pair in set");
@@ -334,38 +342,32 @@ void CalibrationWindow::updateCameraImages()
 		return;
 	}
 
-	QString leftName = "", rightName = "";
-
-	for (int j = 0; j < activeSet->images->size(); ++j)
-	{
-		if (activeSet->images->at(j)->cameraId == cameras->at(activePair).leftId)
-			leftName = activeSet->images->at(j)->fileName;
-		else if (activeSet->images->at(j)->cameraId == cameras->at(activePair).rightId)
-			rightName = activeSet->images->at(j)->fileName;
-
-		if (leftName != "" && rightName != "") break;
-	}
+	QString leftName = getImageName(activeSet, cameras->at(activePair).leftId);
+	QString rightName = getImageName(activeSet, cameras->at(activePair).rightId);
+	QString setPath = projectPath + "/" + store->setName(activeSet);
 
 	if (leftCam->items().size() > 0) leftCam->clear();
-	if (QFile().exists(projectPath + "/" + activeSet->name + "/calibration/" + leftName))
-		leftCam->addItem(new QGraphicsPixmapItem(QPixmap::fromImage(QImage(projectPath + "/" + activeSet->name + "/calibration/" + leftName))));
-	else leftCam->addItem(new QGraphicsPixmapItem(QPixmap::fromImage(QImage(projectPath + "/" + activeSet->name + "/" + leftName))));
+	if (QFile().exists(setPath + "/calibration/" + leftName))
+		leftCam->addItem(new QGraphicsPixmapItem(PreviewCache::load(setPath + "/calibration/" + leftName)));
+	else leftCam->addItem(new QGraphicsPixmapItem(PreviewCache::load(setPath + "/" + leftName)));
 
 	if (rightCam->items().size() > 0) rightCam->clear();
-	if (QFile().exists(projectPath + "/" + activeSet->name + "/calibration/" + rightName))
-		rightCam->addItem(new QGraphicsPixmapItem(QPixmap::fromImage(QImage(projectPath + "/" + activeSet->name + "/calibration/" + rightName))));
-	else rightCam->addItem(new QGraphicsPixmapItem(QPixmap::fromImage(QImage(projectPath + "/" + activeSet->name + "/" + rightName))));
+	if (QFile().exists(setPath + "/calibration/" + rightName))
+		rightCam->addItem(new QGraphicsPixmapItem(PreviewCache::load(setPath + "/calibration/" + rightName)));
+	else rightCam->addItem(new QGraphicsPixmapItem(PreviewCache::load(setPath + "/" + rightName)));
 
 	resizePreviews();
 }
 
 void CalibrationWindow::calculateButtonStates()
 {
-	for (int i = 0; i < activeSet->pairs->size(); ++i)
+	if (activeSet == -1) return;
+
+	for (int i = 0; i < store->pairCount() && i < buttons->size(); ++i)
 	{
-		if (activeSet->pairs->at(i) == CalibrationValidity::Missing)
+		if (store->pairValidity(activeSet, i) == CalibrationValidity::Missing)
 			buttons->at(i)->setEnabled(false);
-		else if (activeSet->pairs->at(i) == CalibrationValidity::Uncaptured)
+		else if (store->pairValidity(activeSet, i) == CalibrationValidity::Uncaptured)
 			buttons->at(i)->setEnabled(false);
 		else buttons->at(i)->setEnabled(true);
 	}
@@ -385,15 +387,12 @@ void CalibrationWindow::resizeEvent(QResizeEvent* event)
 	resizePreviews();
 }
 
-QString CalibrationWindow::getImageName(CalibrationSet* search, int camId) const
+QString CalibrationWindow::getImageName(int set, int camId) const
 {
-	for (int i = 0; i < search->images->size(); ++i)
-	{
-		if (search->images->at(i)->cameraId == camId)
-			return search->images->at(i)->fileName;
-	}
+	int image = store->findImage(set, camId);
+	if (image < 0) return "";
 
-	return "";
+	return store->fileName(image);
 }
 
 void CalibrationWindow::resizeControlSplitter()
@@ -421,21 +420,22 @@ void CalibrationWindow::resizeControlSplitter()
 	}
 }
 
-void CalibrationWindow::generateCalibrationTasks(CalibrationSet* set) const
+void CalibrationWindow::generateCalibrationTasks(int set) const
 {
 	if (!enabled) return;
-	QString basePath = projectPath + "/" + set->name + "/";
+	QString basePath = projectPath + "/" + store->setName(set) + "/";
 	QString savePath = basePath + "calibration/";
 
 	if (!QDir().exists(savePath)) QDir().mkdir(savePath);
 
-	for (int i = 0; i < set->images->size(); ++i)
+	int end = store->firstImage(set) + store->imageCount(set);
+	for (int i = store->firstImage(set); i < end; ++i)
 	{
-		if (set->images->at(i)->valid == Pending)
+		if (store->validity(i) == Pending)
 		{
-			QString left = set->images->at(i)->fileName;
+			QString left = store->fileName(i);
 
-			CalibrationImageValidityTask* task = new CalibrationImageValidityTask(basePath + left, savePath, left, set->setId, set->images->at(i)->cameraId);
+			CalibrationImageValidityTask* task = new CalibrationImageValidityTask(basePath + left, savePath, left, store->setId(set), store->cameraId(i));
 			connect(task, &CalibrationImageValidityTask::complete, this, &CalibrationWindow::imageTaskComplete);
 			connect(task, &CalibrationImageValidityTask::failed, this, &CalibrationWindow::imageTaskFailed);
 			workQueue->start(task);
@@ -445,106 +445,79 @@ void CalibrationWindow::generateCalibrationTasks(CalibrationSet* set) const
 
 void CalibrationWindow::imageTaskComplete(int set, int img)
 {
-	CalibrationSet* activeSet = model->getSet(set);
-	for (int i = 0; i < activeSet->images->size(); ++i)
-	{
-		if (activeSet->images->at(i)->cameraId == img)
-		{
-			activeSet->images->at(i)->valid = Valid;
-			break;
-		}
-	}
+	int row = store->setRow(set);
+	if (row < 0) return;
+
+	int image = store->findImage(row, img);
+	if (image >= 0) store->setValidity(image, Valid);
 
-	checkImagePairs(activeSet);
+	checkImagePairs(row);
+	model->setChanged(row);
 	configureButton->setEnabled(true);
 	confBtnEnable = true;
 }
 
 void CalibrationWindow::imageTaskFailed(int set, int img)
 {
-	CalibrationSet* activeSet = model->getSet(set);
-	for (int i = 0; i < activeSet->images->size(); ++i)
-	{
-		if (activeSet->images->at(i)->cameraId == img)
-		{
-			activeSet->images->at(i)->valid = Invalid;
-			break;
-		}
-	}
+	int row = store->setRow(set);
+	if (row < 0) return;
 
-	checkImagePairs(activeSet);
+	int image = store->findImage(row, img);
+	if (image >= 0) store->setValidity(image, Invalid);
+
+	checkImagePairs(row);
+	model->setChanged(row);
 }
 
-CalibrationSet* CalibrationWindow::generateCalibrationSet(nlohmann::json json) const
+//image validity starts from the transfer state that has already been read for the project
+void CalibrationWindow::initialiseCalibrationSet(int set) const
 {
-	CalibrationSet* newSet = new CalibrationSet();
-	newSet->setId = json["id"];
-	newSet->name = QString::fromStdString(json["path"]);
-	for (int i = 0; i < cameras->size(); ++i) newSet->pairs->push_back(Pending);
-
-	QString path = projectPath + "/" + newSet->name + "/";
-
-	for (int j = 0; j < json["images"].size(); ++j)
-	{
-		CalibrationImage* img = new CalibrationImage();
-		img->fileName = QString::fromStdString(json["images"][j]["path"]);
-		img->cameraId = json["images"][j]["id"];
-		if (!QFile().exists(path + img->fileName)) img->valid = Missing;
+	int end = store->firstImage(set) + store->imageCount(set);
+	for (int i = store->firstImage(set); i < end; ++i)
+		store->setValidity(i, store->isTransfered(i) ? Pending : Missing);
 
-		newSet->images->append(img);
-	}
-
-	checkImagePairs(newSet);
-
-	return newSet;
+	checkImagePairs(set);
 }
 
-void CalibrationWindow::checkImagePairs(CalibrationSet* set) const
+void CalibrationWindow::checkImagePairs(int set) const
 {
-	QString imagePath = projectPath + "/" + set->name + "/";
+	if (store->pairCount() != cameras->size()) return;
+
 	for (int i = 0; i < cameras->size(); ++i)
 	{
-		CalibrationImage *leftName = nullptr, *rightName = nullptr;
-
-		for (int j = 0; j < set->images->size(); ++j)
-		{
-			if (set->images->at(j)->cameraId == cameras->at(i).leftId)
-				leftName = set->images->at(j);
-			else if (set->images->at(j)->cameraId == cameras->at(i).rightId)
-				rightName = set->images->at(j);
-
-			if (leftName != nullptr && rightName != nullptr) break;
-		}
+		int left = store->findImage(set, cameras->at(i).leftId);
+		int right = store->findImage(set, cameras->at(i).rightId);
 
-		if (leftName == nullptr || rightName == nullptr)
+		if (left < 0 || right < 0)
 		{
-			set->pairs->at(i) = CalibrationValidity::Uncaptured;
-			return;
+			store->setPairValidity(set, i, CalibrationValidity::Uncaptured);
+			continue;
 		}
 
-		if (!QFile::exists(imagePath + leftName->fileName))
-			set->pairs->at(i) = CalibrationValidity::Missing;
-		else if (!QFile::exists(imagePath + rightName->fileName))
-			set->pairs->at(i) = CalibrationValidity::Missing;
+		if (!store->isTransfered(left) || !store->isTransfered(right))
+			store->setPairValidity(set, i, CalibrationValidity::Missing);
 		else
 		{
-			if (leftName->valid == Invalid || rightName->valid == Invalid)
+			if (store->validity(left) == Invalid || store->validity(right) == Invalid)
 			{
-				set->pairs->at(i) = Invalid;
+				store->setPairValidity(set, i, Invalid);
 				continue;
 			}
-			else if (leftName->valid == Valid && rightName->valid == Valid)
+			else if (store->validity(left) == Valid && store->validity(right) == Valid)
 			{
-				set->pairs->at(i) = Valid;
-				cameras->at(i).workingCount++;
+				if (store->pairValidity(set, i) != Valid)
+				{
+					cameras->at(i).workingCount++;
 
-				QStandardItem* qty = new QStandardItem(QString::number(cameras->at(i).workingCount));
-				pairModel->setItem(i, 1, qty);
+					QStandardItem* qty = new QStandardItem(QString::number(cameras->at(i).workingCount));
+					pairModel->setItem(i, 1, qty);
+				}
 
+				store->setPairValidity(set, i, Valid);
 				continue;
 			}
 
-			set->pairs->at(i) = CalibrationValidity::Pending;
+			store->setPairValidity(set, i, CalibrationValidity::Pending);
 		}
 	}
 }
@@ -3,10 +3,12 @@
 #include "ui_CalibrationWindow.h"
 #include "ScannerInteraction.h"
 #include "CalibrationListModel.h"
+#include "ProjectStore.h"
 #include "TagPushButton.h"
 #include <qthreadpool.h>
-#include "Lib/json.hpp"
 #include <QTableView>
+#include <QStandardItemModel>
+#include <QErrorMessage>
 
 QT_BEGIN_NAMESPACE
 class QGraphicsView;
@@ -23,11 +25,13 @@ public:
 	CalibrationWindow(QWidget *parent = Q_NULLPTR);
 	~CalibrationWindow();
 
-	void setConnection(ScannerInteraction* scanner) { connection = scanner; }
+	void setConnection(ScannerInteraction* scanner);
+	void setProjectStore(ProjectStore* projectStore);
 
 	public slots:
-	void projectSelected(QString project);
-	void updateProject();
+	void projectAboutToChange();
+	void projectSelected(QString project, ProjectSnapshotPtr snapshot);
+	void updateProject(QString project, ProjectSnapshotPtr snapshot);
 	void scannerConnected();
 	void scannerDisconnected();
 	void newImageTransfered(int setId, int imageId);
@@ -42,18 +46,17 @@ public:
 	void respondToScanner(ScannerCommands, QByteArray) override;
 
 private:
-	QString getProjectJsonString();
 	void processCameraPairs(QByteArray data);
 	void updateCameraImages();
 	void calculateButtonStates();
 	void resizePreviews() const;
 	void resizeEvent(QResizeEvent *event) override;
-	QString getImageName(CalibrationSet* search, int camId) const;
+	QString getImageName(int set, int camId) const;
 	void resizeControlSplitter();
 
-	CalibrationSet* generateCalibrationSet(nlohmann::json json) const;
-	void checkImagePairs(CalibrationSet* set) const;
-	void generateCalibrationTasks(CalibrationSet* set) const;
+	void initialiseCalibrationSet(int set) const;
+	void checkImagePairs(int set) const;
+	void generateCalibrationTasks(int set) const;
 
 	void imageTaskComplete(int, int);
 	void imageTaskFailed(int, int);
@@ -69,22 +72,25 @@ private:
 	QGraphicsScene *leftCam, *rightCam;
 
 	QString projectPath = "";
+	ProjectSnapshotPtr snapshot;
 	std::vector<CameraPair>* cameras = new std::vector<CameraPair>;
 	std::vector<TagPushButton*>* buttons = new std::vector<TagPushButton*>;
 
-	CalibrationSet* activeSet = nullptr;
+	ProjectStore* store = nullptr;
+	int activeSet = -1;
 	int activePair = -1;
 	QThreadPool* workQueue = new QThreadPool(this);
-	QString rawPairs = "";
 	QThread* finishThread = new QThread(this);
 
 	Ui::CalibrationWindow ui;
-	ScannerInteraction* connection;
+	ScannerInteraction* connection = nullptr;
+	QList<QMetaObject::Connection> connectionLinks;
 	QGraphicsView *leftCamView, *rightCamView;
 	QPushButton* configureButton;
 	QListView* imageSets;
 	QLayout* pairLayout;
 	QTableView* pairSummary;
 	QSplitter* summarySplitter;
+	QErrorMessage* calibrationError;
 };
 
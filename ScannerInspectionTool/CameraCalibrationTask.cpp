@@ -1,18 +1,24 @@
 #include "CameraCalibrationTask.h"
 #include <opencv2/core/mat.hpp>
-#include <QFileDialog>
+#include <QFile>
+#include <QFileInfo>
+#include <QCryptographicHash>
 #include "Lib/json.hpp"
+#include "Trace.h"
+#include "Metrics.h"
+#include "CalibrationEngine.h"
+#include "ContentStore.h"
 #include <opencv2/calib3d/calib3d_c.h>
 #include <opencv2/calib3d.hpp>
 #include <opencv2/imgcodecs.hpp>
-#include <QMessageBox>
 
 using namespace cv;
 
-CameraCalibrationTask::CameraCalibrationTask(QString savePath, vector<QString> imageLocations)
+CameraCalibrationTask::CameraCalibrationTask(QString savePath, vector<QString> imageLocations, bool yaml)
 {
 	save = savePath;
 	locations = imageLocations;
+	writeYaml = yaml;
 }
 
 CameraCalibrationTask::~CameraCalibrationTask()
@@ -21,12 +27,18 @@ CameraCalibrationTask::~CameraCalibrationTask()
 
 void CameraCalibrationTask::run()
 {
+	MetricHold busy(CalibrationEngine::busyWorkers(), CalibrationEngine::finishedTasks("camera"));
+
 	//load all the point values from files
 	vector<vector<Point2f>> pointdata = vector<vector<Point2f>>();
+	QCryptographicHash inputs(QCryptographicHash::Sha256);
 	for (int i = 0; i < locations.size(); ++i)
 	{
+		TraceSpan span("load points", "disk");
 		QString data = loadTextfile(locations.at(i));
 		if (data.isEmpty()) continue;
+		span.setBytes(data.size());
+		inputs.addData(data.toUtf8());
 		nlohmann::json jsonFile = nlohmann::json::parse(data.toStdString().c_str());
 
 		vector<Point2f> points = vector<Point2f>();
@@ -60,6 +72,7 @@ void CameraCalibrationTask::run()
 		int slash = location.count('/');
 		location = location.section('/', 0, slash - 2) + "/" + location.section('/', slash);
 
+		TraceSpan span("imread", "opencv");
 		Mat img = imread(location.toStdString());
 		imgSize = img.size();
 
@@ -67,13 +80,38 @@ void CameraCalibrationTask::run()
 			break;
 	}
 
+	//runs on a pool thread, the caller reports the failure
 	if (imgSize.width == 0 && imgSize.height == 0)
 	{
-		QMessageBox msgBox;
-		msgBox.setText("Camera failed to calibrate");
-		msgBox.exec();
+		error = "No camera image found";
+		return;
+	}
+	if (pointdata.empty())
+	{
+		error = "No valid calibration images";
+		return;
+	}
+
+	//the same points always give the same calibration, so it's kept in the content store by everything it's worked out from
+	inputs.addData(QString("%1x%2 %3x%4 %5").arg(imgSize.width).arg(imgSize.height).arg(boardWidth).arg(boardHeight).arg(squareSize).toUtf8());
+	QByteArray key = inputs.result();
+	QString kind = "camera." + QFileInfo(save).suffix();
+	QString yamlPath = save.section('.', 0, -2) + ".yml";
+	if ((!writeYaml || ContentStore::reuse(key, "camera.yml", yamlPath)) && ContentStore::reuse(key, kind, save))
+	{
+		try {
+			FileStorage fs(save.toStdString(), FileStorage::READ);
+			fs["rms"] >> rms;
+			success = true;
+			return;
+		}
+		catch (cv::Exception) {}
 	}
 
+	//kept results may be linked in from an earlier run
+	QFile::remove(save);
+	if (writeYaml) QFile::remove(yamlPath);
+
 	//calibrate the camera
 	Mat K;
 	Mat D;
@@ -81,12 +119,38 @@ void CameraCalibrationTask::run()
 	int flag = 0;
 	flag |= CV_CALIB_FIX_K4;
 	flag |= CV_CALIB_FIX_K5;
-	calibrateCamera(objectPoints, pointdata, imgSize, K, D, rvecs, tvecs, flag);
 
-	const string path = save.toStdString();
-	FileStorage fs(path, FileStorage::WRITE);
-	fs << "K" << K;
-	fs << "D" << D;
+	try {
+		{
+			TraceSpan span("calibrateCamera", "opencv");
+			rms = calibrateCamera(objectPoints, pointdata, imgSize, K, D, rvecs, tvecs, flag);
+		}
+
+		TraceSpan span("write camera result", "disk");
+		const string path = save.toStdString();
+		FileStorage fs(path, FileStorage::WRITE);
+		fs << "K" << K;
+		fs << "D" << D;
+		fs << "rms" << rms;
+
+		if (writeYaml)
+		{
+			FileStorage yaml(yamlPath.toStdString(), FileStorage::WRITE);
+			yaml << "K" << K;
+			yaml << "D" << D;
+			yaml << "rms" << rms;
+		}
+	}
+	catch (cv::Exception& e)
+	{
+		error = QString::fromStdString(e.msg);
+		return;
+	}
+
+	//the files are only complete once the storages above are closed
+	if (writeYaml) ContentStore::keep(key, "camera.yml", yamlPath);
+	ContentStore::keep(key, kind, save);
+	success = true;
 }
 
 QString CameraCalibrationTask::loadTextfile(QString path)
@@ -8,11 +8,17 @@ using namespace std;
 class CameraCalibrationTask : public QRunnable
 {
 public:
-	CameraCalibrationTask(QString savePath, std::vector<QString> imageLocations);
+	CameraCalibrationTask(QString savePath, std::vector<QString> imageLocations, bool yaml = false);
 	~CameraCalibrationTask();
 
 	void run() override;
 
+	//only valid once the task has run
+	bool succeeded() const { return success; }
+	const QString& failure() const { return error; }
+	//reprojection rms in pixels, also saved with the result
+	double reprojectionError() const { return rms; }
+
 private:
 	QString loadTextfile(QString path);
 
@@ -22,5 +28,8 @@ private:
 
 	QString save;
 	vector<QString> locations;
+	bool writeYaml;
+	bool success = false;
+	QString error;
+	double rms = 0;
 };
-
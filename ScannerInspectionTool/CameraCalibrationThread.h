@@ -1,35 +1,32 @@
 #pragma once
 #include <QObject>
 #include "JsonTypes.h"
-#include <qthreadpool.h>
+#include "ProjectSnapshot.h"
+#include <vector>
 #include "ScannerInteraction.h";
 
 using namespace std;
 
+//runs the calibration engine for the calibration window and sends the pair results to the scanner
 class CameraCalibrationThread : public QObject
 {
 	Q_OBJECT
 public:
-	CameraCalibrationThread(QString projectPath, const QString pairJson, ScannerInteraction *connector);
+	CameraCalibrationThread(QString projectPath, ProjectSnapshotPtr project, const vector<CameraPair>& cameraPairs, ScannerInteraction *connector);
 	~CameraCalibrationThread();
 
 	signals:
 	void complete();
+	void failed(QString message);
 
 	public slots:
 	void start();
 
 private:
-	void extractImages(QString projectFile);
-	void extractPairs(const QString pairJson);
-
 	QString readText(const QString path);
 
 	QString path;
+	ProjectSnapshotPtr project;
 	ScannerInteraction* connection;
-	vector<CameraPair*>* pairs = new vector<CameraPair*>();
-	map<int, vector<QString>> imageLocations = map<int, vector<QString>>();
-	map<int, QString> camNames = map<int, QString>();
-	QThreadPool* pool = new QThreadPool(this);
+	vector<CameraPair> pairs;
 };
-
@@ -0,0 +1,182 @@
+#include "ContentStore.h"
+#include <QCryptographicHash>
+#include <QFile>
+#include <QFileInfo>
+#include <qdir.h>
+#include <QStandardPaths>
+#include <QSettings>
+#include <QMutexLocker>
+
+#ifdef Q_OS_WIN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+QMutex ContentStore::lock;
+QString ContentStore::storeRoot;
+const QString ContentStore::storedKind = "stored";
+
+QString ContentStore::root()
+{
+	QMutexLocker locker(&lock);
+	//not under the app's own directory so the gui and the command line tools find the same store
+	if (storeRoot.isEmpty()) return QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + "/MultiCapture/store";
+	return storeRoot;
+}
+
+void ContentStore::setRoot(const QString& path)
+{
+	QMutexLocker locker(&lock);
+	storeRoot = path;
+}
+
+void ContentStore::loadSettings()
+{
+	QSettings settings("MultiCapture", "ScannerInspectionTool");
+	setRoot(settings.value("store/root").toString());
+}
+
+void ContentStore::saveSettings()
+{
+	QSettings settings("MultiCapture", "ScannerInspectionTool");
+	QMutexLocker locker(&lock);
+	settings.setValue("store/root", storeRoot);
+}
+
+QByteArray ContentStore::hash(const QByteArray& data)
+{
+	return QCryptographicHash::hash(data, QCryptographicHash::Sha256);
+}
+
+QByteArray ContentStore::hashFile(const QString& path)
+{
+	QFile file(path);
+	QByteArray result;
+
+	try {
+		QCryptographicHash hasher(QCryptographicHash::Sha256);
+		if (file.open(QIODevice::ReadOnly) && hasher.addData(&file))
+			result = hasher.result();
+		file.close();
+	}
+	catch (std::exception) {}
+	if (file.isOpen()) file.close();
+
+	return result;
+}
+
+QString ContentStore::blobPath(const QByteArray& hash)
+{
+	QString hex = QString::fromLatin1(hash.toHex());
+	return root() + "/blobs/" + hex.left(2) + "/" + hex;
+}
+
+bool ContentStore::contains(const QByteArray& hash, qint64 size)
+{
+	if (hash.isEmpty()) return false;
+
+	QFileInfo blob(blobPath(hash));
+	return blob.exists() && blob.size() == size;
+}
+
+bool ContentStore::add(const QByteArray& hash, const QString& path)
+{
+	QString blob = blobPath(hash);
+	QDir().mkpath(QFileInfo(blob).path());
+
+	//the same content may already have been stored through another project
+	if (contains(hash, QFileInfo(path).size())) return link(blob, path);
+	if (!link(path, blob)) return false;
+
+	mark(hash, storedKind);
+	return true;
+}
+
+bool ContentStore::checkout(const QByteArray& hash, qint64 size, const QString& target)
+{
+	QFileInfo blob(blobPath(hash));
+	if (!blob.exists() || blob.size() != size) return false;
+
+	//only a blob that may have been changed is read back, hashing every image on each link costs as much as fetching it
+	QFileInfo stamp(derivedPath(hash, storedKind));
+	bool unchanged = stamp.exists() && blob.lastModified() <= stamp.lastModified();
+	if (!unchanged && !verify(hash)) return false;
+
+	return link(blob.filePath(), target);
+}
+
+bool ContentStore::verify(const QByteArray& hash)
+{
+	QString blob = blobPath(hash);
+	if (hashFile(blob) != hash)
+	{
+		QFile::remove(blob);
+		QFile::remove(derivedPath(hash, storedKind));
+		return false;
+	}
+
+	mark(hash, storedKind);
+	return true;
+}
+
+QString ContentStore::derivedPath(const QByteArray& key, const QString& kind)
+{
+	QString hex = QString::fromLatin1(key.toHex());
+	return root() + "/derived/" + hex.left(2) + "/" + hex + "." + kind;
+}
+
+bool ContentStore::reuse(const QByteArray& key, const QString& kind, const QString& target)
+{
+	if (key.isEmpty()) return false;
+
+	QString derived = derivedPath(key, kind);
+	if (!QFile::exists(derived)) return false;
+	return link(derived, target);
+}
+
+void ContentStore::keep(const QByteArray& key, const QString& kind, const QString& source)
+{
+	if (key.isEmpty() || !QFile::exists(source)) return;
+
+	QString derived = derivedPath(key, kind);
+	QDir().mkpath(QFileInfo(derived).path());
+	link(source, derived);
+}
+
+void ContentStore::mark(const QByteArray& key, const QString& kind)
+{
+	if (key.isEmpty()) return;
+
+	QString derived = derivedPath(key, kind);
+	QDir().mkpath(QFileInfo(derived).path());
+	QFile marker(derived);
+
+	try {
+		marker.open(QIODevice::WriteOnly);
+		marker.close();
+	}
+	catch (std::exception) {}
+	if (marker.isOpen()) marker.close();
+}
+
+bool ContentStore::has(const QByteArray& key, const QString& kind)
+{
+	return !key.isEmpty() && QFile::exists(derivedPath(key, kind));
+}
+
+bool ContentStore::link(const QString& source, const QString& target)
+{
+	if (QFileInfo(source).absoluteFilePath() == QFileInfo(target).absoluteFilePath()) return true;
+	if (QFile::exists(target) && !QFile::remove(target)) return false;
+
+#ifdef Q_OS_WIN
+	bool linked = CreateHardLinkW(reinterpret_cast<const wchar_t*>(QDir::toNativeSeparators(target).utf16()),
+		reinterpret_cast<const wchar_t*>(QDir::toNativeSeparators(source).utf16()), NULL) != 0;
+#else
+	bool linked = ::link(QFile::encodeName(source).constData(), QFile::encodeName(target).constData()) == 0;
+#endif
+
+	return linked || QFile::copy(source, target);
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <QString>
+#include <QByteArray>
+#include <QMutex>
+
+//one copy of every image on this machine, stored by its sha-256 hash as <root>/blobs/<first byte>/<hash>.
+//project directories are views of the store built from hard links, so pulling a project into another root costs
+//no network or disk. results worked out from content (validation points, calibrations, previews) are kept under
+//<root>/derived by a key and a kind, and linked into the project when the same content turns up again.
+//the store should be on the same volume as the project roots, across volumes files are copied instead
+class ContentStore
+{
+public:
+	//<data>/MultiCapture/store unless set in the user's settings
+	static QString root();
+	static void setRoot(const QString& path);
+	static void loadSettings();
+	static void saveSettings();
+
+	static QByteArray hash(const QByteArray& data);
+	//empty if the file can't be read
+	static QByteArray hashFile(const QString& path);
+
+	static QString blobPath(const QByteArray& hash);
+	static bool contains(const QByteArray& hash, qint64 size);
+	//takes a verified file into the store, the file stays where it is as a link to the blob
+	static bool add(const QByteArray& hash, const QString& path);
+	//links the blob to target. a blob that isn't the size given or was modified after it was stored (written to
+	//through one of its links) is verified first, so changed content is dropped rather than spread to other projects
+	static bool checkout(const QByteArray& hash, qint64 size, const QString& target);
+	//reads the whole blob back and checks it against its hash, dropping it if it doesn't match
+	static bool verify(const QByteArray& hash);
+
+	//kind names the result and anything it depends on other than the key, "corners-9x6.conf" for example
+	static QString derivedPath(const QByteArray& key, const QString& kind);
+	//links a kept result to target, false if there isn't one
+	static bool reuse(const QByteArray& key, const QString& kind, const QString& target);
+	//keeps the file at source as the result
+	static void keep(const QByteArray& key, const QString& kind, const QString& source);
+	//results that are only an outcome, an image that isn't a calibration board for example
+	static void mark(const QByteArray& key, const QString& kind);
+	static bool has(const QByteArray& key, const QString& kind);
+
+	//hard links target to source, copying when the file system can't link. anything already at target is replaced
+	static bool link(const QString& source, const QString& target);
+
+private:
+	//derived kind of the stamp left when a blob is stored, the blob is unchanged while it's no newer than the stamp
+	static const QString storedKind;
+
+	static QMutex lock;
+	static QString storeRoot;
+};
@@ -0,0 +1,83 @@
+#include "DeviceListModel.h"
+#include <QColor>
+
+
+DeviceListModel::DeviceListModel(ScannerSessionManager* manager)
+{
+	this->manager = manager;
+	rows = manager->count();
+
+	connect(manager, &ScannerSessionManager::sessionAdded, this, &DeviceListModel::sessionAdded);
+	connect(manager, &ScannerSessionManager::sessionChanged, this, &DeviceListModel::sessionChanged);
+	connect(manager, &ScannerSessionManager::sessionRemoved, this, &DeviceListModel::sessionRemoved);
+}
+
+DeviceListModel::~DeviceListModel()
+{
+}
+
+int DeviceListModel::rowCount(const QModelIndex& parent) const
+{
+	if (parent.isValid()) return 0;
+	return rows;
+}
+
+QVariant DeviceListModel::data(const QModelIndex& index, int role) const
+{
+	ScannerSession* session = getSession(index);
+	if (session == nullptr) return QVariant();
+
+	switch (role)
+	{
+	case Qt::DisplayRole:
+		if (!session->isConnected()) return session->name() + " (Disconnected)";
+		return session->name() + " (" + formatThroughput(session->throughput()) + ")";
+	case Qt::ToolTipRole:
+		return session->address().toString();
+	case Qt::ForegroundRole:
+		return session->isConnected() ? QColor(0, 128, 0) : QColor(237, 20, 61);
+	default:
+		return QVariant();
+	}
+}
+
+ScannerSession* DeviceListModel::getSession(const QModelIndex& index) const
+{
+	if (!index.isValid() || index.row() >= manager->count()) return nullptr;
+	return manager->session(index.row());
+}
+
+QModelIndex DeviceListModel::indexOf(ScannerSession* session) const
+{
+	int row = manager->indexOf(session);
+	if (row < 0) return QModelIndex();
+
+	return createIndex(row, 0);
+}
+
+void DeviceListModel::sessionAdded(int index)
+{
+	beginInsertRows(QModelIndex(), index, index);
+	rows++;
+	endInsertRows();
+}
+
+void DeviceListModel::sessionChanged(int index)
+{
+	QModelIndex changed = createIndex(index, 0);
+	emit dataChanged(changed, changed);
+}
+
+void DeviceListModel::sessionRemoved(int index)
+{
+	beginRemoveRows(QModelIndex(), index, index);
+	rows--;
+	endRemoveRows();
+}
+
+QString DeviceListModel::formatThroughput(double bytesPerSecond)
+{
+	if (bytesPerSecond < 1024) return QString::number(bytesPerSecond, 'f', 0) + " B/s";
+	if (bytesPerSecond < 1024 * 1024) return QString::number(bytesPerSecond / 1024, 'f', 1) + " KB/s";
+	return QString::number(bytesPerSecond / (1024 * 1024), 'f', 1) + " MB/s";
+}
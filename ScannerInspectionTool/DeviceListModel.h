@@ -0,0 +1,30 @@
+#pragma once
+#include <qabstractitemmodel.h>
+#include "ScannerSessionManager.h"
+
+//device list showing each scanner session with its connection state and throughput
+class DeviceListModel : public QAbstractListModel
+{
+	Q_OBJECT
+
+public:
+	DeviceListModel(ScannerSessionManager* manager);
+	~DeviceListModel();
+
+	int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+	QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+	ScannerSession* getSession(const QModelIndex& index) const;
+	QModelIndex indexOf(ScannerSession* session) const;
+
+	private slots:
+	void sessionAdded(int index);
+	void sessionChanged(int index);
+	void sessionRemoved(int index);
+
+private:
+	static QString formatThroughput(double bytesPerSecond);
+
+	ScannerSessionManager* manager;
+	int rows = 0;
+};
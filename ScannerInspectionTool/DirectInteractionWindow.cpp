@@ -2,6 +2,8 @@
 #include "ScannerInteraction.h"
 #include "ScannerInspectionTool.h"
 #include "parameterBuilder.h"
+#include <QStandardItemModel>
+#include <QTableView>
 
 DirectInteractionWindow::DirectInteractionWindow(QWidget *parent)
 	: QWidget(parent)
@@ -14,6 +16,12 @@ DirectInteractionWindow::DirectInteractionWindow(QWidget *parent)
 	apiResponse = findChild<QPlainTextEdit*>("apiResponse");
 	parameters = findChild<QLineEdit*>("parameterInput");
 
+	linkStats = findChild<QTableView*>("linkStats");
+	statsModel = new QStandardItemModel(this);
+	statsModel->setHorizontalHeaderLabels(QStringList() << "Command" << "Replies" << "Compressed" << "Wire KB"
+		<< "Payload KB" << "Ratio" << "Transfer ms" << "Decompress ms" << "Decompress errors");
+	linkStats->setModel(statsModel);
+
 	connect(submit, &QPushButton::released, this, &DirectInteractionWindow::makeRequest);
 }
 
@@ -21,11 +29,23 @@ DirectInteractionWindow::~DirectInteractionWindow()
 {
 }
 
+void DirectInteractionWindow::setConnection(ScannerInteraction* scanner)
+{
+	disconnect(statisticsLink);
+	connection = scanner;
+	if (connection != nullptr)
+		statisticsLink = connect(connection, &ScannerInteraction::statisticsUpdated, this, &DirectInteractionWindow::refreshStatistics, Qt::QueuedConnection);
+
+	if (isVisible()) refreshStatistics();
+}
+
 void DirectInteractionWindow::makeRequest()
 {
 	ScannerCommands command = ScannerCommands(apiSelection->value());
 	apiResponse->setPlainText("No Data Recieved");
-	emit connection->requestScanner(command, parameters->text(), this);
+	if (connection == nullptr) return;
+	//whatever the command, someone is waiting on it
+	emit connection->requestScanner(command, parameters->text(), this, TrafficClass::Interactive);
 }
 
 void DirectInteractionWindow::respondToScanner(ScannerCommands command, QByteArray data)
@@ -33,3 +53,33 @@ void DirectInteractionWindow::respondToScanner(ScannerCommands command, QByteArr
 	apiCode->setText(QString(std::to_string(static_cast<int>(command)).c_str()));
 	apiResponse->setPlainText(data);
 }
+
+//averages are per reply so slow links and expensive decompression stand out
+void DirectInteractionWindow::refreshStatistics()
+{
+	if (!isVisible()) return;
+
+	QMap<int, CommandStatistics> stats;
+	if (connection != nullptr) stats = connection->statistics();
+	statsModel->setRowCount(stats.size());
+
+	int row = 0;
+	for (QMap<int, CommandStatistics>::const_iterator it = stats.constBegin(); it != stats.constEnd(); ++it, ++row)
+	{
+		const CommandStatistics& entry = it.value();
+		double replies = qMax<qint64>(entry.replies, 1);
+
+		statsModel->setItem(row, 0, new QStandardItem(QString::number(it.key())));
+		statsModel->setItem(row, 1, new QStandardItem(QString::number(entry.replies)));
+		statsModel->setItem(row, 2, new QStandardItem(QString::number(entry.compressedReplies)));
+		statsModel->setItem(row, 3, new QStandardItem(QString::number(entry.wireBytes / 1024.0, 'f', 1)));
+		statsModel->setItem(row, 4, new QStandardItem(QString::number(entry.payloadBytes / 1024.0, 'f', 1)));
+		statsModel->setItem(row, 5, new QStandardItem(entry.wireBytes == 0 ? "-" :
+			QString::number(double(entry.payloadBytes) / entry.wireBytes, 'f', 2)));
+		statsModel->setItem(row, 6, new QStandardItem(QString::number(entry.transferNs / replies / 1000000.0, 'f', 2)));
+		statsModel->setItem(row, 7, new QStandardItem(QString::number(entry.decompressNs / replies / 1000000.0, 'f', 2)));
+		statsModel->setItem(row, 8, new QStandardItem(QString::number(entry.decompressFailures)));
+	}
+
+	linkStats->resizeColumnsToContents();
+}
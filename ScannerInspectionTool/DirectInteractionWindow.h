@@ -6,6 +6,8 @@
 QT_BEGIN_NAMESPACE
 class QSpinBox;
 class QPlainTextEdit;
+class QTableView;
+class QStandardItemModel;
 class ScannerInteraction;
 QT_END_NAMESPACE
 
@@ -17,15 +19,15 @@ public:
 	DirectInteractionWindow(QWidget *parent = Q_NULLPTR);
 	~DirectInteractionWindow();
 
-	void setConnection(ScannerInteraction* scanner) { connection = scanner; }
+	void setConnection(ScannerInteraction* scanner);
 
 	public slots:
 	void makeRequest();
+	void refreshStatistics();
 
 	private slots:
 	void respondToScanner(ScannerCommands, QByteArray) override;
 
-
 private:
 	Ui::DirectInteractionWindow ui;
 
@@ -34,6 +36,9 @@ private:
 	QPushButton* submit;
 	QPlainTextEdit* apiResponse;
 	QLineEdit* parameters;
+	QTableView* linkStats;
+	QStandardItemModel* statsModel;
 
-	ScannerInteraction* connection;
+	ScannerInteraction* connection = nullptr;
+	QMetaObject::Connection statisticsLink;
 };
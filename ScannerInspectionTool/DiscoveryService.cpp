@@ -0,0 +1,118 @@
+#include "DiscoveryService.h"
+#include <QUdpSocket>
+#include <QTimer>
+#include "ScannerDeviceInformation.h"
+
+
+DiscoveryService::DiscoveryService()
+{
+	//parented so they move to the discovery thread with the service
+	broadcastSocket = new QUdpSocket(this);
+	listenSocket = new QUdpSocket(this);
+
+	broadcastTimer = new QTimer(this);
+	broadcastTimer->setSingleShot(true);
+	connect(broadcastTimer, &QTimer::timeout, this, &DiscoveryService::broadcast);
+
+	expiryTimer = new QTimer(this);
+	connect(expiryTimer, &QTimer::timeout, this, &DiscoveryService::expireDevices);
+
+	interval = minInterval;
+}
+
+DiscoveryService::~DiscoveryService()
+{
+}
+
+QString DiscoveryService::deviceId(const QHostAddress& address)
+{
+	//ipv4 replies can arrive as ipv4 mapped ipv6 addresses
+	bool ok = false;
+	quint32 ip4 = address.toIPv4Address(&ok);
+	if (ok) return QHostAddress(ip4).toString();
+
+	return address.toString();
+}
+
+//runs once the discovery thread has started
+void DiscoveryService::start()
+{
+	clock.start();
+
+	listenSocket->bind(listenPort, QUdpSocket::ShareAddress);
+	connect(listenSocket, &QUdpSocket::readyRead, this, &DiscoveryService::readResponses);
+
+	expiryTimer->start(minInterval * 4);
+	broadcast();
+}
+
+void DiscoveryService::rediscover()
+{
+	interval = minInterval;
+	broadcast();
+}
+
+void DiscoveryService::broadcast()
+{
+	broadcastSocket->writeDatagram(datagram.data(), datagram.size(), QHostAddress::Broadcast, broadcastPort);
+
+	broadcastTimer->start(interval);
+	interval = qMin(interval * 2, maxInterval);
+}
+
+void DiscoveryService::readResponses()
+{
+	while (listenSocket->hasPendingDatagrams()) {
+		processData(listenSocket->receiveDatagram());
+	}
+}
+
+void DiscoveryService::processData(const QNetworkDatagram& data)
+{
+	QString id = deviceId(data.senderAddress());
+	QString name = data.data();
+
+	QHash<QString, DiscoveredDevice>::iterator existing = devices.find(id);
+	if (existing != devices.end())
+	{
+		existing->lastSeen = clock.elapsed();
+		if (existing->name == name) return;
+
+		existing->name = name;
+		emit deviceRenamed(id, name);
+		return;
+	}
+
+	devices.insert(id, DiscoveredDevice{ name, clock.elapsed() });
+
+	ScannerDeviceInformation* device = new ScannerDeviceInformation();
+	device->name = name;
+	device->address = QHostAddress(id);
+	emit deviceFound(device);
+
+	//something changed, look again soon in case more scanners are coming up
+	if (interval > minInterval * 4)
+	{
+		interval = minInterval;
+		broadcastTimer->start(interval);
+	}
+}
+
+void DiscoveryService::expireDevices()
+{
+	qint64 now = clock.elapsed();
+
+	QHash<QString, DiscoveredDevice>::iterator it = devices.begin();
+	while (it != devices.end())
+	{
+		if (now - it->lastSeen < deviceTtl)
+		{
+			++it;
+			continue;
+		}
+
+		QString id = it.key();
+		it = devices.erase(it);
+		emit deviceLost(id);
+	}
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <QObject>
+#include <QHash>
+#include <QElapsedTimer>
+#include <QNetworkDatagram>
+
+class ScannerDeviceInformation;
+QT_BEGIN_NAMESPACE
+class QUdpSocket;
+class QTimer;
+QT_END_NAMESPACE
+
+//finds scanners on the network and keeps track of which are still there.
+//devices are keyed by address, which stays the same when a scanner is renamed.
+//broadcasts start fast and back off while nothing changes, a device that hasn't answered
+//within the ttl is reported as lost
+class DiscoveryService : public QObject
+{
+	Q_OBJECT
+
+public:
+	DiscoveryService();
+	~DiscoveryService();
+
+	static QString deviceId(const QHostAddress& address);
+
+	public slots:
+	void start();
+	//broadcast now and go back to the fastest interval
+	void rediscover();
+
+signals:
+	void deviceFound(ScannerDeviceInformation*);
+	void deviceRenamed(QString id, QString name);
+	void deviceLost(QString id);
+
+	private slots:
+	void broadcast();
+	void readResponses();
+	void expireDevices();
+
+private:
+	struct DiscoveredDevice
+	{
+		QString name;
+		qint64 lastSeen;
+	};
+
+	void processData(const QNetworkDatagram& data);
+
+	QHash<QString, DiscoveredDevice> devices;
+	QElapsedTimer clock;
+
+	QUdpSocket* broadcastSocket;
+	QUdpSocket* listenSocket;
+	QTimer* broadcastTimer;
+	QTimer* expiryTimer;
+	int interval;
+
+	const QByteArray datagram = "InspectionApp";
+	const qint16 broadcastPort = 8470;
+	const qint16 listenPort = 8471;
+	const int minInterval = 500; //0.5sec
+	const int maxInterval = 30000; //30sec
+	const qint64 deviceTtl = 95000; //three missed broadcasts at the slowest interval
+};
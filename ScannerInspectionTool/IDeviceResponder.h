@@ -3,6 +3,7 @@
 enum class ScannerCommands;
 class QByteArray;
 
+//implemented by QObjects, a responder destroyed while its request is in flight never sees the reply
 class IDeviceResponder
 {
 public:
@@ -0,0 +1,114 @@
+#include "JsonStream.h"
+
+
+bool JsonStream::parse(const QByteArray& data, ReplyEncoding encoding)
+{
+	keys.clear();
+	pendingKey.clear();
+	if (data.isEmpty()) return false;
+
+	if (encoding != ReplyEncoding::Json)
+	{
+		//errors are always sent as text
+		if (data.startsWith("Fail")) return false;
+
+		try {
+			replay(decode(data, encoding), "");
+		}
+		catch (std::exception) {
+			return false;
+		}
+
+		return true;
+	}
+
+	try {
+		nlohmann::json::parse(data.constData(), data.constData() + data.size(),
+			[this](int depth, nlohmann::json::parse_event_t event, nlohmann::json& parsed) { return this->event(depth, event, parsed); });
+	}
+	catch (std::exception) {
+		return false;
+	}
+
+	return true;
+}
+
+bool JsonStream::event(int depth, nlohmann::json::parse_event_t event, nlohmann::json& parsed)
+{
+	switch (event)
+	{
+	case nlohmann::json::parse_event_t::key:
+		pendingKey = parsed.get<std::string>();
+		//the value is still parsed (and reported) but never added to the object
+		return false;
+	case nlohmann::json::parse_event_t::object_start:
+		keys.push_back(pendingKey);
+		pendingKey.clear();
+		startObject();
+		//must be kept or the parser stops reporting the contents
+		return true;
+	case nlohmann::json::parse_event_t::array_start:
+		keys.push_back(pendingKey);
+		pendingKey.clear();
+		startArray();
+		return true;
+	case nlohmann::json::parse_event_t::object_end:
+		endObject();
+		keys.pop_back();
+		return false;
+	case nlohmann::json::parse_event_t::array_end:
+		endArray();
+		keys.pop_back();
+		return false;
+	case nlohmann::json::parse_event_t::value:
+		value(pendingKey, parsed);
+		pendingKey.clear();
+		return false;
+	}
+
+	return false;
+}
+
+QByteArray JsonStream::toJson(const QByteArray& data, ReplyEncoding encoding)
+{
+	if (encoding == ReplyEncoding::Json) return data;
+
+	try {
+		return QByteArray::fromStdString(decode(data, encoding).dump());
+	}
+	catch (std::exception) {
+		return QByteArray();
+	}
+}
+
+nlohmann::json JsonStream::decode(const QByteArray& data, ReplyEncoding encoding)
+{
+	std::vector<uint8_t> bytes = std::vector<uint8_t>(data.constData(), data.constData() + data.size());
+
+	if (encoding == ReplyEncoding::MsgPack) return nlohmann::json::from_msgpack(bytes);
+	return nlohmann::json::from_cbor(bytes);
+}
+
+//walks a decoded document producing the same events the parser callback would
+void JsonStream::replay(const nlohmann::json& node, const std::string& key)
+{
+	if (node.is_object())
+	{
+		keys.push_back(key);
+		startObject();
+		for (nlohmann::json::const_iterator it = node.begin(); it != node.end(); ++it)
+			replay(it.value(), it.key());
+		endObject();
+		keys.pop_back();
+	}
+	else if (node.is_array())
+	{
+		keys.push_back(key);
+		startArray();
+		for (int i = 0; i < node.size(); ++i)
+			replay(node[i], "");
+		endArray();
+		keys.pop_back();
+	}
+	else value(key, node);
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <QByteArray>
+#include <string>
+#include <vector>
+#include "Lib/json.hpp"
+#include "ReplyEncoding.h"
+
+//reads a json reply as a stream of events without building the document.
+//the bundled json.hpp has no SAX interface so this is built on its parser callback, every value is
+//handed to the reader and then discarded, leaving only one scalar alive at a time.
+//binary (cbor/msgpack) replies are decoded by json.hpp first and then replayed as the same events.
+class JsonStream
+{
+public:
+	virtual ~JsonStream() {}
+
+	//returns false if the data isn't valid for the encoding (a "Fail?" reply for example)
+	bool parse(const QByteArray& data, ReplyEncoding encoding = ReplyEncoding::Json);
+
+	//converts a binary reply into a json document
+	static QByteArray toJson(const QByteArray& data, ReplyEncoding encoding);
+
+protected:
+	//keys of the containers the parser is inside, starting with the root. array elements have an empty key
+	const std::vector<std::string>& path() const { return keys; }
+	int depth() const { return int(keys.size()); }
+	//true when the container at the top of the path is stored under key in its parent
+	bool inside(const char* key, int level) const { return depth() > level && keys[level] == key; }
+
+	virtual void startObject() {}
+	virtual void endObject() {}
+	virtual void startArray() {}
+	virtual void endArray() {}
+	virtual void value(const std::string& key, const nlohmann::json& value) = 0;
+
+private:
+	static nlohmann::json decode(const QByteArray& data, ReplyEncoding encoding);
+	void replay(const nlohmann::json& node, const std::string& key);
+	bool event(int depth, nlohmann::json::parse_event_t event, nlohmann::json& parsed);
+
+	std::vector<std::string> keys;
+	std::string pendingKey;
+};
@@ -1,25 +1,8 @@
 #pragma once
-#include <QStandardItemModel.h>
+#include <QtGlobal>
+#include <QByteArray>
 
-struct Set;
-struct Image
-{
-	int cameraId;
-	QString fileName;
-
-	QStandardItem* item;
-};
-
-struct Set
-{
-	int setId;
-	QString name;
-	QList<Image*>* images = new QList<Image*>();
-
-	QStandardItem* item;
-};
-
-enum CalibrationValidity
+enum CalibrationValidity : quint8
 {
 	Pending,
 	Valid,
@@ -28,23 +11,16 @@ enum CalibrationValidity
 	Missing
 };
 
-struct CalibrationImage
-{
-	int cameraId;
-	QString fileName;
-	CalibrationValidity valid = Pending;
-};
-
 struct CameraPair
 {
 	int leftId, rightId, id, workingCount;
 	CalibrationValidity valid = Pending;
 };
 
-struct CalibrationSet
+//what the scanner has for one image of a set, scanners that don't send it leave the size at -1
+struct ImageContent
 {
-	int setId;
-	QString name;
-	QList<CalibrationImage*>* images = new QList<CalibrationImage*>();
-	std::vector<CalibrationValidity>* pairs = new std::vector<CalibrationValidity>();
-};
\ No newline at end of file
+	int cameraId = -1;
+	qint64 size = -1;
+	QByteArray hash; //raw sha-256
+};
@@ -0,0 +1,382 @@
+#include "LogArchive.h"
+#include <QFile>
+#include <QHash>
+#include <QVector>
+#include <QDataStream>
+#include <QDateTime>
+#include <QStandardPaths>
+#include <algorithm>
+#include <iterator>
+
+//one segment file and its index, line numbers are positions within the segment
+class LogSegment
+{
+public:
+	int number;
+	bool sealed = false;
+	qint64 size = 0;
+	QVector<qint64> offsets;
+	QVector<qint64> times;
+	QHash<QString, QVector<quint32>> postings;
+
+	void add(qint64 offset, qint64 time, const QString& text)
+	{
+		quint32 line = quint32(offsets.size());
+		offsets.append(offset);
+		times.append(time);
+
+		QStringList tokens = LogArchive::tokenize(text);
+		for (int i = 0; i < tokens.size(); ++i)
+		{
+			QVector<quint32>& list = postings[tokens[i]];
+			if (list.isEmpty() || list.last() != line) list.append(line);
+		}
+	}
+
+	//reads the segment file and indexes every line in it
+	void rebuild(QFile& file)
+	{
+		offsets.clear();
+		times.clear();
+		postings.clear();
+
+		file.seek(0);
+		while (!file.atEnd())
+		{
+			qint64 offset = file.pos();
+			QString record = QString::fromUtf8(file.readLine());
+			if (!record.endsWith('\n')) break; //partly written line
+
+			int tab = record.indexOf('\t');
+			if (tab < 0) continue;
+
+			add(offset, record.left(tab).toLongLong(), record.mid(tab + 1, record.length() - tab - 2));
+		}
+
+		size = file.pos();
+	}
+
+	bool loadIndex(const QString& path)
+	{
+		QFile file(path);
+		if (!file.open(QIODevice::ReadOnly)) return false;
+
+		QDataStream stream(&file);
+		stream >> size >> offsets >> times >> postings;
+		return stream.status() == QDataStream::Ok;
+	}
+
+	void saveIndex(const QString& path) const
+	{
+		QFile file(path);
+
+		try {
+			if (!file.open(QIODevice::WriteOnly)) return;
+			QDataStream stream(&file);
+			stream << size << offsets << times << postings;
+			file.close();
+		}
+		catch (std::exception) {}
+		if (file.isOpen()) file.close();
+	}
+
+	qint64 firstTime() const { return times.isEmpty() ? 0 : times.first(); }
+	qint64 lastTime() const { return times.isEmpty() ? 0 : times.last(); }
+};
+
+namespace
+{
+	//the line of a "<time>\t<line>\n" record
+	QString recordText(const QString& record)
+	{
+		int tab = record.indexOf('\t');
+		return record.mid(tab + 1, record.length() - tab - 2);
+	}
+
+	QVector<quint32> intersect(const QVector<quint32>& a, const QVector<quint32>& b)
+	{
+		QVector<quint32> result;
+		std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(result));
+		return result;
+	}
+
+	//lines of a segment matching one query term
+	QVector<quint32> termLines(const LogSegment* segment, const QString& term)
+	{
+		if (!term.endsWith('*')) return segment->postings.value(term);
+
+		QString prefix = term.left(term.length() - 1);
+		QVector<quint32> result;
+		for (QHash<QString, QVector<quint32>>::const_iterator it = segment->postings.constBegin(); it != segment->postings.constEnd(); ++it)
+		{
+			if (!it.key().startsWith(prefix)) continue;
+
+			QVector<quint32> merged;
+			std::set_union(result.begin(), result.end(), it.value().begin(), it.value().end(), std::back_inserter(merged));
+			result.swap(merged);
+		}
+
+		return result;
+	}
+}
+
+
+LogArchive::LogArchive(const QString& directory)
+{
+	this->directory = QDir(directory);
+	if (!this->directory.exists()) QDir().mkpath(directory);
+
+	open();
+}
+
+LogArchive::~LogArchive()
+{
+	if (activeFile != nullptr) activeFile->close();
+	delete activeFile;
+
+	for (int i = 0; i < segments.size(); ++i)
+		delete segments[i];
+	segments.clear();
+}
+
+QString LogArchive::defaultDirectory(const QString& deviceId)
+{
+	QString device = deviceId;
+	device.replace(':', '_');
+
+	return QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + "/logs/" + device;
+}
+
+QStringList LogArchive::tokenize(const QString& text)
+{
+	QStringList tokens;
+
+	int start = -1;
+	for (int i = 0; i <= text.length(); ++i)
+	{
+		bool word = i < text.length() && text[i].isLetterOrNumber();
+		if (word && start < 0) start = i;
+		else if (!word && start >= 0)
+		{
+			tokens.append(text.mid(start, i - start).toLower());
+			start = -1;
+		}
+	}
+
+	return tokens;
+}
+
+//loads the saved indexes of the sealed segments and reindexes the one still being written
+void LogArchive::open()
+{
+	QStringList files = directory.entryList(QStringList() << "segment-*.log", QDir::Files);
+
+	QList<int> numbers;
+	for (int i = 0; i < files.size(); ++i)
+		numbers.append(files[i].mid(8, files[i].length() - 12).toInt());
+	std::sort(numbers.begin(), numbers.end());
+
+	for (int i = 0; i < numbers.size(); ++i)
+	{
+		LogSegment* segment = new LogSegment();
+		segment->number = numbers[i];
+
+		bool last = i == numbers.size() - 1;
+		if (!last && segment->loadIndex(indexPath(segment->number)))
+		{
+			segment->sealed = true;
+			segments.append(segment);
+			continue;
+		}
+
+		QFile file(segmentPath(segment->number));
+		if (file.open(QIODevice::ReadOnly)) segment->rebuild(file);
+		segments.append(segment);
+
+		if (!last)
+		{
+			segment->sealed = true;
+			segment->saveIndex(indexPath(segment->number));
+		}
+	}
+
+	if (segments.isEmpty()) startSegment(0);
+	else
+	{
+		LogSegment* active = segments.last();
+		activeFile = new QFile(segmentPath(active->number));
+		activeFile->open(QIODevice::ReadWrite);
+		//drop a line cut off part way through
+		activeFile->resize(active->size);
+		activeFile->seek(active->size);
+
+		lastTime = active->lastTime();
+		if (!active->offsets.isEmpty())
+		{
+			activeFile->seek(active->offsets[qMax(0, active->offsets.size() - matchLines)]);
+			while (activeFile->pos() < active->size)
+				lastLines.append(recordText(QString::fromUtf8(activeFile->readLine())));
+			activeFile->seek(active->size);
+		}
+	}
+}
+
+void LogArchive::startSegment(int number)
+{
+	LogSegment* segment = new LogSegment();
+	segment->number = number;
+	segments.append(segment);
+
+	delete activeFile;
+	activeFile = new QFile(segmentPath(number));
+	activeFile->open(QIODevice::ReadWrite | QIODevice::Truncate);
+}
+
+void LogArchive::sealActive()
+{
+	LogSegment* active = segments.last();
+	activeFile->close();
+
+	active->sealed = true;
+	active->saveIndex(indexPath(active->number));
+
+	startSegment(active->number + 1);
+}
+
+void LogArchive::append(const QStringList& lines)
+{
+	if (lines.isEmpty() || activeFile == nullptr || !activeFile->isOpen()) return;
+
+	//times only go forward so a segment can be searched by time with a binary search
+	lastTime = qMax(lastTime, QDateTime::currentMSecsSinceEpoch());
+
+	try {
+		for (int i = 0; i < lines.size(); ++i)
+		{
+			LogSegment* active = segments.last();
+			if (active->offsets.size() >= maxSegmentLines || active->size >= maxSegmentSize)
+			{
+				sealActive();
+				active = segments.last();
+			}
+
+			QString text = lines[i];
+			text.replace('\n', ' ');
+
+			QByteArray record = QByteArray::number(lastTime) + '\t' + text.toUtf8() + '\n';
+			activeFile->write(record);
+
+			active->add(active->size, lastTime, text);
+			active->size += record.size();
+			lastLines.append(text);
+		}
+
+		while (lastLines.size() > matchLines) lastLines.removeFirst();
+
+		activeFile->flush();
+	}
+	catch (std::exception) {}
+}
+
+void LogArchive::appendSnapshot(const QStringList& lines)
+{
+	if (lastLines.isEmpty())
+	{
+		append(lines);
+		return;
+	}
+
+	//the latest place the archived lines end, near the start of the snapshot only the lines it still holds are compared
+	for (int last = lines.size() - 1; last >= 0; --last)
+	{
+		int count = qMin(lastLines.size(), last + 1);
+		bool match = true;
+		for (int i = 0; i < count && match; ++i)
+			match = lines[last - i] == lastLines[lastLines.size() - 1 - i];
+		if (!match) continue;
+
+		append(lines.mid(last + 1));
+		return;
+	}
+
+	append(lines);
+}
+
+QList<ArchivedLine> LogArchive::search(const QString& query, qint64 from, qint64 to, int limit) const
+{
+	QList<ArchivedLine> results;
+
+	QStringList terms;
+	QStringList words = query.split(' ', QString::SkipEmptyParts);
+	for (int i = 0; i < words.size(); ++i)
+	{
+		QStringList tokens = tokenize(words[i]);
+		if (words[i].endsWith('*') && !tokens.isEmpty()) tokens.last() += '*';
+		terms.append(tokens);
+	}
+
+	for (int s = segments.size() - 1; s >= 0 && results.size() < limit; --s)
+	{
+		const LogSegment* segment = segments[s];
+		if (segment->times.isEmpty()) continue;
+		if (segment->lastTime() < from || segment->firstTime() > to) continue;
+
+		//lines inside the time range
+		quint32 low = quint32(std::lower_bound(segment->times.begin(), segment->times.end(), from) - segment->times.begin());
+		quint32 high = quint32(std::upper_bound(segment->times.begin(), segment->times.end(), to) - segment->times.begin());
+		if (low >= high) continue;
+
+		QVector<quint32> lines;
+		if (terms.isEmpty())
+		{
+			for (quint32 i = low; i < high; ++i) lines.append(i);
+		}
+		else
+		{
+			//start from the rarest term so the intersections stay small
+			QList<QVector<quint32>> lists;
+			for (int t = 0; t < terms.size(); ++t) lists.append(termLines(segment, terms[t]));
+			std::sort(lists.begin(), lists.end(), [](const QVector<quint32>& a, const QVector<quint32>& b) { return a.size() < b.size(); });
+
+			lines = lists[0];
+			for (int t = 1; t < lists.size() && !lines.isEmpty(); ++t)
+				lines = intersect(lines, lists[t]);
+		}
+
+		if (lines.isEmpty()) continue;
+
+		QFile file(segmentPath(segment->number));
+		if (!file.open(QIODevice::ReadOnly)) continue;
+
+		for (int i = lines.size() - 1; i >= 0 && results.size() < limit; --i)
+		{
+			quint32 line = lines[i];
+			if (line < low || line >= high) continue;
+
+			file.seek(segment->offsets[line]);
+			QString record = QString::fromUtf8(file.readLine());
+			results.append(ArchivedLine{ segment->times[line], recordText(record) });
+		}
+	}
+
+	return results;
+}
+
+qint64 LogArchive::lineCount() const
+{
+	qint64 count = 0;
+	for (int i = 0; i < segments.size(); ++i)
+		count += segments[i]->offsets.size();
+
+	return count;
+}
+
+QString LogArchive::segmentPath(int number) const
+{
+	return directory.filePath("segment-" + QString::number(number) + ".log");
+}
+
+QString LogArchive::indexPath(int number) const
+{
+	return directory.filePath("segment-" + QString::number(number) + ".idx");
+}
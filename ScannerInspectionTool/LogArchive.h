@@ -0,0 +1,58 @@
+#pragma once
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <qdir.h>
+
+class LogSegment;
+QT_BEGIN_NAMESPACE
+class QFile;
+QT_END_NAMESPACE
+
+struct ArchivedLine
+{
+	qint64 time; //msecs since epoch when the line was received
+	QString text;
+};
+
+//append only store of every log line received from one scanner.
+//lines are written to numbered segment files as "<time>\t<line>", each segment keeps the time of every line
+//and an inverted index of its tokens. a full segment is sealed and its index saved next to it so the
+//archive opens without reading old segments again
+class LogArchive
+{
+public:
+	LogArchive(const QString& directory);
+	~LogArchive();
+
+	static QString defaultDirectory(const QString& deviceId);
+	//lowercased runs of letters and digits
+	static QStringList tokenize(const QString& text);
+
+	void append(const QStringList& lines);
+	//a full log from the scanner, only the lines after the last archived ones are added.
+	//the scanner repeats lines, so the snapshot is matched on several of the latest lines rather than one
+	void appendSnapshot(const QStringList& lines);
+
+	//lines received between from and to holding every term of the query, newest first.
+	//a term ending in * matches any token starting with it
+	QList<ArchivedLine> search(const QString& query, qint64 from, qint64 to, int limit = 5000) const;
+	qint64 lineCount() const;
+
+private:
+	void open();
+	void startSegment(int number);
+	void sealActive();
+	QString segmentPath(int number) const;
+	QString indexPath(int number) const;
+
+	QDir directory;
+	QList<LogSegment*> segments;
+	QFile* activeFile = nullptr;
+	QStringList lastLines; //the latest archived lines, newest last
+	qint64 lastTime = 0;
+
+	const int maxSegmentLines = 65536;
+	const int matchLines = 8;
+	const qint64 maxSegmentSize = 8 * 1024 * 1024; //8Mb
+};
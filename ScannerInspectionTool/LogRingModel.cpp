@@ -0,0 +1,118 @@
+#include "LogRingModel.h"
+
+
+LogRingModel::LogRingModel(int capacity)
+{
+	this->capacity = quint64(qMax(capacity, 1));
+	lines.resize(int(this->capacity));
+}
+
+LogRingModel::~LogRingModel()
+{
+}
+
+int LogRingModel::rowCount(const QModelIndex& parent) const
+{
+	if (parent.isValid()) return 0;
+	return filtering() ? int(matched.size()) : lineCount();
+}
+
+QVariant LogRingModel::data(const QModelIndex& index, int role) const
+{
+	if (role != Qt::DisplayRole || !index.isValid()) return QVariant();
+	if (index.row() >= rowCount()) return QVariant();
+
+	quint64 sequence = filtering() ? matched[index.row()] : first + index.row();
+	return line(sequence);
+}
+
+void LogRingModel::append(const QStringList& newLines)
+{
+	if (newLines.isEmpty()) return;
+
+	//only the newest lines fit
+	int start = 0;
+	if (quint64(newLines.size()) > capacity) start = newLines.size() - int(capacity);
+	int amount = newLines.size() - start;
+
+	quint64 overflow = next - first + amount;
+	if (overflow > capacity) dropOldest(int(overflow - capacity));
+
+	if (!filtering())
+	{
+		beginInsertRows(QModelIndex(), lineCount(), lineCount() + amount - 1);
+		for (int i = start; i < newLines.size(); ++i)
+			lines[int(next++ % capacity)] = newLines[i];
+		endInsertRows();
+		return;
+	}
+
+	int firstRow = int(matched.size());
+	std::vector<quint64> found;
+	for (int i = start; i < newLines.size(); ++i, ++next)
+	{
+		lines[int(next % capacity)] = newLines[i];
+		if (matches(newLines[i])) found.push_back(next);
+	}
+
+	if (found.empty()) return;
+
+	beginInsertRows(QModelIndex(), firstRow, firstRow + int(found.size()) - 1);
+	matched.insert(matched.end(), found.begin(), found.end());
+	endInsertRows();
+}
+
+//the slots are reused so only the rows need to go
+void LogRingModel::dropOldest(int amount)
+{
+	quint64 newFirst = first + amount;
+
+	if (!filtering())
+	{
+		beginRemoveRows(QModelIndex(), 0, amount - 1);
+		first = newFirst;
+		endRemoveRows();
+		return;
+	}
+
+	int rows = 0;
+	while (rows < int(matched.size()) && matched[rows] < newFirst) ++rows;
+
+	if (rows > 0)
+	{
+		beginRemoveRows(QModelIndex(), 0, rows - 1);
+		matched.erase(matched.begin(), matched.begin() + rows);
+		first = newFirst;
+		endRemoveRows();
+	}
+	else first = newFirst;
+}
+
+void LogRingModel::clear()
+{
+	beginResetModel();
+
+	for (quint64 i = first; i < next; ++i)
+		lines[int(i % capacity)].clear();
+	first = next;
+	matched.clear();
+
+	endResetModel();
+}
+
+void LogRingModel::setFilter(const QString& text)
+{
+	if (text == filterText) return;
+
+	beginResetModel();
+
+	filterText = text;
+	matched.clear();
+	if (filtering())
+	{
+		for (quint64 i = first; i < next; ++i)
+			if (matches(line(i))) matched.push_back(i);
+	}
+
+	endResetModel();
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <qabstractitemmodel.h>
+#include <QVector>
+#include <deque>
+
+//scanner log lines kept in a fixed size ring, the oldest lines are dropped once it is full.
+//lines are addressed by a running sequence number so appending never moves the existing lines.
+//a filter keeps the sequence numbers of the matching lines, only new lines are checked as they arrive
+class LogRingModel : public QAbstractListModel
+{
+	Q_OBJECT
+
+public:
+	LogRingModel(int capacity = 200000);
+	~LogRingModel();
+
+	int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+	QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+	void append(const QStringList& lines);
+	void clear();
+	int lineCount() const { return int(next - first); }
+
+	//case insensitive, an empty filter shows every line
+	void setFilter(const QString& text);
+	QString filter() const { return filterText; }
+
+private:
+	const QString& line(quint64 sequence) const { return lines[int(sequence % capacity)]; }
+	bool matches(const QString& text) const { return text.contains(filterText, Qt::CaseInsensitive); }
+	bool filtering() const { return !filterText.isEmpty(); }
+	void dropOldest(int amount);
+
+	QVector<QString> lines;
+	quint64 capacity;
+	quint64 first = 0; //oldest line held
+	quint64 next = 0; //sequence the next line will get
+
+	QString filterText;
+	std::deque<quint64> matched;
+};
@@ -0,0 +1,71 @@
+#include "LogTail.h"
+#include "ReplyReader.h"
+
+
+LogTail::LogTail(ScannerInteraction* connector, const QString& archiveDirectory, QObject* parent) : QObject(parent)
+{
+	this->connector = connector;
+	model = new LogRingModel();
+	archive = new LogArchive(archiveDirectory);
+
+	timer = new QTimer(this);
+	connect(timer, &QTimer::timeout, this, &LogTail::refresh);
+	connect(connector, &ScannerInteraction::scannerConnected, this, &LogTail::scannerConnected);
+	connect(connector, &ScannerInteraction::scannerConnectionLost, this, &LogTail::scannerDisconnected);
+}
+
+LogTail::~LogTail()
+{
+	delete model;
+	delete archive;
+}
+
+void LogTail::refresh()
+{
+	//one request at a time, a slow reply shouldn't stack up more behind it
+	if (pending && requested.elapsed() < replyTimeout) return;
+	if (!connector->isConnected()) return;
+
+	pending = true;
+	requested.start();
+	connector->requestScanner(ScannerCommands::getRecentLogDiff, "", this);
+}
+
+void LogTail::respondToScanner(ScannerCommands command, QByteArray data)
+{
+	switch (command)
+	{
+	case ScannerCommands::getRecentLogFile:
+	case ScannerCommands::getRecentLogDiff:
+		break;
+	default:
+		return;
+	}
+
+	pending = false;
+
+	QStringList lines;
+	if (!ReplyReader::readStrings(data, lines, connector->replyEncoding())) return;
+
+	model->append(lines);
+
+	//the full log repeats lines archived during earlier connections
+	if (command == ScannerCommands::getRecentLogFile) archive->appendSnapshot(lines);
+	else archive->append(lines);
+}
+
+void LogTail::scannerConnected()
+{
+	model->clear();
+
+	pending = true;
+	requested.start();
+	connector->requestScanner(ScannerCommands::getRecentLogFile, "", this);
+	timer->start(pollInterval);
+}
+
+void LogTail::scannerDisconnected()
+{
+	timer->stop();
+	pending = false;
+}
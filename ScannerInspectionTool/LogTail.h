@@ -0,0 +1,42 @@
+#pragma once
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include "IDeviceResponder.h"
+#include "ScannerInteraction.h"
+#include "LogRingModel.h"
+#include "LogArchive.h"
+
+//keeps the log of one scanner up to date while it is connected,
+//the whole log is read on connection and then only the lines added since the last request.
+//every line is also kept in the scanner's log archive
+class LogTail : public QObject, public IDeviceResponder
+{
+	Q_OBJECT
+
+public:
+	LogTail(ScannerInteraction* connector, const QString& archiveDirectory, QObject* parent = Q_NULLPTR);
+	~LogTail();
+
+	LogRingModel* getModel() const { return model; }
+	LogArchive* getArchive() const { return archive; }
+
+	public slots:
+	void refresh();
+	void respondToScanner(ScannerCommands, QByteArray) override;
+
+	private slots:
+	void scannerConnected();
+	void scannerDisconnected();
+
+private:
+	ScannerInteraction* connector;
+	LogRingModel* model;
+	LogArchive* archive;
+	QTimer* timer;
+	bool pending = false;
+	QElapsedTimer requested;
+
+	const int pollInterval = 2000; //2sec
+	const int replyTimeout = 10000; //10sec, empty replies never reach the responder
+};
@@ -0,0 +1,157 @@
+#include "MemoryBudget.h"
+#include <QSettings>
+#include "Metrics.h"
+
+QMutex MemoryBudget::waitLock;
+QWaitCondition MemoryBudget::released;
+
+namespace
+{
+	const qint64 megabyte = 1024 * 1024;
+
+	qint64 defaultBudget(MemoryCategory category)
+	{
+		switch (category)
+		{
+		case MemoryCategory::Network: return 256 * megabyte;
+		case MemoryCategory::Decode: return 1024 * megabyte;
+		case MemoryCategory::Pixmap: return 256 * megabyte;
+		default: return 0;
+		}
+	}
+
+	struct MemoryGauges
+	{
+		MetricGauge* used[int(MemoryCategory::Count)];
+		MetricGauge* budget[int(MemoryCategory::Count)];
+	};
+
+	//created together the first time any is needed, from whichever thread that is
+	const MemoryGauges& gauges()
+	{
+		static const MemoryGauges all = []() {
+			MemoryGauges created = MemoryGauges();
+			for (int i = 0; i < int(MemoryCategory::Count); ++i)
+			{
+				QString labels = "category=\"" + MemoryBudget::name(MemoryCategory(i)) + "\"";
+				created.used[i] = Metrics::gauge("memory_used_bytes", "Bytes held by the image heavy parts of the tool", labels);
+				created.budget[i] = Metrics::gauge("memory_budget_bytes", "Memory budget of each category, 0 is no limit", labels);
+				created.budget[i]->add(defaultBudget(MemoryCategory(i)));
+			}
+			return created;
+		}();
+		return all;
+	}
+}
+
+QString MemoryBudget::name(MemoryCategory category)
+{
+	switch (category)
+	{
+	case MemoryCategory::Network: return "network";
+	case MemoryCategory::Decode: return "decode";
+	case MemoryCategory::Pixmap: return "pixmap";
+	case MemoryCategory::Model: return "model";
+	default: return "unknown";
+	}
+}
+
+qint64 MemoryBudget::used(MemoryCategory category)
+{
+	return gauges().used[int(category)]->current();
+}
+
+qint64 MemoryBudget::budget(MemoryCategory category)
+{
+	return gauges().budget[int(category)]->current();
+}
+
+void MemoryBudget::setBudget(MemoryCategory category, qint64 bytes)
+{
+	if (bytes < 0) bytes = 0;
+	MetricGauge* gauge = gauges().budget[int(category)];
+	gauge->add(bytes - gauge->current());
+
+	//a larger budget may let waiting decodes start
+	QMutexLocker lock(&waitLock);
+	released.wakeAll();
+}
+
+bool MemoryBudget::exceeded(MemoryCategory category)
+{
+	qint64 limit = budget(category);
+	return limit > 0 && used(category) > limit;
+}
+
+bool MemoryBudget::fits(MemoryCategory category, qint64 bytes)
+{
+	qint64 limit = budget(category);
+	return limit <= 0 || used(category) + bytes <= limit;
+}
+
+void MemoryBudget::charge(MemoryCategory category, qint64 bytes)
+{
+	gauges().used[int(category)]->add(bytes);
+}
+
+void MemoryBudget::release(MemoryCategory category, qint64 bytes)
+{
+	if (bytes == 0) return;
+	gauges().used[int(category)]->add(-bytes);
+
+	QMutexLocker lock(&waitLock);
+	released.wakeAll();
+}
+
+void MemoryBudget::acquire(MemoryCategory category, qint64 bytes)
+{
+	QMutexLocker lock(&waitLock);
+	while (!fits(category, bytes) && used(category) > 0)
+		released.wait(&waitLock);
+
+	charge(category, bytes);
+}
+
+void MemoryBudget::loadSettings()
+{
+	QSettings settings("MultiCapture", "ScannerInspectionTool");
+	settings.beginGroup("memory");
+	for (int i = 0; i < int(MemoryCategory::Count); ++i)
+	{
+		MemoryCategory category = MemoryCategory(i);
+		if (settings.contains(name(category)))
+			setBudget(category, settings.value(name(category)).toLongLong());
+	}
+	settings.endGroup();
+}
+
+void MemoryBudget::saveSettings()
+{
+	QSettings settings("MultiCapture", "ScannerInspectionTool");
+	settings.beginGroup("memory");
+	for (int i = 0; i < int(MemoryCategory::Count); ++i)
+		settings.setValue(name(MemoryCategory(i)), budget(MemoryCategory(i)));
+	settings.endGroup();
+}
+
+
+MemoryCharge::MemoryCharge(MemoryCategory category, qint64 bytes, bool wait)
+{
+	this->category = category;
+	this->bytes = bytes;
+
+	if (wait) MemoryBudget::acquire(category, bytes);
+	else MemoryBudget::charge(category, bytes);
+}
+
+MemoryCharge::~MemoryCharge()
+{
+	MemoryBudget::release(category, bytes);
+}
+
+void MemoryCharge::resize(qint64 bytes)
+{
+	if (bytes > this->bytes) MemoryBudget::charge(category, bytes - this->bytes);
+	else MemoryBudget::release(category, this->bytes - bytes);
+	this->bytes = bytes;
+}
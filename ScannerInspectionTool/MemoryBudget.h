@@ -0,0 +1,61 @@
+#pragma once
+#include <QString>
+#include <QMutex>
+#include <QWaitCondition>
+
+enum class MemoryCategory
+{
+	Network, //replies being read or waiting for their responder
+	Decode, //images decoded by the calibration tasks
+	Pixmap, //preview images kept for the views
+	Model, //project stores
+	Count
+};
+
+//bytes held by the image heavy parts of the tool, against a budget per category. the used and budget figures are
+//also metrics (memory_used_bytes, memory_budget_bytes). a budget of 0 means no limit.
+//going over budget never fails an allocation, the owners hold back instead: connections stop sending requests,
+//decodes wait for room and caches evict
+class MemoryBudget
+{
+public:
+	static QString name(MemoryCategory category);
+
+	static qint64 used(MemoryCategory category);
+	static qint64 budget(MemoryCategory category);
+	static void setBudget(MemoryCategory category, qint64 bytes);
+	static bool exceeded(MemoryCategory category);
+	//room for this many more bytes
+	static bool fits(MemoryCategory category, qint64 bytes);
+
+	static void charge(MemoryCategory category, qint64 bytes);
+	static void release(MemoryCategory category, qint64 bytes);
+	//charges once there's room, or straight away when nothing else is charged so a single large item still goes through
+	static void acquire(MemoryCategory category, qint64 bytes);
+
+	//budgets are kept in the user's settings between runs
+	static void loadSettings();
+	static void saveSettings();
+
+private:
+	static QMutex waitLock;
+	static QWaitCondition released;
+};
+
+//bytes charged to a category for as long as it lives
+class MemoryCharge
+{
+public:
+	MemoryCharge(MemoryCategory category, qint64 bytes = 0, bool wait = false);
+	~MemoryCharge();
+
+	//charges the difference, never waits
+	void resize(qint64 bytes);
+	qint64 size() const { return bytes; }
+
+private:
+	Q_DISABLE_COPY(MemoryCharge)
+
+	MemoryCategory category;
+	qint64 bytes;
+};
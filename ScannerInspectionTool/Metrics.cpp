@@ -0,0 +1,220 @@
+#include "Metrics.h"
+#include <QMutex>
+#include <QMap>
+#include <cmath>
+
+namespace
+{
+	enum class MetricType
+	{
+		Counter,
+		Gauge,
+		Histogram
+	};
+
+	struct MetricFamily
+	{
+		QString help;
+		MetricType type;
+		QMap<QString, void*> series; //keyed by labels
+	};
+
+	QMutex registryLock;
+	QMap<QString, MetricFamily> families;
+
+	void* find(const QString& name, const QString& help, const QString& labels, MetricType type)
+	{
+		QMutexLocker lock(&registryLock);
+		MetricFamily& family = families[name];
+		if (family.series.isEmpty())
+		{
+			family.help = help;
+			family.type = type;
+		}
+
+		void*& metric = family.series[labels];
+		if (metric != nullptr) return metric;
+
+		switch (type)
+		{
+		case MetricType::Counter:
+			metric = new MetricCounter();
+			break;
+		case MetricType::Gauge:
+			metric = new MetricGauge();
+			break;
+		case MetricType::Histogram:
+			metric = new MetricHistogram(Metrics::latencyBounds());
+			break;
+		}
+		return metric;
+	}
+
+	QByteArray series(const QString& name, const QString& labels, const QString& extra = QString())
+	{
+		QString all = labels;
+		if (!extra.isEmpty()) all += (all.isEmpty() ? "" : ",") + extra;
+		return (all.isEmpty() ? name : name + "{" + all + "}").toUtf8();
+	}
+
+	QByteArray number(double value)
+	{
+		if (std::isinf(value)) return "+Inf";
+		return QByteArray::number(value, 'g', 12);
+	}
+}
+
+MetricHistogram::MetricHistogram(const std::vector<double>& bounds)
+{
+	this->bounds = bounds;
+	counts = new QAtomicInteger<qint64>[bounds.size() + 1];
+}
+
+MetricHistogram::~MetricHistogram()
+{
+	delete[] counts;
+}
+
+void MetricHistogram::observe(double value)
+{
+	size_t bucket = 0;
+	while (bucket < bounds.size() && value > bounds[bucket]) bucket++;
+
+	counts[bucket].fetchAndAddRelaxed(1);
+	sumMicro.fetchAndAddRelaxed(qint64(value * 1000000.0));
+}
+
+MetricHistogram::Snapshot MetricHistogram::snapshot() const
+{
+	Snapshot snap = Snapshot();
+	snap.bounds = bounds;
+	snap.counts.resize(bounds.size() + 1);
+
+	for (size_t i = 0; i <= bounds.size(); ++i)
+	{
+		snap.counts[i] = counts[i].loadAcquire();
+		snap.count += snap.counts[i];
+	}
+	snap.sum = sumMicro.loadAcquire() / 1000000.0;
+	return snap;
+}
+
+double MetricHistogram::Snapshot::quantile(double q) const
+{
+	if (count <= 0) return 0;
+
+	//linear inside the bucket the quantile lands in, the top bucket has no upper bound so its lower one is used
+	double rank = q * count;
+	qint64 below = 0;
+	for (size_t i = 0; i < counts.size(); ++i)
+	{
+		if (below + counts[i] < rank)
+		{
+			below += counts[i];
+			continue;
+		}
+
+		if (i >= bounds.size()) return bounds.empty() ? 0 : bounds.back();
+		double lower = i == 0 ? 0 : bounds[i - 1];
+		return lower + (bounds[i] - lower) * (rank - below) / counts[i];
+	}
+	return bounds.empty() ? 0 : bounds.back();
+}
+
+MetricHistogram::Snapshot MetricHistogram::Snapshot::since(const Snapshot& earlier) const
+{
+	Snapshot difference = *this;
+	if (earlier.counts.size() != counts.size()) return difference;
+
+	for (size_t i = 0; i < counts.size(); ++i)
+		difference.counts[i] -= earlier.counts[i];
+	difference.count -= earlier.count;
+	difference.sum -= earlier.sum;
+	return difference;
+}
+
+MetricCounter* Metrics::counter(const QString& name, const QString& help, const QString& labels)
+{
+	return static_cast<MetricCounter*>(find(name, help, labels, MetricType::Counter));
+}
+
+MetricGauge* Metrics::gauge(const QString& name, const QString& help, const QString& labels)
+{
+	return static_cast<MetricGauge*>(find(name, help, labels, MetricType::Gauge));
+}
+
+MetricHistogram* Metrics::histogram(const QString& name, const QString& help, const QString& labels)
+{
+	return static_cast<MetricHistogram*>(find(name, help, labels, MetricType::Histogram));
+}
+
+MetricHistogram::Snapshot Metrics::histogramTotal(const QString& name)
+{
+	MetricHistogram::Snapshot total = MetricHistogram::Snapshot();
+	total.bounds = latencyBounds();
+	total.counts.assign(total.bounds.size() + 1, 0);
+
+	QMutexLocker lock(&registryLock);
+	if (!families.contains(name) || families[name].type != MetricType::Histogram) return total;
+
+	const QMap<QString, void*>& series = families[name].series;
+	for (QMap<QString, void*>::const_iterator entry = series.constBegin(); entry != series.constEnd(); ++entry)
+	{
+		MetricHistogram::Snapshot snap = static_cast<MetricHistogram*>(entry.value())->snapshot();
+		for (size_t i = 0; i < snap.counts.size(); ++i)
+			total.counts[i] += snap.counts[i];
+		total.count += snap.count;
+		total.sum += snap.sum;
+	}
+	return total;
+}
+
+const std::vector<double>& Metrics::latencyBounds()
+{
+	static const std::vector<double> bounds = { 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10, 30 };
+	return bounds;
+}
+
+QByteArray Metrics::prometheusText()
+{
+	QByteArray text;
+
+	QMutexLocker lock(&registryLock);
+	for (QMap<QString, MetricFamily>::const_iterator family = families.constBegin(); family != families.constEnd(); ++family)
+	{
+		const QString& name = family.key();
+		const char* type = family->type == MetricType::Counter ? "counter" : family->type == MetricType::Gauge ? "gauge" : "histogram";
+		text += "# HELP " + name.toUtf8() + " " + family->help.toUtf8() + "\n";
+		text += "# TYPE " + name.toUtf8() + " " + type + "\n";
+
+		for (QMap<QString, void*>::const_iterator entry = family->series.constBegin(); entry != family->series.constEnd(); ++entry)
+		{
+			const QString& labels = entry.key();
+			switch (family->type)
+			{
+			case MetricType::Counter:
+				text += series(name, labels) + " " + QByteArray::number(static_cast<MetricCounter*>(entry.value())->total()) + "\n";
+				break;
+			case MetricType::Gauge:
+				text += series(name, labels) + " " + QByteArray::number(static_cast<MetricGauge*>(entry.value())->current()) + "\n";
+				break;
+			case MetricType::Histogram:
+			{
+				MetricHistogram::Snapshot snap = static_cast<MetricHistogram*>(entry.value())->snapshot();
+				qint64 cumulative = 0;
+				for (size_t i = 0; i < snap.counts.size(); ++i)
+				{
+					cumulative += snap.counts[i];
+					double bound = i < snap.bounds.size() ? snap.bounds[i] : INFINITY;
+					text += series(name + "_bucket", labels, "le=\"" + QString(number(bound)) + "\"") + " " + QByteArray::number(cumulative) + "\n";
+				}
+				text += series(name + "_sum", labels) + " " + number(snap.sum) + "\n";
+				text += series(name + "_count", labels) + " " + QByteArray::number(snap.count) + "\n";
+				break;
+			}
+			}
+		}
+	}
+
+	return text;
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include <QAtomicInteger>
+#include <QByteArray>
+#include <QString>
+#include <vector>
+
+//a value that only goes up, rates come from the difference between two reads
+class MetricCounter
+{
+public:
+	void add(qint64 amount = 1) { value.fetchAndAddRelaxed(amount); }
+	qint64 total() const { return value.loadAcquire(); }
+
+private:
+	QAtomicInteger<qint64> value = QAtomicInteger<qint64>(0);
+};
+
+//a value that goes up and down. several owners can share one by adding and removing their part
+class MetricGauge
+{
+public:
+	void add(qint64 amount) { value.fetchAndAddRelaxed(amount); }
+	qint64 current() const { return value.loadAcquire(); }
+
+private:
+	QAtomicInteger<qint64> value = QAtomicInteger<qint64>(0);
+};
+
+//holds one on a gauge for as long as it lives, like a worker being busy, and counts it as done when released
+class MetricHold
+{
+public:
+	MetricHold(MetricGauge* gauge, MetricCounter* done = nullptr) : gauge(gauge), done(done) { gauge->add(1); }
+	~MetricHold()
+	{
+		gauge->add(-1);
+		if (done != nullptr) done->add();
+	}
+
+private:
+	MetricGauge* gauge;
+	MetricCounter* done;
+};
+
+//counts of observations under each bound, read as a whole with snapshot
+class MetricHistogram
+{
+public:
+	struct Snapshot
+	{
+		std::vector<double> bounds;
+		std::vector<qint64> counts; //per bucket, the last one is everything over the top bound
+		qint64 count = 0;
+		double sum = 0;
+
+		//estimate from the buckets, 0 when empty
+		double quantile(double q) const;
+		//observations since an earlier snapshot of the same histogram
+		Snapshot since(const Snapshot& earlier) const;
+	};
+
+	explicit MetricHistogram(const std::vector<double>& bounds);
+	~MetricHistogram();
+
+	void observe(double value);
+	Snapshot snapshot() const;
+
+private:
+	Q_DISABLE_COPY(MetricHistogram)
+
+	std::vector<double> bounds;
+	QAtomicInteger<qint64>* counts;
+	QAtomicInteger<qint64> sumMicro = QAtomicInteger<qint64>(0); //sum in millionths, doubles can't be added atomically
+};
+
+//process wide registry of the counters, gauges and histograms the tool keeps about itself.
+//a metric is looked up by name and labels (prometheus style, like command="3"), created the first time and kept
+//until the process exits, so callers can hold on to the pointer. updating one never takes a lock
+class Metrics
+{
+public:
+	static MetricCounter* counter(const QString& name, const QString& help, const QString& labels = QString());
+	static MetricGauge* gauge(const QString& name, const QString& help, const QString& labels = QString());
+	static MetricHistogram* histogram(const QString& name, const QString& help, const QString& labels = QString());
+
+	//every series of a histogram added together, empty when there are none
+	static MetricHistogram::Snapshot histogramTotal(const QString& name);
+
+	//bounds in seconds used by every histogram, 1ms to 30s
+	static const std::vector<double>& latencyBounds();
+
+	//prometheus text exposition format
+	static QByteArray prometheusText();
+};
@@ -0,0 +1,217 @@
+#include "MetricsPanel.h"
+#include <QGridLayout>
+#include <QLabel>
+#include <QPainter>
+#include <QSpinBox>
+#include <QDoubleSpinBox>
+#include <QTimer>
+#include "ScannerInteraction.h"
+#include "TransferEngine.h"
+#include "CalibrationEngine.h"
+#include "PreviewCache.h"
+
+
+MetricChart::MetricChart(QWidget* parent) : QWidget(parent)
+{
+	samples.reserve(sampleCount);
+	setMinimumSize(80, 24);
+	setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Preferred);
+}
+
+void MetricChart::append(double value)
+{
+	if (samples.size() >= sampleCount) samples.removeFirst();
+	samples.append(value);
+	update();
+}
+
+void MetricChart::paintEvent(QPaintEvent*)
+{
+	QPainter painter(this);
+	painter.fillRect(rect(), palette().base());
+	if (samples.size() < 2) return;
+
+	double top = 0;
+	for (int i = 0; i < samples.size(); ++i)
+		top = qMax(top, samples[i]);
+	if (top <= 0) top = 1;
+
+	//newest sample on the right edge, one step per sample
+	double step = double(width() - 1) / (sampleCount - 1);
+	double left = width() - 1 - step * (samples.size() - 1);
+	QPolygonF line;
+	for (int i = 0; i < samples.size(); ++i)
+		line << QPointF(left + step * i, height() - 1 - (height() - 2) * samples[i] / top);
+
+	painter.setRenderHint(QPainter::Antialiasing);
+	painter.setPen(QPen(palette().highlight(), 1.5));
+	painter.drawPolyline(line);
+}
+
+
+MetricsPanel::MetricsPanel(QWidget* parent) : QDockWidget("Metrics", parent)
+{
+	setObjectName("metricsPanel");
+
+	QWidget* content = new QWidget(this);
+	QGridLayout* layout = new QGridLayout(content);
+	layout->setColumnStretch(2, 1);
+	setWidget(content);
+
+	addRow(Download, "Download");
+	addRateLimit();
+	addRow(Images, "Images");
+	addRow(Remaining, "Remaining");
+	addRow(InFlight, "Requests in flight");
+	addRow(Latency, "Reply time (p95)");
+	addRow(ValidationQueue, "Validation queue");
+	addRow(Tasks, "Calibration tasks");
+	addRow(Utilisation, "Worker utilisation");
+	addMemoryRow(NetworkMemory, "Reply memory", MemoryCategory::Network);
+	addMemoryRow(DecodeMemory, "Decoded images", MemoryCategory::Decode);
+	addMemoryRow(PixmapMemory, "Preview images", MemoryCategory::Pixmap);
+	addMemoryRow(ModelMemory, "Project models", MemoryCategory::Model);
+	layout->setRowStretch(RowCount, 1);
+
+	receivedBytes = ScannerInteraction::receivedBytesTotal();
+	images = TransferEngine::imagesTransfered();
+	remaining = TransferEngine::imagesRemaining();
+	inFlight = ScannerInteraction::requestsInFlight();
+	validationQueue = CalibrationEngine::validationQueue();
+	busyWorkers = CalibrationEngine::busyWorkers();
+	workers = CalibrationEngine::workers();
+
+	lastBytes = receivedBytes->total();
+	lastImages = images->total();
+	lastLatency = Metrics::histogramTotal("scanner_request_seconds");
+
+	timer = new QTimer(this);
+	timer->setInterval(1000);
+	connect(timer, &QTimer::timeout, this, &MetricsPanel::sample);
+	timer->start();
+}
+
+MetricsPanel::~MetricsPanel()
+{
+	delete timer;
+}
+
+void MetricsPanel::addRow(Row row, const QString& name)
+{
+	QGridLayout* layout = static_cast<QGridLayout*>(widget()->layout());
+
+	values[row] = new QLabel(widget());
+	values[row]->setMinimumWidth(120);
+	charts[row] = new MetricChart(widget());
+
+	layout->addWidget(new QLabel(name, widget()), row, 0);
+	layout->addWidget(values[row], row, 1);
+	layout->addWidget(charts[row], row, 2);
+}
+
+//the budget in MB next to the usage, 0 for no limit
+void MetricsPanel::addMemoryRow(Row row, const QString& name, MemoryCategory category)
+{
+	addRow(row, name);
+
+	QSpinBox* budget = new QSpinBox(widget());
+	budget->setRange(0, 1024 * 1024);
+	budget->setSuffix(" MB");
+	budget->setSpecialValueText("No limit");
+	budget->setToolTip("Memory budget");
+	budget->setValue(int(MemoryBudget::budget(category) / (1024 * 1024)));
+	connect(budget, &QSpinBox::editingFinished, this, &MetricsPanel::budgetChanged);
+
+	budgets[int(category)] = budget;
+	static_cast<QGridLayout*>(widget()->layout())->addWidget(budget, row, 3);
+}
+
+//the limit in MB/s next to the download speed, 0 for no limit
+void MetricsPanel::addRateLimit()
+{
+	rateLimit = new QDoubleSpinBox(widget());
+	rateLimit->setRange(0, 10000);
+	rateLimit->setDecimals(1);
+	rateLimit->setSuffix(" MB/s");
+	rateLimit->setSpecialValueText("No limit");
+	rateLimit->setToolTip("Download rate limit, interactive requests are never held back");
+	rateLimit->setValue(TrafficShaper::rate() / (1024.0 * 1024.0));
+	connect(rateLimit, &QDoubleSpinBox::editingFinished, this, &MetricsPanel::rateLimitChanged);
+
+	static_cast<QGridLayout*>(widget()->layout())->addWidget(rateLimit, Download, 3);
+}
+
+void MetricsPanel::rateLimitChanged()
+{
+	TrafficShaper::setRate(qint64(rateLimit->value() * 1024 * 1024));
+	TrafficShaper::saveSettings();
+}
+
+void MetricsPanel::budgetChanged()
+{
+	for (int i = 0; i < int(MemoryCategory::Count); ++i)
+		MemoryBudget::setBudget(MemoryCategory(i), qint64(budgets[i]->value()) * 1024 * 1024);
+	MemoryBudget::saveSettings();
+
+	PreviewCache::trim();
+}
+
+void MetricsPanel::display(Row row, double value, const QString& text)
+{
+	values[row]->setText(text);
+	charts[row]->append(value);
+}
+
+void MetricsPanel::sample()
+{
+	qint64 bytes = receivedBytes->total();
+	double megabytes = (bytes - lastBytes) / (1024.0 * 1024.0);
+	display(Download, megabytes, QString::number(megabytes, 'f', 2) + " MB/s");
+	lastBytes = bytes;
+
+	qint64 imageTotal = images->total();
+	qint64 newImages = imageTotal - lastImages;
+	display(Images, newImages, QString::number(newImages) + " /s");
+	lastImages = imageTotal;
+
+	//eta from the last 10 seconds so a single slow image doesn't swing it
+	recentImages.append(newImages);
+	if (recentImages.size() > 10) recentImages.removeFirst();
+	qint64 recent = 0;
+	for (int i = 0; i < recentImages.size(); ++i)
+		recent += recentImages[i];
+
+	qint64 left = remaining->current();
+	QString eta = "";
+	if (left > 0 && recent > 0)
+	{
+		qint64 seconds = left * recentImages.size() / recent;
+		eta = QString(", %1:%2").arg(seconds / 60).arg(seconds % 60, 2, 10, QChar('0'));
+	}
+	display(Remaining, left, QString::number(left) + eta);
+
+	display(InFlight, inFlight->current(), QString::number(inFlight->current()));
+
+	MetricHistogram::Snapshot latency = Metrics::histogramTotal("scanner_request_seconds");
+	double p95 = latency.since(lastLatency).quantile(0.95) * 1000;
+	display(Latency, p95, QString::number(p95, 'f', 1) + " ms");
+	lastLatency = latency;
+
+	display(ValidationQueue, validationQueue->current(), QString::number(validationQueue->current()));
+
+	qint64 tasks = CalibrationEngine::finishedTasks("validate")->total() + CalibrationEngine::finishedTasks("camera")->total()
+		+ CalibrationEngine::finishedTasks("pair")->total();
+	display(Tasks, tasks - lastTasks, QString::number(tasks - lastTasks) + " /s");
+	lastTasks = tasks;
+
+	double utilisation = workers->current() > 0 ? 100.0 * busyWorkers->current() / workers->current() : 0;
+	display(Utilisation, utilisation, QString::number(utilisation, 'f', 0) + "%");
+
+	for (int i = 0; i < int(MemoryCategory::Count); ++i)
+	{
+		double used = MemoryBudget::used(MemoryCategory(i)) / (1024.0 * 1024.0);
+		QString text = QString::number(used, 'f', 1) + " MB";
+		if (MemoryBudget::exceeded(MemoryCategory(i))) text += " (over)";
+		display(Row(NetworkMemory + i), used, text);
+	}
+}
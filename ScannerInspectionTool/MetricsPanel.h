@@ -0,0 +1,90 @@
+#pragma once
+#include <QDockWidget>
+#include <QVector>
+#include "Metrics.h"
+#include "MemoryBudget.h"
+
+QT_BEGIN_NAMESPACE
+class QLabel;
+class QTimer;
+class QSpinBox;
+class QDoubleSpinBox;
+QT_END_NAMESPACE
+
+//rolling line of the last samples of one value, scaled to the largest one shown
+class MetricChart : public QWidget
+{
+public:
+	MetricChart(QWidget* parent = Q_NULLPTR);
+
+	void append(double value);
+	QSize sizeHint() const override { return QSize(160, 36); }
+
+protected:
+	void paintEvent(QPaintEvent* event) override;
+
+private:
+	static const int sampleCount = 120;
+
+	QVector<double> samples;
+};
+
+//live throughput of transfers and calibration and the memory held, sampled from the metrics registry once a second.
+//the memory budgets and the download rate limit are set from here
+class MetricsPanel : public QDockWidget
+{
+	Q_OBJECT
+
+public:
+	MetricsPanel(QWidget* parent = Q_NULLPTR);
+	~MetricsPanel();
+
+	private slots:
+	void sample();
+	void budgetChanged();
+	void rateLimitChanged();
+
+private:
+	enum Row
+	{
+		Download,
+		Images,
+		Remaining,
+		InFlight,
+		Latency,
+		ValidationQueue,
+		Tasks,
+		Utilisation,
+		NetworkMemory,
+		DecodeMemory,
+		PixmapMemory,
+		ModelMemory,
+		RowCount
+	};
+
+	void addRow(Row row, const QString& name);
+	void addMemoryRow(Row row, const QString& name, MemoryCategory category);
+	void addRateLimit();
+	void display(Row row, double value, const QString& text);
+
+	QTimer* timer;
+	QLabel* values[RowCount];
+	MetricChart* charts[RowCount];
+	QSpinBox* budgets[int(MemoryCategory::Count)];
+	QDoubleSpinBox* rateLimit;
+
+	MetricCounter* receivedBytes;
+	MetricCounter* images;
+	MetricGauge* remaining;
+	MetricGauge* inFlight;
+	MetricGauge* validationQueue;
+	MetricGauge* busyWorkers;
+	MetricGauge* workers;
+
+	//totals at the last sample, rates are the difference
+	qint64 lastBytes = 0;
+	qint64 lastImages = 0;
+	qint64 lastTasks = 0;
+	MetricHistogram::Snapshot lastLatency;
+	QVector<qint64> recentImages; //images per sample over the last 10s, for the eta
+};
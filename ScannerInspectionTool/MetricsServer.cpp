@@ -0,0 +1,67 @@
+#include "MetricsServer.h"
+#include <QTcpServer>
+#include <QTcpSocket>
+#include "Metrics.h"
+
+
+MetricsServer::MetricsServer(QObject* parent) : QObject(parent)
+{
+	server = new QTcpServer(this);
+	connect(server, &QTcpServer::newConnection, this, &MetricsServer::acceptConnections);
+}
+
+MetricsServer::~MetricsServer()
+{
+	delete server;
+}
+
+bool MetricsServer::listen(quint16 port, const QHostAddress& address)
+{
+	if (server->isListening()) server->close();
+	return server->listen(address, port);
+}
+
+void MetricsServer::close()
+{
+	server->close();
+}
+
+bool MetricsServer::isListening() const
+{
+	return server->isListening();
+}
+
+QString MetricsServer::errorString() const
+{
+	return server->errorString();
+}
+
+void MetricsServer::acceptConnections()
+{
+	while (server->hasPendingConnections())
+	{
+		QTcpSocket* client = server->nextPendingConnection();
+		connect(client, &QTcpSocket::readyRead, this, &MetricsServer::readRequest);
+		connect(client, &QTcpSocket::disconnected, client, &QObject::deleteLater);
+	}
+}
+
+//waits for the end of the request headers, the request itself doesn't matter
+void MetricsServer::readRequest()
+{
+	QTcpSocket* client = qobject_cast<QTcpSocket*>(sender());
+	if (client == nullptr) return;
+
+	QByteArray request = client->peek(maxRequestLength);
+	if (!request.contains("\r\n\r\n") && !request.contains("\n\n") && request.size() < maxRequestLength) return;
+	client->readAll();
+
+	QByteArray body = Metrics::prometheusText();
+	QByteArray reply = "HTTP/1.0 200 OK\r\n"
+		"Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+		"Content-Length: " + QByteArray::number(body.size()) + "\r\n"
+		"Connection: close\r\n\r\n";
+
+	client->write(reply + body);
+	client->disconnectFromHost();
+}
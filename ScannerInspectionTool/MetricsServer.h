@@ -0,0 +1,35 @@
+#pragma once
+#include <QObject>
+#include <QHostAddress>
+
+QT_BEGIN_NAMESPACE
+class QTcpServer;
+class QTcpSocket;
+QT_END_NAMESPACE
+
+//serves the metrics registry over http in the prometheus text format, for a monitoring box to scrape.
+//any path gets the metrics, one request per connection
+class MetricsServer : public QObject
+{
+	Q_OBJECT
+
+public:
+	static const quint16 defaultPort = 9470;
+
+	MetricsServer(QObject* parent = nullptr);
+	~MetricsServer();
+
+	bool listen(quint16 port = defaultPort, const QHostAddress& address = QHostAddress::Any);
+	void close();
+	bool isListening() const;
+	QString errorString() const;
+
+	private slots:
+	void acceptConnections();
+	void readRequest();
+
+private:
+	static const int maxRequestLength = 8192;
+
+	QTcpServer* server;
+};
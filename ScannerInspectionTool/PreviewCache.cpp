@@ -0,0 +1,77 @@
+#include "PreviewCache.h"
+#include <QFileInfo>
+#include <QFile>
+#include <qdir.h>
+#include <QDateTime>
+#include <QImageReader>
+#include "MemoryBudget.h"
+#include "ContentStore.h"
+
+std::list<PreviewCache::Entry> PreviewCache::entries;
+QHash<QString, std::list<PreviewCache::Entry>::iterator> PreviewCache::lookup;
+
+QPixmap PreviewCache::load(const QString& path, const QByteArray& hash)
+{
+	QString key;
+	if (hash.isEmpty()) key = path + "@" + QString::number(QFileInfo(path).lastModified().toMSecsSinceEpoch());
+	else key = QString::fromLatin1(hash.toHex());
+
+	QHash<QString, std::list<Entry>::iterator>::iterator cached = lookup.find(key);
+	if (cached != lookup.end())
+	{
+		entries.splice(entries.begin(), entries, cached.value());
+		return entries.front().pixmap;
+	}
+
+	QString kind = "preview-" + QString::number(maxEdge) + ".jpg";
+	QString stored = hash.isEmpty() ? QString() : ContentStore::derivedPath(hash, kind);
+	bool kept = !stored.isEmpty() && QFile::exists(stored);
+
+	QImageReader reader(kept ? stored : path);
+	QSize size = reader.size();
+	bool scaled = size.isValid() && qMax(size.width(), size.height()) > maxEdge;
+	if (scaled) reader.setScaledSize(size.scaled(maxEdge, maxEdge, Qt::KeepAspectRatio));
+
+	QImage image = reader.read();
+	if (image.isNull()) return QPixmap();
+
+	//small images are quicker to read again than a stored copy
+	if (!kept && scaled && !stored.isEmpty())
+	{
+		QDir().mkpath(QFileInfo(stored).path());
+		image.save(stored, "JPG", 90);
+	}
+
+	QPixmap pixmap = QPixmap::fromImage(image);
+
+	Entry entry = Entry();
+	entry.key = key;
+	entry.pixmap = pixmap;
+	entry.bytes = qint64(pixmap.width()) * pixmap.height() * pixmap.depth() / 8;
+	entries.push_front(entry);
+	lookup.insert(key, entries.begin());
+	MemoryBudget::charge(MemoryCategory::Pixmap, entry.bytes);
+
+	trim();
+	return pixmap;
+}
+
+void PreviewCache::trim()
+{
+	//the newest entry stays whatever the budget, it's about to be shown
+	while (entries.size() > 1 && MemoryBudget::exceeded(MemoryCategory::Pixmap))
+		remove(--entries.end());
+}
+
+void PreviewCache::clear()
+{
+	while (!entries.empty())
+		remove(entries.begin());
+}
+
+void PreviewCache::remove(std::list<Entry>::iterator entry)
+{
+	MemoryBudget::release(MemoryCategory::Pixmap, entry->bytes);
+	lookup.remove(entry->key);
+	entries.erase(entry);
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <QPixmap>
+#include <QHash>
+#include <list>
+
+//preview images decoded for the views, kept while they fit the pixmap memory budget and evicted least recently
+//used first. images are decoded no larger than the views need, a changed file is decoded again.
+//only used from the gui thread
+class PreviewCache
+{
+public:
+	//long edge previews are decoded down to
+	static const int maxEdge = 2048;
+
+	//a null pixmap when the file can't be read. with the content hash of the file the preview is shared by every
+	//copy of the image and the scaled down version is kept in the content store
+	static QPixmap load(const QString& path, const QByteArray& hash = QByteArray());
+	//evicts until the cache fits the budget again
+	static void trim();
+	static void clear();
+
+private:
+	struct Entry
+	{
+		QString key;
+		QPixmap pixmap;
+		qint64 bytes;
+	};
+
+	static void remove(std::list<Entry>::iterator entry);
+
+	//most recently used first
+	static std::list<Entry> entries;
+	static QHash<QString, std::list<Entry>::iterator> lookup;
+};
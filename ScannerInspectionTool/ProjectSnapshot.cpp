@@ -0,0 +1,164 @@
+#include "ProjectSnapshot.h"
+#include <algorithm>
+#include <QAtomicInt>
+#include "JsonStream.h"
+
+static QAtomicInt lastVersion = QAtomicInt(0);
+
+//fills the snapshot straight from the reply.
+//the scanner doesn't promise the key order so a set is only added once its object has been read
+class ProjectSnapshotReader : public JsonStream
+{
+public:
+	ProjectSnapshotReader(ProjectSnapshot* target) : snapshot(target) {}
+
+protected:
+	//depths of the objects in the document: {ImageSets: [{images: [{}]}]}
+	enum Level { Root = 1, Set = 3, Image = 5 };
+
+	void endObject() override
+	{
+		if (depth() == Image && inside("ImageSets", 1) && inside("images", 3))
+		{
+			images.push_back(std::make_pair(imageId, QString::fromStdString(imagePath)));
+			imageId = -1;
+			imagePath.clear();
+		}
+		else if (depth() == Set && inside("ImageSets", 1))
+		{
+			snapshot->addSet(setId, QString::fromStdString(setPath));
+			for (int i = 0; i < images.size(); ++i)
+				snapshot->addImage(images[i].first, images[i].second);
+
+			images.clear();
+			setId = -1;
+			setPath.clear();
+		}
+		else if (depth() == Set && inside("Cameras", 1))
+		{
+			snapshot->cameras.append(camera);
+			camera = ProjectCamera();
+		}
+	}
+
+	void value(const std::string& key, const nlohmann::json& value) override
+	{
+		if (depth() == Image && inside("ImageSets", 1) && inside("images", 3))
+		{
+			if (key == "id") imageId = value.get<int>();
+			else if (key == "path") imagePath = value.get<std::string>();
+		}
+		else if (depth() == Set && inside("ImageSets", 1))
+		{
+			if (key == "id") setId = value.get<int>();
+			else if (key == "path") setPath = value.get<std::string>();
+		}
+		else if (depth() == Set && inside("Cameras", 1))
+		{
+			if (key == "id") camera.id = value.get<int>();
+			else if (key == "name") camera.name = QString::fromStdString(value.get<std::string>());
+		}
+		else if (depth() == Root && key == "ProjectId") snapshot->id = value.get<int>();
+	}
+
+private:
+	ProjectSnapshot* snapshot;
+
+	int setId = -1;
+	std::string setPath;
+	int imageId = -1;
+	std::string imagePath;
+	std::vector<std::pair<int, QString>> images;
+	ProjectCamera camera = ProjectCamera();
+};
+
+
+ProjectSnapshot::ProjectSnapshot()
+{
+}
+
+
+ProjectSnapshot::~ProjectSnapshot()
+{
+}
+
+ProjectSnapshotPtr ProjectSnapshot::parse(const QByteArray& data, ReplyEncoding encoding)
+{
+	if (data.isEmpty() || data.startsWith("Fail")) return ProjectSnapshotPtr();
+
+	ProjectSnapshot* snapshot = new ProjectSnapshot();
+	ProjectSnapshotReader reader = ProjectSnapshotReader(snapshot);
+
+	if (!reader.parse(data, encoding))
+	{
+		delete snapshot;
+		return ProjectSnapshotPtr();
+	}
+
+	snapshot->snapshotVersion = lastVersion.fetchAndAddOrdered(1) + 1;
+	return ProjectSnapshotPtr(snapshot);
+}
+
+int ProjectSnapshot::imageCount(int set) const
+{
+	int end = set + 1 < setCount() ? setFirstImage[set + 1] : imageCount();
+	return end - setFirstImage[set];
+}
+
+int ProjectSnapshot::findImage(int set, int cameraId) const
+{
+	int end = setFirstImage[set] + imageCount(set);
+	for (int i = setFirstImage[set]; i < end; ++i)
+		if (cameraIds[i] == cameraId) return i;
+
+	return -1;
+}
+
+//sets hold a contiguous run of images so the owner is the last set starting at or before it
+int ProjectSnapshot::imageSet(int image) const
+{
+	std::vector<qint32>::const_iterator next = std::upper_bound(setFirstImage.begin(), setFirstImage.end(), image);
+	return int(next - setFirstImage.begin()) - 1;
+}
+
+int ProjectSnapshot::addSet(int setId, const QString& name)
+{
+	int row = setCount();
+
+	setIds.push_back(setId);
+	setNames.push_back(internName(name));
+	setFirstImage.push_back(imageCount());
+
+	setLookup.insert(setId, row);
+	return row;
+}
+
+void ProjectSnapshot::addImage(int cameraId, const QString& fileName)
+{
+	cameraIds.push_back(qint16(cameraId));
+	fileNames.push_back(internName(fileName));
+}
+
+qint64 ProjectSnapshot::memoryUsed() const
+{
+	qint64 bytes = sizeof(ProjectSnapshot);
+	bytes += (setIds.capacity() + setNames.capacity() + setFirstImage.capacity() + fileNames.capacity()) * sizeof(qint32);
+	bytes += cameraIds.capacity() * sizeof(qint16);
+
+	//each name is held once by the list and shared with the lookup, hash nodes are about 32 bytes
+	for (int i = 0; i < names.size(); ++i)
+		bytes += sizeof(QString) + names.at(i).capacity() * sizeof(QChar);
+	bytes += (nameLookup.size() + setLookup.size()) * 32;
+	bytes += cameras.size() * sizeof(ProjectCamera);
+	return bytes;
+}
+
+int ProjectSnapshot::internName(const QString& name)
+{
+	QHash<QString, int>::const_iterator existing = nameLookup.constFind(name);
+	if (existing != nameLookup.constEnd()) return existing.value();
+
+	names.append(name);
+	nameLookup.insert(name, names.size() - 1);
+	return names.size() - 1;
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QByteArray>
+#include <QSharedPointer>
+#include <QMetaType>
+#include <vector>
+#include "ReplyEncoding.h"
+
+class ProjectSnapshot;
+typedef QSharedPointer<const ProjectSnapshot> ProjectSnapshotPtr;
+
+struct ProjectCamera
+{
+	int id;
+	QString name;
+};
+
+//immutable description of a project (the project.scan document) parsed once from the scanner reply.
+//snapshots are shared between the transfer, calibration window and calibration thread instead of
+//each of them reading the file again. every parse gets a new version number.
+class ProjectSnapshot
+{
+public:
+	~ProjectSnapshot();
+
+	static ProjectSnapshotPtr parse(const QByteArray& data, ReplyEncoding encoding = ReplyEncoding::Json);
+
+	int projectId() const { return id; }
+	int version() const { return snapshotVersion; }
+
+	//sets
+	int setCount() const { return int(setIds.size()); }
+	int setId(int set) const { return setIds[set]; }
+	const QString& setName(int set) const { return names.at(setNames[set]); }
+	int setRow(int setId) const { return setLookup.value(setId, -1); }
+	bool containsSet(int setId) const { return setLookup.contains(setId); }
+	int firstImage(int set) const { return setFirstImage[set]; }
+	int imageCount(int set) const;
+
+	//images, addressed by their index in the project
+	int imageCount() const { return int(cameraIds.size()); }
+	int cameraId(int image) const { return cameraIds[image]; }
+	const QString& fileName(int image) const { return names.at(fileNames[image]); }
+	int findImage(int set, int cameraId) const;
+	int imageSet(int image) const;
+
+	//cameras
+	int cameraCount() const { return cameras.size(); }
+	const ProjectCamera& camera(int index) const { return cameras.at(index); }
+
+	//rough bytes held, for memory accounting
+	qint64 memoryUsed() const;
+
+private:
+	friend class ProjectSnapshotReader;
+	ProjectSnapshot();
+
+	//images must be added directly after the set that owns them
+	int addSet(int setId, const QString& name);
+	void addImage(int cameraId, const QString& fileName);
+	int internName(const QString& name);
+
+	int id = -1;
+	int snapshotVersion = 0;
+
+	std::vector<qint32> setIds;
+	std::vector<qint32> setNames;
+	std::vector<qint32> setFirstImage;
+	std::vector<qint16> cameraIds;
+	std::vector<qint32> fileNames;
+	QList<ProjectCamera> cameras;
+
+	//names repeat across sets (the same camera file names) so they are only stored once
+	QStringList names;
+	QHash<QString, int> nameLookup;
+	QHash<int, int> setLookup;
+};
+
+Q_DECLARE_METATYPE(ProjectSnapshotPtr)
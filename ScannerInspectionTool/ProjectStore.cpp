@@ -0,0 +1,152 @@
+#include "ProjectStore.h"
+
+
+ProjectStore::ProjectStore()
+{
+}
+
+
+ProjectStore::~ProjectStore()
+{
+}
+
+void ProjectStore::clear()
+{
+	project.reset();
+	transferedTotal = 0;
+
+	//swap with empty containers so the memory is actually released
+	std::vector<qint32>().swap(setTransfered);
+	std::vector<quint8>().swap(transfered);
+	std::vector<quint8>().swap(contentKnown);
+	std::vector<qint64>().swap(sizes);
+	std::vector<QByteArray>().swap(hashes);
+	std::vector<CalibrationValidity>().swap(validities);
+	std::vector<CalibrationValidity>().swap(pairs);
+}
+
+void ProjectStore::reset(ProjectSnapshotPtr snapshot)
+{
+	clear();
+	project = snapshot;
+
+	setTransfered.assign(setCount(), 0);
+	transfered.assign(imageCount(), 0);
+	contentKnown.assign(setCount(), 0);
+	sizes.assign(imageCount(), -1);
+	hashes.assign(imageCount(), QByteArray());
+	validities.assign(imageCount(), Pending);
+	pairs.assign(setCount() * pairStride, Pending);
+}
+
+bool ProjectStore::appends(ProjectSnapshotPtr snapshot) const
+{
+	if (project.isNull() || snapshot.isNull() || project->projectId() != snapshot->projectId()) return false;
+	if (snapshot->setCount() < project->setCount()) return false;
+
+	for (int i = 0; i < project->setCount(); ++i)
+	{
+		if (snapshot->setId(i) != project->setId(i) || snapshot->imageCount(i) != project->imageCount(i))
+			return false;
+	}
+
+	return true;
+}
+
+bool ProjectStore::update(ProjectSnapshotPtr snapshot)
+{
+	ProjectSnapshotPtr previous = project;
+	if (previous.isNull() || snapshot.isNull() || previous->projectId() != snapshot->projectId())
+	{
+		reset(snapshot);
+		return false;
+	}
+
+	bool appended = appends(snapshot);
+
+	std::vector<qint32> nextSetTransfered(snapshot->setCount(), 0);
+	std::vector<quint8> nextTransfered(snapshot->imageCount(), 0);
+	std::vector<quint8> nextContentKnown(snapshot->setCount(), 0);
+	std::vector<qint64> nextSizes(snapshot->imageCount(), -1);
+	std::vector<QByteArray> nextHashes(snapshot->imageCount());
+	std::vector<CalibrationValidity> nextValidities(snapshot->imageCount(), Pending);
+	std::vector<CalibrationValidity> nextPairs(snapshot->setCount() * pairStride, Pending);
+
+	//carry the state over using the set and camera ids, rows may have moved between snapshots
+	for (int set = 0; set < snapshot->setCount(); ++set)
+	{
+		int old = previous->setRow(snapshot->setId(set));
+		if (old < 0) continue;
+
+		for (int pair = 0; pair < pairStride; ++pair)
+			nextPairs[set * pairStride + pair] = pairs[old * pairStride + pair];
+		nextContentKnown[set] = contentKnown[old];
+
+		int end = snapshot->firstImage(set) + snapshot->imageCount(set);
+		for (int image = snapshot->firstImage(set); image < end; ++image)
+		{
+			int oldImage = previous->findImage(old, snapshot->cameraId(image));
+			if (oldImage < 0) continue;
+
+			nextTransfered[image] = transfered[oldImage];
+			nextValidities[image] = validities[oldImage];
+			nextSizes[image] = sizes[oldImage];
+			nextHashes[image].swap(hashes[oldImage]);
+			nextSetTransfered[set] += transfered[oldImage];
+		}
+	}
+
+	transferedTotal = 0;
+	for (size_t set = 0; set < nextSetTransfered.size(); ++set)
+		transferedTotal += nextSetTransfered[set];
+
+	project = snapshot;
+	setTransfered.swap(nextSetTransfered);
+	transfered.swap(nextTransfered);
+	contentKnown.swap(nextContentKnown);
+	sizes.swap(nextSizes);
+	hashes.swap(nextHashes);
+	validities.swap(nextValidities);
+	pairs.swap(nextPairs);
+
+	return appended;
+}
+
+void ProjectStore::setTransfered(int image, bool state)
+{
+	if (isTransfered(image) == state) return;
+
+	transfered[image] = state ? 1 : 0;
+	setTransfered[project->imageSet(image)] += state ? 1 : -1;
+	transferedTotal += state ? 1 : -1;
+}
+
+void ProjectStore::setContent(int set, const std::vector<ImageContent>& images)
+{
+	contentKnown[set] = 1;
+	for (size_t i = 0; i < images.size(); ++i)
+	{
+		int image = findImage(set, images[i].cameraId);
+		if (image < 0) continue;
+
+		sizes[image] = images[i].size;
+		hashes[image] = images[i].hash;
+	}
+}
+
+qint64 ProjectStore::memoryUsed() const
+{
+	qint64 bytes = project.isNull() ? 0 : project->memoryUsed();
+	bytes += setTransfered.capacity() * sizeof(qint32) + (transfered.capacity() + contentKnown.capacity()) * sizeof(quint8);
+	bytes += sizes.capacity() * sizeof(qint64) + hashes.capacity() * sizeof(QByteArray);
+	for (size_t i = 0; i < hashes.size(); ++i)
+		bytes += hashes[i].capacity();
+	bytes += (validities.capacity() + pairs.capacity()) * sizeof(CalibrationValidity);
+	return bytes;
+}
+
+void ProjectStore::setPairCount(int count)
+{
+	pairStride = count;
+	pairs.assign(setCount() * count, Pending);
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <vector>
+#include "JsonTypes.h"
+#include "ProjectSnapshot.h"
+
+//transfer and calibration state for every set and image of a project.
+//the structure of the project comes from a shared ProjectSnapshot, the store only keeps
+//the mutable state in flat arrays indexed the same way as the snapshot (see firstImage)
+class ProjectStore
+{
+public:
+	ProjectStore();
+	~ProjectStore();
+
+	void clear();
+
+	//replaces the project, all state is reset
+	void reset(ProjectSnapshotPtr snapshot);
+	//moves to a newer snapshot of the same project keeping the state of sets and images that still exist.
+	//returns true when the existing sets are unchanged and new sets were only appended
+	bool update(ProjectSnapshotPtr snapshot);
+	//whether update would only append sets, so views can prepare before the store changes
+	bool appends(ProjectSnapshotPtr snapshot) const;
+	ProjectSnapshotPtr snapshot() const { return project; }
+
+	//sets
+	int setCount() const { return project.isNull() ? 0 : project->setCount(); }
+	int setId(int set) const { return project->setId(set); }
+	const QString& setName(int set) const { return project->setName(set); }
+	int setRow(int setId) const { return project.isNull() ? -1 : project->setRow(setId); }
+	bool containsSet(int setId) const { return !project.isNull() && project->containsSet(setId); }
+	int firstImage(int set) const { return project->firstImage(set); }
+	int imageCount(int set) const { return project->imageCount(set); }
+	int transferedCount(int set) const { return setTransfered[set]; }
+	int transferedCount() const { return transferedTotal; }
+
+	//the snapshot and the state kept for it
+	qint64 memoryUsed() const;
+
+	//images
+	int imageCount() const { return project.isNull() ? 0 : project->imageCount(); }
+	int cameraId(int image) const { return project->cameraId(image); }
+	const QString& fileName(int image) const { return project->fileName(image); }
+	int findImage(int set, int cameraId) const { return project->findImage(set, cameraId); }
+
+	bool isTransfered(int image) const { return transfered[image] != 0; }
+	void setTransfered(int image, bool state);
+	//size and hash the scanner reported for each image (ImageSetMetaData), a size of -1 when it isn't known
+	bool hasContent(int set) const { return contentKnown[set] != 0; }
+	void setContent(int set, const std::vector<ImageContent>& images);
+	qint64 contentSize(int image) const { return sizes[image]; }
+	const QByteArray& contentHash(int image) const { return hashes[image]; }
+
+	CalibrationValidity validity(int image) const { return validities[image]; }
+	void setValidity(int image, CalibrationValidity state) { validities[image] = state; }
+
+	//camera pair state of each set
+	int pairCount() const { return pairStride; }
+	void setPairCount(int count);
+	CalibrationValidity pairValidity(int set, int pair) const { return pairs[set * pairStride + pair]; }
+	void setPairValidity(int set, int pair, CalibrationValidity state) { pairs[set * pairStride + pair] = state; }
+
+private:
+	ProjectSnapshotPtr project;
+
+	std::vector<qint32> setTransfered;
+	int transferedTotal = 0;
+	std::vector<quint8> transfered;
+	std::vector<quint8> contentKnown;
+	std::vector<qint64> sizes;
+	std::vector<QByteArray> hashes;
+	std::vector<CalibrationValidity> validities;
+
+	std::vector<CalibrationValidity> pairs;
+	int pairStride = 0;
+};
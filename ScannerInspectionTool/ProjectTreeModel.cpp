@@ -0,0 +1,189 @@
+#include "ProjectTreeModel.h"
+
+
+ProjectTreeModel::ProjectTreeModel(QObject *parent) : QAbstractItemModel(parent)
+{
+}
+
+
+ProjectTreeModel::~ProjectTreeModel()
+{
+}
+
+//image rows store the row of their set (offset by one) as the internal id, set rows use 0
+QModelIndex ProjectTreeModel::index(int row, int column, const QModelIndex& parent) const
+{
+	if (!hasIndex(row, column, parent)) return QModelIndex();
+
+	if (!parent.isValid()) return createIndex(row, column, quintptr(0));
+	return createIndex(row, column, quintptr(parent.row() + 1));
+}
+
+QModelIndex ProjectTreeModel::parent(const QModelIndex& child) const
+{
+	if (!child.isValid() || !isImage(child)) return QModelIndex();
+
+	return createIndex(int(child.internalId() - 1), 0, quintptr(0));
+}
+
+int ProjectTreeModel::rowCount(const QModelIndex& parent) const
+{
+	if (!parent.isValid()) return loadedSets;
+	if (isImage(parent) || parent.column() != 0 || parent.row() >= loadedSets) return 0;
+
+	//children only exist once the set has been expanded
+	return images[parent.row()];
+}
+
+int ProjectTreeModel::columnCount(const QModelIndex& parent) const
+{
+	return 2;
+}
+
+bool ProjectTreeModel::hasChildren(const QModelIndex& parent) const
+{
+	if (!parent.isValid()) return loadedSets > 0;
+	if (isImage(parent) || parent.column() != 0 || parent.row() >= loadedSets) return false;
+	if (images[parent.row()] > 0) return true;
+
+	return parent.row() < store->setCount() && store->imageCount(parent.row()) > 0;
+}
+
+bool ProjectTreeModel::canFetchMore(const QModelIndex& parent) const
+{
+	if (!parent.isValid() || isImage(parent) || parent.column() != 0 || parent.row() >= loadedSets) return false;
+	if (parent.row() >= store->setCount()) return false;
+
+	return images[parent.row()] == 0 && store->imageCount(parent.row()) > 0;
+}
+
+void ProjectTreeModel::fetchMore(const QModelIndex& parent)
+{
+	if (!canFetchMore(parent)) return;
+
+	int count = store->imageCount(parent.row());
+	beginInsertRows(parent, 0, count - 1);
+	images[parent.row()] = count;
+	endInsertRows();
+}
+
+QVariant ProjectTreeModel::data(const QModelIndex& index, int role) const
+{
+	if (store == nullptr || !index.isValid()) return QVariant();
+
+	//rows can outlive the store's contents until the views are told
+	int set = setRow(index);
+	if (set >= store->setCount()) return QVariant();
+
+	if (isImage(index))
+	{
+		if (index.row() >= store->imageCount(set)) return QVariant();
+		int img = store->firstImage(set) + index.row();
+
+		if (role == Qt::DisplayRole)
+			return index.column() == 0 ? QVariant(store->fileName(img)) : QVariant(store->cameraId(img));
+		if (role == Qt::DecorationRole && index.column() == 0)
+			return store->isTransfered(img) ? ImageTransfered : ImageNotTransfered;
+
+		return QVariant();
+	}
+
+	if (role == Qt::DisplayRole)
+		return index.column() == 0 ? QVariant(store->setName(set)) : QVariant(store->setId(set));
+	if (role == Qt::DecorationRole && index.column() == 0)
+		return store->transferedCount(set) == store->imageCount(set) ? ImageTransfered : ImageNotTransfered;
+
+	return QVariant();
+}
+
+QVariant ProjectTreeModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+	if (orientation != Qt::Horizontal || role != Qt::DisplayRole) return QVariant();
+
+	switch (section)
+	{
+	case 0:
+		return "Name";
+	case 1:
+		return "ID";
+	default:
+		return QVariant();
+	}
+}
+
+Qt::ItemFlags ProjectTreeModel::flags(const QModelIndex& index) const
+{
+	return Qt::ItemIsEnabled | Qt::ItemIsSelectable;
+}
+
+//the store is about to be replaced, the views can't read it again until setProject
+void ProjectTreeModel::projectAboutToChange()
+{
+	if (resetting) return;
+
+	beginResetModel();
+	resetting = true;
+}
+
+void ProjectTreeModel::setProject(ProjectStore* store)
+{
+	if (!resetting) beginResetModel();
+
+	this->store = store;
+	loadedSets = store->setCount();
+	images.assign(loadedSets, 0);
+
+	resetting = false;
+	endResetModel();
+}
+
+//sets are only ever added to the end of the store
+void ProjectTreeModel::setsAppended(int first)
+{
+	int last = store->setCount() - 1;
+	if (last < first) return;
+
+	beginInsertRows(QModelIndex(), first, last);
+	loadedSets = store->setCount();
+	images.resize(loadedSets, 0);
+	endInsertRows();
+}
+
+//the transfer state of an image changed, the set icon depends on it as well
+void ProjectTreeModel::imageChanged(int setRow, int imageRow)
+{
+	if (store == nullptr || setRow >= loadedSets) return;
+
+	QModelIndex setIndex = createIndex(setRow, 0, quintptr(0));
+	emit dataChanged(setIndex, setIndex);
+
+	if (imageRow < images[setRow])
+	{
+		QModelIndex imageIndex = createIndex(imageRow, 0, quintptr(setRow + 1));
+		emit dataChanged(imageIndex, imageIndex);
+	}
+}
+
+void ProjectTreeModel::clearData()
+{
+	if (!resetting) beginResetModel();
+
+	store = nullptr;
+	loadedSets = 0;
+	images.clear();
+
+	resetting = false;
+	endResetModel();
+}
+
+int ProjectTreeModel::setRow(const QModelIndex& index) const
+{
+	if (!index.isValid()) return -1;
+	return isImage(index) ? int(index.internalId() - 1) : index.row();
+}
+
+int ProjectTreeModel::imageRow(const QModelIndex& index) const
+{
+	if (!index.isValid() || !isImage(index)) return -1;
+	return index.row();
+}
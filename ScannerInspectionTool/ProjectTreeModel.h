@@ -0,0 +1,46 @@
+#pragma once
+#include <qabstractitemmodel.h>
+#include <QIcon>
+#include "ProjectStore.h"
+
+//tree of image sets and their images, image rows are only created once a set is expanded
+class ProjectTreeModel : public QAbstractItemModel
+{
+	Q_OBJECT
+
+public:
+	ProjectTreeModel(QObject *parent = Q_NULLPTR);
+	~ProjectTreeModel();
+
+	QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const override;
+	QModelIndex parent(const QModelIndex &child) const override;
+	int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+	int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+	bool hasChildren(const QModelIndex &parent = QModelIndex()) const override;
+	bool canFetchMore(const QModelIndex &parent) const override;
+	void fetchMore(const QModelIndex &parent) override;
+	QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+	QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+	Qt::ItemFlags flags(const QModelIndex &index) const override;
+
+	void projectAboutToChange();
+	void setProject(ProjectStore* store);
+	void setsAppended(int first);
+	void imageChanged(int setRow, int imageRow);
+	void clearData();
+
+	int setRow(const QModelIndex &index) const;
+	int imageRow(const QModelIndex &index) const;
+
+private:
+	bool isImage(const QModelIndex &index) const { return index.internalId() != 0; }
+
+	ProjectStore* store = nullptr;
+	//rows the views have been told about, appended sets reach the store before they are
+	int loadedSets = 0;
+	bool resetting = false; //projectAboutToChange began a reset that setProject ends
+	std::vector<int> images = std::vector<int>(); //per set, 0 until it's expanded
+
+	const QIcon ImageTransfered = QIcon(":/ScannerInspectionTool/transferComplete");
+	const QIcon ImageNotTransfered = QIcon(":/ScannerInspectionTool/transferNeeded");
+};
@@ -1,7 +1,7 @@
 #include "ProjectView.h"
 #include <qtimer.h>
-#include "Lib/json.hpp"
 #include "Project.h"
+#include "ReplyReader.h"
 #include <QInputDialog>
 #include <QMenu>
 #include "parameterBuilder.h"
@@ -17,7 +17,6 @@ ProjectView::ProjectView(QPushButton* refresh, QPushButton* transfer, QTableView
 	this->transfer = transfer;
 	this->table = table;
 
-	this->connector = connector;
 	projectError = new QErrorMessage();
 	projectError->setWindowTitle("Project Management Error");
 
@@ -31,7 +30,7 @@ ProjectView::ProjectView(QPushButton* refresh, QPushButton* transfer, QTableView
 	connect(refresh, &QPushButton::clicked, this, &ProjectView::refreshProjects);
 	connect(transfer, &QPushButton::clicked, this, &ProjectView::triggerProjectChange);
 	connect(table, &QTableView::customContextMenuRequested, this, &ProjectView::createCustomMenu);
-	connect(connector, &ScannerInteraction::scannerConnected, this, &ProjectView::scannerConnected);
+	setConnection(connector);
 }
 
 ProjectView::~ProjectView()
@@ -42,6 +41,23 @@ ProjectView::~ProjectView()
 	delete projectError;
 }
 
+//binds the view to a scanner session, the project list is reloaded from the new scanner
+void ProjectView::setConnection(ScannerInteraction* scanner)
+{
+	if (connector == scanner) return;
+
+	disconnect(connectorLink);
+	connector = scanner;
+
+	dataModel->clearData();
+	dataModel->setCurrentProject(-1);
+	dataModel->updateTable();
+
+	if (connector == nullptr) return;
+	connectorLink = connect(connector, &ScannerInteraction::scannerConnected, this, &ProjectView::scannerConnected);
+	if (connector->isConnected()) scannerConnected();
+}
+
 void ProjectView::respondToScanner(ScannerCommands command, QByteArray data)
 {
 	switch (command)
@@ -62,6 +78,7 @@ void ProjectView::respondToScanner(ScannerCommands command, QByteArray data)
 
 void ProjectView::refreshProjects()
 {
+	if (connector == nullptr) return;
 	connector->requestScanner(ScannerCommands::getLoadedProjects, "", this);
 }
 
@@ -73,6 +90,7 @@ void ProjectView::createCustomMenu(const QPoint& pos)
 
 	//show context menu for changing the project name
 	QPoint location = table->mapToGlobal(pos);
+	delete contextMenuIndex;
 	contextMenuIndex = new QModelIndex(index);
 	nameChange->exec(location);
 }
@@ -130,25 +148,14 @@ void ProjectView::scannerConnected()
 void ProjectView::processProjects(QByteArray data) const
 {
 	reportPossibleError(data);
-	nlohmann::json result = nlohmann::json::parse(data.toStdString().c_str());
-
-	dataModel->clearData();
 
-	//collect all the data from the response
-	for (int i = 0; i < result.size(); ++i)
-	{
-		std::string normal = result[i].dump();
-		nlohmann::json jsonProject = nlohmann::json::parse(normal.c_str());
+	std::vector<project> projects = std::vector<project>();
+	if (!ReplyReader::readProjects(data, projects)) return;
 
-		project instance = project();
-
-		instance.id = jsonProject.at("Id").get<int>();
-		instance.name = jsonProject.at("Name").get<std::string>();
-		instance.imageCount = jsonProject.at("ImageCount").get<int>();
-		instance.imagesAvaliable = jsonProject.at("SavedCount").get<int>();
+	dataModel->clearData();
 
-		dataModel->addItem(instance);
-	}
+	for (int i = 0; i < projects.size(); ++i)
+		dataModel->addItem(projects[i]);
 
 	dataModel->updateTable();
 
@@ -180,6 +187,7 @@ void ProjectView::reportPossibleError(QByteArray data) const
 void ProjectView::currentProjectResult(QByteArray data)
 {
 	QString result = QString(data);
+	if (result.isEmpty()) return;
 	if (result.startsWith("Fail")) projectError->showMessage(result.mid(result.indexOf("?") + 1));
 
 	int project = result.toInt();
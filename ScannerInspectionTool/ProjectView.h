@@ -2,7 +2,6 @@
 #include <QPushButton>
 #include <QTableWidget>
 #include "ScannerInteraction.h"
-#include "Lib/json.hpp"
 #include "ProjectTableView.h"
 #include <QErrorMessage>
 
@@ -20,6 +19,8 @@ public:
 	ProjectView(QPushButton*, QPushButton*, QTableView*, ScannerInteraction*);
 	~ProjectView();
 
+	void setConnection(ScannerInteraction* scanner);
+
 	signals:
 	void transferProject(const int);
 
@@ -38,10 +39,11 @@ public:
 private:
 	const int timerDuration = 30000; //30sec
 
-	ScannerInteraction* connector;
+	ScannerInteraction* connector = nullptr;
+	QMetaObject::Connection connectorLink;
 	ProjectTableView* dataModel;
 	QMenu* nameChange;
-	QModelIndex* contextMenuIndex;
+	QModelIndex* contextMenuIndex = nullptr;
 	QErrorMessage* projectError;
 
 	void processProjects(QByteArray) const;
@@ -0,0 +1,35 @@
+#pragma once
+#include <QString>
+
+//payload encoding of a scanner reply.
+//json is always understood, the binary encodings are only used once the scanner has agreed to them (see ScannerInteraction)
+enum class ReplyEncoding
+{
+	Json,
+	Cbor,
+	MsgPack
+};
+
+class ReplyEncodings
+{
+public:
+	static QString name(ReplyEncoding encoding)
+	{
+		switch (encoding)
+		{
+		case ReplyEncoding::Cbor:
+			return "cbor";
+		case ReplyEncoding::MsgPack:
+			return "msgpack";
+		default:
+			return "json";
+		}
+	}
+
+	static ReplyEncoding fromName(const QString& name)
+	{
+		if (name == "cbor") return ReplyEncoding::Cbor;
+		if (name == "msgpack") return ReplyEncoding::MsgPack;
+		return ReplyEncoding::Json;
+	}
+};
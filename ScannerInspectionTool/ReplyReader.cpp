@@ -0,0 +1,163 @@
+#include "ReplyReader.h"
+#include "JsonStream.h"
+
+class ProjectListReader : public JsonStream
+{
+public:
+	ProjectListReader(std::vector<project>& target) : projects(target) {}
+
+protected:
+	void startObject() override
+	{
+		if (depth() == 2) current = project();
+	}
+
+	void endObject() override
+	{
+		if (depth() == 2) projects.push_back(current);
+	}
+
+	void value(const std::string& key, const nlohmann::json& value) override
+	{
+		if (depth() != 2) return;
+
+		if (key == "Id") current.id = value.get<int>();
+		else if (key == "Name") current.name = value.get<std::string>();
+		else if (key == "ImageCount") current.imageCount = value.get<int>();
+		else if (key == "SavedCount") current.imagesAvaliable = value.get<int>();
+	}
+
+private:
+	std::vector<project>& projects;
+	project current = project();
+};
+
+class StringListReader : public JsonStream
+{
+public:
+	StringListReader(QStringList& target) : lines(target) {}
+
+protected:
+	void value(const std::string& key, const nlohmann::json& value) override
+	{
+		if (depth() == 1 && value.is_string())
+			lines.append(QString::fromStdString(value.get<std::string>()));
+	}
+
+private:
+	QStringList& lines;
+};
+
+class CameraPairReader : public JsonStream
+{
+public:
+	CameraPairReader(std::vector<CameraPair>& target) : pairs(target) {}
+
+protected:
+	void startObject() override
+	{
+		if (depth() == 2) current = CameraPair();
+	}
+
+	void endObject() override
+	{
+		if (depth() == 2) pairs.push_back(current);
+	}
+
+	void value(const std::string& key, const nlohmann::json& value) override
+	{
+		if (depth() != 2) return;
+
+		if (key == "pairId") current.id = value.get<int>();
+		else if (key == "LeftCamera") current.leftId = value.get<int>();
+		else if (key == "RightCamera") current.rightId = value.get<int>();
+	}
+
+private:
+	std::vector<CameraPair>& pairs;
+	CameraPair current = CameraPair();
+};
+class ImageContentReader : public JsonStream
+{
+public:
+	ImageContentReader(int& set, std::vector<ImageContent>& target) : setId(set), images(target) {}
+
+protected:
+	void startObject() override
+	{
+		if (depth() == 3 && inside("images", 1)) current = ImageContent();
+	}
+
+	void endObject() override
+	{
+		if (depth() == 3 && inside("images", 1)) images.push_back(current);
+	}
+
+	void value(const std::string& key, const nlohmann::json& value) override
+	{
+		if (depth() == 1)
+		{
+			if (key == "id") setId = value.get<int>();
+			return;
+		}
+		if (depth() != 3 || !inside("images", 1)) return;
+
+		if (key == "id") current.cameraId = value.get<int>();
+		else if (key == "size") current.size = value.get<qint64>();
+		else if (key == "hash") current.hash = QByteArray::fromHex(QByteArray::fromStdString(value.get<std::string>()));
+	}
+
+private:
+	int& setId;
+	std::vector<ImageContent>& images;
+	ImageContent current = ImageContent();
+};
+
+
+bool ReplyReader::readProjects(const QByteArray& data, std::vector<project>& projects, ReplyEncoding encoding)
+{
+	ProjectListReader reader = ProjectListReader(projects);
+	return reader.parse(data, encoding);
+}
+
+bool ReplyReader::readStrings(const QByteArray& data, QStringList& lines, ReplyEncoding encoding)
+{
+	StringListReader reader = StringListReader(lines);
+	return reader.parse(data, encoding);
+}
+
+bool ReplyReader::readCameraPairs(const QByteArray& data, std::vector<CameraPair>& pairs, ReplyEncoding encoding)
+{
+	CameraPairReader reader = CameraPairReader(pairs);
+	return reader.parse(data, encoding);
+}
+
+bool ReplyReader::readImageContent(const QByteArray& data, int& setId, std::vector<ImageContent>& images, ReplyEncoding encoding)
+{
+	setId = -1;
+	ImageContentReader reader = ImageContentReader(setId, images);
+	return reader.parse(data, encoding);
+}
+
+bool ReplyReader::readImageFrames(const QByteArray& data, std::vector<ImageFrame>& frames)
+{
+	int position = 0;
+	while (position < data.size())
+	{
+		int separator = data.indexOf(':', position);
+		int end = separator < 0 ? -1 : data.indexOf('>', separator);
+		if (end < 0) return false;
+
+		bool idOk = false, sizeOk = false;
+		ImageFrame frame = ImageFrame();
+		frame.cameraId = data.mid(position, separator - position).toInt(&idOk);
+		frame.size = data.mid(separator + 1, end - separator - 1).toInt(&sizeOk);
+		frame.offset = end + 1;
+		if (!idOk || !sizeOk || frame.size < 0 || frame.size > data.size() - frame.offset) return false;
+
+		frames.push_back(frame);
+		position = frame.offset + frame.size;
+	}
+
+	return true;
+}
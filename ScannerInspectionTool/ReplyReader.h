@@ -0,0 +1,32 @@
+#pragma once
+#include <QByteArray>
+#include <QStringList>
+#include <vector>
+#include "Project.h"
+#include "JsonTypes.h"
+#include "ReplyEncoding.h"
+
+//one image of an ImageSetImageBatch reply, where it is in the reply data
+struct ImageFrame
+{
+	int cameraId;
+	int offset;
+	int size;
+};
+
+//streaming readers for the smaller scanner replies, see JsonStream
+class ReplyReader
+{
+public:
+	//getLoadedProjects, an array of {Id, Name, ImageCount, SavedCount}
+	static bool readProjects(const QByteArray& data, std::vector<project>& projects, ReplyEncoding encoding = ReplyEncoding::Json);
+	//the log commands, an array of lines which are appended to lines
+	static bool readStrings(const QByteArray& data, QStringList& lines, ReplyEncoding encoding = ReplyEncoding::Json);
+	//CameraPairs, an array of {pairId, LeftCamera, RightCamera}
+	static bool readCameraPairs(const QByteArray& data, std::vector<CameraPair>& pairs, ReplyEncoding encoding = ReplyEncoding::Json);
+	//ImageSetMetaData, {id, path, images: [{id, path, size, hash}]}. setId is -1 if the reply has no id
+	static bool readImageContent(const QByteArray& data, int& setId, std::vector<ImageContent>& images, ReplyEncoding encoding = ReplyEncoding::Json);
+	//ImageSetImageBatch, every image is framed as "<camera id>:<size>>" followed by its data. the images are
+	//left in the reply, frames only say where they are. false if a frame is cut short or malformed
+	static bool readImageFrames(const QByteArray& data, std::vector<ImageFrame>& frames);
+};
@@ -0,0 +1,65 @@
+#include "ReplyRing.h"
+
+
+ReplyRing::ReplyRing(int capacity) : head(0), tail(0)
+{
+	//round up to a power of two so the slot is a mask of the counter
+	quint32 size = 1;
+	while (size < quint32(qMax(capacity, 1))) size <<= 1;
+
+	entries.resize(size);
+	mask = size - 1;
+}
+
+ReplyRing::~ReplyRing()
+{
+}
+
+bool ReplyRing::push(ScannerReply& reply)
+{
+	quint32 write = head.load();
+	if (write - tail.loadAcquire() > mask) return false;
+
+	ScannerReply& slot = entries[write & mask];
+	slot.command = reply.command;
+	slot.data.swap(reply.data);
+	slot.responder = reply.responder;
+	slot.owner = reply.owner;
+	slot.charged = reply.charged;
+	slot.encoding = reply.encoding;
+	reply.owner.clear();
+	reply.charged = 0;
+
+	head.storeRelease(write + 1);
+	return true;
+}
+
+bool ReplyRing::isFull() const
+{
+	return head.load() - tail.loadAcquire() > mask;
+}
+
+bool ReplyRing::pop(ScannerReply& reply)
+{
+	quint32 read = tail.load();
+	if (read == head.loadAcquire()) return false;
+
+	ScannerReply& slot = entries[read & mask];
+	reply.command = slot.command;
+	reply.data.swap(slot.data);
+	reply.responder = slot.responder;
+	reply.owner = slot.owner;
+	reply.charged = slot.charged;
+	reply.encoding = slot.encoding;
+	slot.owner.clear();
+	slot.data.clear();
+	slot.charged = 0;
+
+	tail.storeRelease(read + 1);
+	return true;
+}
+
+bool ReplyRing::isEmpty() const
+{
+	return tail.load() == head.loadAcquire();
+}
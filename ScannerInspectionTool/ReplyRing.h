@@ -0,0 +1,46 @@
+#pragma once
+#include <QByteArray>
+#include <QAtomicInteger>
+#include <QPointer>
+#include <vector>
+#include "IDeviceResponder.h"
+#include "ReplyEncoding.h"
+
+//a completed reply waiting to be handed to its responder
+struct ScannerReply
+{
+	ScannerCommands command;
+	QByteArray data;
+	IDeviceResponder* responder = nullptr;
+	QPointer<QObject> owner; //null once the responder has been destroyed, the reply is dropped
+	qint64 charged = 0; //network memory released once the responder has it
+	ReplyEncoding encoding = ReplyEncoding::Json; //what the request asked the scanner for
+};
+
+//fixed size single producer/single consumer queue of completed replies.
+//the connection's thread pushes and the thread that created the connection pops without either taking a lock,
+//replies are moved in and out so the payload is never copied
+class ReplyRing
+{
+public:
+	ReplyRing(int capacity);
+	~ReplyRing();
+
+	//producer side, the reply is left empty when it was taken
+	bool push(ScannerReply& reply);
+	bool isFull() const;
+
+	//consumer side
+	bool pop(ScannerReply& reply);
+	bool isEmpty() const;
+
+	int capacity() const { return int(mask) + 1; }
+
+private:
+	std::vector<ScannerReply> entries;
+	quint32 mask;
+
+	//free running counters, only the producer writes head and only the consumer writes tail
+	QAtomicInteger<quint32> head;
+	QAtomicInteger<quint32> tail;
+};
@@ -1,6 +1,7 @@
 #pragma once
 #include <QString>
 #include <qhostaddress.h>
+#include <QMetaType>
 
 class ScannerDeviceInformation
 {
@@ -11,3 +12,5 @@ public:
 	QString name;
 	QHostAddress address;
 };
+
+Q_DECLARE_METATYPE(ScannerDeviceInformation*)
@@ -1,18 +1,30 @@
 #include "ScannerInspectionTool.h"
-#include "ScannerResponseListener.h"
+#include "DiscoveryService.h"
 #include <QMessageBox>
 #include <QLabel>
 #include <QGraphicsItem>
+#include <QComboBox>
+#include <QDateTime>
 #include "ScannerInteraction.h"
 #include "parameterBuilder.h"
-#include "Lib/json.hpp"
 #include "ProjectView.h"
+#include "Trace.h"
+#include "PreviewCache.h"
+#include "MemoryBudget.h"
+#include "ContentStore.h"
+#include "TransferScheduler.h"
+#include <QFileDialog>
+#include <QActionGroup>
+#include <qdir.h>
 
 
 ScannerInspectionTool::ScannerInspectionTool(QWidget *parent)
 	: QMainWindow(parent)
 {
 	ui.setupUi(this);
+	qRegisterMetaType<ProjectSnapshotPtr>("ProjectSnapshotPtr");
+	qRegisterMetaType<ScannerCommands>("ScannerCommands");
+	qRegisterMetaType<ScannerDeviceInformation*>("ScannerDeviceInformation*");
 
 	deviceList = findChild<QListView*>("deviceList");
 	deviceList->setSelectionMode(QAbstractItemView::SingleSelection);
@@ -20,111 +32,182 @@ ScannerInspectionTool::ScannerInspectionTool(QWidget *parent)
 	deviceConnectBtn = findChild<QPushButton*>("deviceConnectBtn");
 	currentLbl = findChild<QLabel*>("currentLbl");
 	imgPreview = findChild<QGraphicsView*>("deviceImagePreview");
-	broadcastSocket = new QUdpSocket(this);
 
 	nameText = findChild<QLineEdit*>("nameText");
 	nameBtn = findChild<QPushButton*>("nameUpdateBtn");
 
-	scannerItems = new QStringList();
-	deviceList->setModel(new QStringListModel(*scannerItems));
+	sessions = new ScannerSessionManager(this);
+	deviceModel = new DeviceListModel(sessions);
+	deviceList->setModel(deviceModel);
+	connect(sessions, &ScannerSessionManager::sessionRemoved, this, &ScannerInspectionTool::sessionRemoved);
 
 	logRefresh = findChild<QPushButton*>("deviceLogsBtn");
-	logData = new QStringList();
 	logView = findChild<QListView*>("deviceLogs");
 	logView->setSelectionMode(QAbstractItemView::NoSelection);
-	logView->setModel(new QStringListModel(*logData));
+	logView->setUniformItemSizes(true);
+	logFilter = findChild<QLineEdit*>("logFilter");
+	logRange = findChild<QComboBox*>("logRange");
+	archiveResults = new QStringListModel(this);
 
 	scene = new QGraphicsScene;
 	scene->addText("No Image Selected");
 	imgPreview->setScene(scene);
 	refreshImagePreview();
 
-	timer = new QTimer(this);
-	timer->start(30000);
-
-	connect(timer, &QTimer::timeout, this, &ScannerInspectionTool::refreshDevices);
 	connect(deviceList, &QListView::clicked, this, &ScannerInspectionTool::selectionChanged);
 	connect(deviceList, &QListView::doubleClicked, this, &ScannerInspectionTool::handleConnectionBtn);
 	connect(deviceConnectBtn, &QPushButton::released, this, &ScannerInspectionTool::handleConnectionBtn);
 	connect(deviceScanBtn, &QPushButton::released, this, &ScannerInspectionTool::refreshDevices);
 	connect(nameBtn, &QPushButton::released, this, &ScannerInspectionTool::changeScannerName);
 	connect(logRefresh, SIGNAL(released()), this, SLOT(refreshLogs()));
+	connect(logFilter, &QLineEdit::textChanged, this, &ScannerInspectionTool::showLogs);
+	connect(logRange, static_cast<void(QComboBox::*)(int)>(&QComboBox::currentIndexChanged), this, &ScannerInspectionTool::showLogs);
 
 	QSplitter* top = findChild<QSplitter*>("topSplitter");
 	connect(top, &QSplitter::splitterMoved, this, &ScannerInspectionTool::splitterChanged);
 	QSplitter* left = findChild<QSplitter*>("leftSplitter");
 	connect(left, &QSplitter::splitterMoved, this, &ScannerInspectionTool::splitterChanged);
 
-	setupBroadcastListener();
+	setupDiscovery();
 	setupProjectView();
 	setupProjectTransfer();
 
 	//setup the direct interaction window and hide it in the background
 	directWn = new DirectInteractionWindow();
-	directWn->setConnection(connector);
 	DirectInteractionBtn = findChild<QAction*>("actionDirect_Interaction_Window");
 	connect(DirectInteractionBtn, &QAction::triggered, this, &ScannerInspectionTool::openDirectInteraction);
 
 	//setup the calibration window
 	calibWn = new CalibrationWindow();
-	calibWn->setConnection(connector);
 	CalibrationBtn = findChild<QAction*>("actionCalibration_Tool");
 	connect(CalibrationBtn, &QAction::triggered, this, &ScannerInspectionTool::openCalibration);
-	connect(transfer, &projectTransfer::projectUpdated, calibWn, &CalibrationWindow::updateProject);
-	connect(transfer, &projectTransfer::projectChanged, calibWn, &CalibrationWindow::projectSelected);
-	connect(transfer, &projectTransfer::imageTransfered, calibWn, &CalibrationWindow::newImageTransfered);
-	connect(connector, &ScannerInteraction::scannerConnected, calibWn, &CalibrationWindow::scannerConnected);
-	connect(connector, &ScannerInteraction::scannerConnectionLost, calibWn, &CalibrationWindow::scannerDisconnected);
 
-	emit refreshDevices();
+	//performance tracing, off until asked for
+	toolsError = new QErrorMessage(this);
+	RecordTraceBtn = findChild<QAction*>("actionRecord_Trace");
+	connect(RecordTraceBtn, &QAction::toggled, this, &ScannerInspectionTool::recordTrace);
+	SaveTraceBtn = findChild<QAction*>("actionSave_Trace");
+	connect(SaveTraceBtn, &QAction::triggered, this, &ScannerInspectionTool::saveTrace);
+
+	//live metrics, the panel starts hidden and is opened from the tools menu
+	MemoryBudget::loadSettings();
+	TrafficShaper::loadSettings();
+	metricsPanel = new MetricsPanel(this);
+	addDockWidget(Qt::RightDockWidgetArea, metricsPanel);
+	metricsPanel->hide();
+
+	metricsServer = new MetricsServer(this);
+	ServeMetricsBtn = findChild<QAction*>("actionServe_Metrics");
+	connect(ServeMetricsBtn, &QAction::toggled, this, &ScannerInspectionTool::serveMetrics);
+	findChild<QMenu*>("menuDirectInteraction")->insertAction(ServeMetricsBtn, metricsPanel->toggleViewAction());
+
+	//transfered images and calibration results are shared between project roots through the content store
+	ContentStore::loadSettings();
+	ContentStoreBtn = findChild<QAction*>("actionContent_Store");
+	connect(ContentStoreBtn, &QAction::triggered, this, &ScannerInspectionTool::chooseContentStore);
+
+	//the order the selected session's transfer fetches images in, new sessions start with the last one picked
+	QMenu* orderMenu = findChild<QMenu*>("menuDirectInteraction")->addMenu("Transfer Order");
+	TransferOrderGroup = new QActionGroup(this);
+	for (int i = 0; i <= int(TransferOrder::CalibrationCoverage); ++i)
+	{
+		QAction* action = orderMenu->addAction(TransferScheduler::title(TransferOrder(i)));
+		action->setCheckable(true);
+		action->setData(i);
+		TransferOrderGroup->addAction(action);
+	}
+	TransferOrderGroup->actions().at(int(TransferScheduler::savedOrder()))->setChecked(true);
+	connect(TransferOrderGroup, &QActionGroup::triggered, this, &ScannerInspectionTool::changeTransferOrder);
 }
 
 ScannerInspectionTool::~ScannerInspectionTool()
 {
-	delete broadcastSocket;
-	delete timer;
-	delete logData;
-
-	clearScanners();
-	delete scannerItems;
+	setActiveSession(nullptr);
+	delete deviceModel;
+	delete sessions;
 
 	//remove threaded items
-	listenerThread->quit();
-	listenerThread->wait();
-	delete listenerThread;
-	//delete listenSocket;
-	//delete connector;
+	discoveryThread->quit();
+	discoveryThread->wait();
+	delete discoveryThread;
 }
 
 void ScannerInspectionTool::refreshDevices()
 {
-	//clear out the existing data
-	clearScanners();
-	scannerItems->clear();
-	deviceList->model()->removeRows(0, deviceList->model()->rowCount());
+	QMetaObject::invokeMethod(discovery, "rediscover", Qt::QueuedConnection);
+}
+
+void ScannerInspectionTool::selectionChanged()
+{
+	setActiveSession(deviceModel->getSession(deviceList->selectionModel()->currentIndex()));
+}
 
-	broadcastSocket->writeDatagram(datagram.data(), datagram.size(), QHostAddress::Broadcast, brdPort);
+void ScannerInspectionTool::sessionRemoved(int index, ScannerSession* session)
+{
+	if (session == active) setActiveSession(nullptr);
 }
 
-void ScannerInspectionTool::selectionChanged() const
+//binds the panels and windows to the selected scanner session
+void ScannerInspectionTool::setActiveSession(ScannerSession* session)
 {
-	if (!connected)
+	if (session == active) return;
+
+	for (int i = 0; i < sessionLinks.size(); ++i)
+		disconnect(sessionLinks[i]);
+	sessionLinks.clear();
+
+	active = session;
+	ScannerInteraction* connection = activeConnection();
+	TransferEngine* engine = active == nullptr ? nullptr : active->getEngine();
+
+	projects->setConnection(connection);
+	transfer->setEngine(engine);
+	directWn->setConnection(connection);
+	calibWn->setConnection(connection);
+	calibWn->setProjectStore(engine == nullptr ? nullptr : engine->getStore());
+	TransferOrder order = engine == nullptr ? TransferScheduler::savedOrder() : engine->order();
+	TransferOrderGroup->actions().at(int(order))->setChecked(true);
+
+	if (active == nullptr)
 	{
-		deviceConnectBtn->setDisabled(false);
+		logView->setModel(nullptr);
+		nameText->clear();
+		deviceConnectBtn->setDisabled(true);
+		scannerDisconnected();
+		return;
 	}
+
+	sessionLinks.append(connect(connection, &ScannerInteraction::scannerConnected, this, &ScannerInspectionTool::scannerConnected));
+	sessionLinks.append(connect(connection, &ScannerInteraction::scannerConnectionLost, this, &ScannerInspectionTool::scannerDisconnected));
+	sessionLinks.append(connect(engine, &TransferEngine::projectUpdated, calibWn, &CalibrationWindow::updateProject));
+	sessionLinks.append(connect(engine, &TransferEngine::projectAboutToChange, calibWn, &CalibrationWindow::projectAboutToChange));
+	sessionLinks.append(connect(engine, &TransferEngine::projectChanged, calibWn, &CalibrationWindow::projectSelected));
+	sessionLinks.append(connect(engine, &TransferEngine::imageTransfered, calibWn, &CalibrationWindow::newImageTransfered));
+
+	sessionLinks.append(connect(active->getLogs()->getModel(), &QAbstractItemModel::rowsInserted, this, &ScannerInspectionTool::logLinesAdded));
+	showLogs();
+
+	if (engine->project() >= 0) calibWn->projectSelected(engine->projectDirectory(), engine->getStore()->snapshot());
+
+	nameText->setText(active->name());
+	deviceConnectBtn->setDisabled(false);
+	if (active->isConnected()) scannerConnected();
+	else scannerDisconnected();
 }
 
-void ScannerInspectionTool::setImagePreview(QString path) const
+void ScannerInspectionTool::setImagePreview(QString path, QByteArray hash) const
 {
 	scene->clear();
-	scene->addItem(new QGraphicsPixmapItem(QPixmap::fromImage(QImage(path))));
+	scene->addItem(new QGraphicsPixmapItem(PreviewCache::load(path, hash)));
 
 	refreshImagePreview();
 }
 
 void ScannerInspectionTool::handleConnectionBtn()
 {
-	if (connected)
+	if (active == nullptr) return;
+
+	if (active->isConnected())
 	{
 		//disconnect, show confirmation message
 		QMessageBox msgBox;
@@ -154,28 +237,17 @@ void ScannerInspectionTool::handleConnectionBtn()
 
 void ScannerInspectionTool::connectToScanner()
 {
-	QModelIndex current_index = deviceList->selectionModel()->currentIndex();
-	QString scannerName = current_index.data(Qt::DisplayRole).toString();
-
-	//find the network address for this device
-	ScannerDeviceInformation* deviceInformation = nullptr;
-	std::list<ScannerDeviceInformation*>::iterator it;
-	for (it = scanners.begin(); it != scanners.end(); ++it) {
-		if ((*it)->name == scannerName) {
-			deviceInformation = *it;
-			break;
-		}
-	}
-
-	if (deviceInformation == nullptr) return;
+	if (active == nullptr) return;
 
-	emit connector->connectToScanner(deviceInformation);
-	nameText->setText(deviceInformation->name);
+	active->connectToScanner();
+	nameText->setText(active->name());
 }
 
 void ScannerInspectionTool::disconnectFromScanner()
 {
-	emit connector->disconnect();
+	if (active == nullptr) return;
+
+	active->disconnectFromScanner();
 }
 
 void ScannerInspectionTool::scannerConnected()
@@ -183,9 +255,6 @@ void ScannerInspectionTool::scannerConnected()
 	deviceConnectBtn->setText("Disconnect");
 	currentLbl->setText("Connected");
 	currentLbl->setStyleSheet("color: rgb(0, 128, 0);");
-
-	connected = true;
-	refreshLogs(false);
 }
 
 void ScannerInspectionTool::scannerDisconnected()
@@ -193,31 +262,77 @@ void ScannerInspectionTool::scannerDisconnected()
 	deviceConnectBtn->setText("Connect");
 	currentLbl->setText("Disconnected");
 	currentLbl->setStyleSheet("color: rgb(237, 20, 61);");
-
-	connected = false;
 }
 
 void ScannerInspectionTool::changeScannerName()
 {
-	if (!connected) return;
+	if (active == nullptr || !active->isConnected()) return;
 
-	emit connector->requestScanner(ScannerCommands::setName,
+	emit activeConnection()->requestScanner(ScannerCommands::setName,
 		parameterBuilder().addParam("name", nameText->text())->toString(), this);
 
-	clearScanners();
-	emit refreshDevices();
+	//the new name is picked up when the scanner answers the broadcast, asked for now rather than at the next interval
+	refreshDevices();
 }
 
 void ScannerInspectionTool::refreshLogs()
 {
-	if (!connected) return;
+	if (active == nullptr || !active->isConnected()) return;
+
+	active->getLogs()->refresh();
+}
+
+//the live log of the session, or a search of its archive when a time range is picked
+void ScannerInspectionTool::showLogs()
+{
+	if (active == nullptr)
+	{
+		logView->setModel(nullptr);
+		return;
+	}
+
+	if (logRange->currentIndex() == 0)
+	{
+		LogRingModel* logs = active->getLogs()->getModel();
+		logs->setFilter(logFilter->text());
+		if (logView->model() != logs) logView->setModel(logs);
+		logView->scrollToBottom();
+		return;
+	}
+
+	const qint64 hour = 60 * 60 * 1000;
+	qint64 now = QDateTime::currentMSecsSinceEpoch();
+	qint64 from = 0;
+	switch (logRange->currentIndex())
+	{
+	case 1:
+		from = now - hour;
+		break;
+	case 2:
+		from = now - 24 * hour;
+		break;
+	case 3:
+		from = now - 3 * 24 * hour;
+		break;
+	default:
+		break;
+	}
+
+	QList<ArchivedLine> found = active->getLogs()->getArchive()->search(logFilter->text(), from, now);
+
+	QStringList lines;
+	lines.reserve(found.size());
+	for (int i = 0; i < found.size(); ++i)
+		lines.append(QDateTime::fromMSecsSinceEpoch(found[i].time).toString("yyyy-MM-dd hh:mm:ss") + "  " + found[i].text);
 
-	refreshLogs(true);
+	archiveResults->setStringList(lines);
+	if (logView->model() != archiveResults) logView->setModel(archiveResults);
+	logView->scrollToTop();
 }
 
-void ScannerInspectionTool::refreshLogs(bool partial)
+void ScannerInspectionTool::logLinesAdded()
 {
-	connector->requestScanner(partial ? ScannerCommands::getRecentLogDiff : ScannerCommands::getRecentLogFile, "", this);
+	if (logRange->currentIndex() == 0) logView->scrollToBottom();
 }
 
 void ScannerInspectionTool::refreshImagePreview() const
@@ -228,20 +343,13 @@ void ScannerInspectionTool::refreshImagePreview() const
 
 void ScannerInspectionTool::respondToScanner(ScannerCommands command, QByteArray data)
 {
-	switch (command)
-	{
-	case ScannerCommands::getRecentLogFile:
-	case ScannerCommands::getRecentLogDiff:
-		updateLogView(data);
-		break;
-	default:
-		return;
-	}
+	//logs are handled by the session's LogTail, name changes need no reply
 }
 
 void ScannerInspectionTool::openDirectInteraction()
 {
 	if (!directWn->isVisible()) directWn->show();
+	directWn->refreshStatistics();
 }
 
 void ScannerInspectionTool::openCalibration()
@@ -252,60 +360,89 @@ void ScannerInspectionTool::openCalibration()
 	}
 }
 
-void ScannerInspectionTool::splitterChanged(int pos, int index)
+void ScannerInspectionTool::recordTrace(bool record)
 {
-	refreshImagePreview();
+	//a new recording starts from nothing
+	if (record) Trace::clear();
+	Trace::setEnabled(record);
 }
 
-void ScannerInspectionTool::resizeEvent(QResizeEvent* event)
+void ScannerInspectionTool::saveTrace()
 {
-	QMainWindow::resizeEvent(event);
+	QString path = QFileDialog::getSaveFileName(this, "Save Performance Trace", "trace.json", "Chrome Trace (*.json)");
+	if (path.isEmpty()) return;
 
-	refreshImagePreview();
+	if (!Trace::writeChromeJson(path))
+		toolsError->showMessage("Couldn't write the trace to " + path);
 }
 
-void ScannerInspectionTool::addNewScanner(ScannerDeviceInformation* scanner)
+void ScannerInspectionTool::serveMetrics(bool serve)
 {
-	//check if the scanner is already tracked in the list
-	bool exists = false;
+	if (!serve)
+	{
+		metricsServer->close();
+		return;
+	}
 
-	std::list<ScannerDeviceInformation*>::iterator it;
-	for (it = scanners.begin(); it != scanners.end(); ++it) {
-		if ((*it)->address.isEqual(scanner->address)) {
-			exists = true;
-			break;
-		}
+	if (!metricsServer->listen())
+	{
+		toolsError->showMessage("Couldn't serve metrics: " + metricsServer->errorString());
+		ServeMetricsBtn->setChecked(false);
 	}
+}
+
+void ScannerInspectionTool::chooseContentStore()
+{
+	QString path = QFileDialog::getExistingDirectory(this, "Content Store Folder", ContentStore::root());
+	if (path.isEmpty()) return;
 
-	if (exists)
+	if (!QDir().mkpath(path))
 	{
-		//scanner already exists
-		delete scanner;
+		toolsError->showMessage("Couldn't create the content store in " + path);
 		return;
 	}
 
-	scanners.push_back(scanner);
-	scannerItems->append(scanner->name);
-	static_cast<QStringListModel*>(deviceList->model())->setStringList(*scannerItems);
+	//files already in the old store stay there, projects linked to them keep working
+	ContentStore::setRoot(path);
+	ContentStore::saveSettings();
 }
 
-void ScannerInspectionTool::setupBroadcastListener()
+void ScannerInspectionTool::changeTransferOrder(QAction* action)
 {
-	listenerThread = new QThread(this);
-	listener = new ScannerResponseListener();
-	listenerThread->setObjectName("Listener Thread");
-	listener->moveToThread(listenerThread);
-	connector = new ScannerInteraction();
-	connector->moveToThread(listenerThread);
-
-	connect(listenerThread, &QThread::started, listener, &ScannerResponseListener::startProcessing);
-	connect(listenerThread, &QThread::finished, listener, &QObject::deleteLater);
-	connect(listener, &ScannerResponseListener::newScannerFound, this, &ScannerInspectionTool::addNewScanner);
-	connect(connector, &ScannerInteraction::scannerConnected, this, &ScannerInspectionTool::scannerConnected);
-	connect(connector, &ScannerInteraction::scannerConnectionLost, this, &ScannerInspectionTool::scannerDisconnected);
-	//connect(connector, &ScannerInteraction::scannerResult, this, &ScannerInspectionTool::respondToScanner);
-
-	listenerThread->start();
+	TransferOrder order = TransferOrder(action->data().toInt());
+	TransferScheduler::saveOrder(order);
+
+	//takes effect from the next image if the transfer is running
+	if (active != nullptr) active->getEngine()->setOrder(order);
+}
+
+void ScannerInspectionTool::splitterChanged(int pos, int index)
+{
+	refreshImagePreview();
+}
+
+void ScannerInspectionTool::resizeEvent(QResizeEvent* event)
+{
+	QMainWindow::resizeEvent(event);
+
+	refreshImagePreview();
+}
+
+void ScannerInspectionTool::setupDiscovery()
+{
+	//discovery keeps a thread of its own so broadcast replies never wait behind a scanner connection
+	discoveryThread = new QThread(this);
+	discovery = new DiscoveryService();
+	discoveryThread->setObjectName("Discovery Thread");
+	discovery->moveToThread(discoveryThread);
+
+	connect(discoveryThread, &QThread::started, discovery, &DiscoveryService::start);
+	connect(discoveryThread, &QThread::finished, discovery, &QObject::deleteLater);
+	connect(discovery, &DiscoveryService::deviceFound, sessions, &ScannerSessionManager::addDevice);
+	connect(discovery, &DiscoveryService::deviceRenamed, sessions, &ScannerSessionManager::renameDevice);
+	connect(discovery, &DiscoveryService::deviceLost, sessions, &ScannerSessionManager::removeDevice);
+
+	discoveryThread->start();
 }
 
 void ScannerInspectionTool::setupProjectView()
@@ -314,7 +451,7 @@ void ScannerInspectionTool::setupProjectView()
 	QPushButton* refresh = findChild<QPushButton*>("projectRefresh");
 	QTableView* table = findChild<QTableView*>("projects");
 
-	projects = new ProjectView(refresh, trans, table, connector);
+	projects = new ProjectView(refresh, trans, table, nullptr);
 }
 
 void ScannerInspectionTool::setupProjectTransfer()
@@ -323,34 +460,8 @@ void ScannerInspectionTool::setupProjectTransfer()
 	QPushButton* pause = findChild<QPushButton*>("pausePlay");
 	QTreeView* progress = findChild<QTreeView*>("progress");
 
-	transfer = new projectTransfer(path, pause, progress, connector);
+	transfer = new projectTransfer(path, pause, progress);
 
 	connect(projects, &ProjectView::transferProject, transfer, &projectTransfer::changeTargetProject);
 	connect(transfer, &projectTransfer::triggerImagePreview, this, &ScannerInspectionTool::setImagePreview);
 }
-
-void ScannerInspectionTool::clearScanners()
-{
-	for (int i = scanners.size() - 1; i >= 0; --i) {
-		ScannerDeviceInformation* remove = scanners.back();
-		scanners.remove(remove);
-		delete remove;
-	}
-
-	scannerItems->clear();
-}
-
-void ScannerInspectionTool::updateLogView(QByteArray data)
-{
-	nlohmann::json j = nlohmann::json::parse(data.toStdString().c_str());
-
-	for (int i = 0; i < j.size(); ++i)
-	{
-		std::string normal = j[i];
-		QString* logString = new QString(normal.c_str());
-		logData->append(*logString);
-	}
-
-	static_cast<QStringListModel*>(logView->model())->setStringList(*logData);
-	logView->scrollToBottom();
-}
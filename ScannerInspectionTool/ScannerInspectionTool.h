@@ -3,22 +3,29 @@
 #include <QtWidgets/QMainWindow>
 #include <QtNetwork>
 #include "ScannerDeviceInformation.h"
-#include "ScannerResponseListener.h"
+#include "DiscoveryService.h"
 #include "ScannerInteraction.h"
+#include "ScannerSessionManager.h"
+#include "DeviceListModel.h"
 #include "DirectInteractionWindow.h"
 #include "ProjectView.h"
 #include "projectTransfer.h"
 #include "CalibrationWindow.h"
+#include "MetricsPanel.h"
+#include "MetricsServer.h"
 
 QT_BEGIN_NAMESPACE
 class QUdpSocket;
 class QPushButton;
 class QListView;
 class QAction;
+class QActionGroup;
 class QLabel;
 class QLineEdit;
 class QTimer;
 class QThread;
+class QComboBox;
+class QStringListModel;
 QT_END_NAMESPACE
 
 class ScannerInspectionTool : public QMainWindow, public IDeviceResponder
@@ -29,18 +36,18 @@ public:
 	ScannerInspectionTool(QWidget *parent = Q_NULLPTR);
 	~ScannerInspectionTool();
 
-	public slots:
-	void addNewScanner(ScannerDeviceInformation*);
-
 	private slots:
 	void refreshDevices();
-	void selectionChanged() const;
-	void setImagePreview(QString) const;
+	void selectionChanged();
+	void sessionRemoved(int index, ScannerSession* session);
+	void setImagePreview(QString, QByteArray) const;
 
 	//buttons
 	void handleConnectionBtn();
 	void changeScannerName();
 	void refreshLogs();
+	void showLogs();
+	void logLinesAdded();
 
 	//scanner interaction
 	void connectToScanner();
@@ -52,42 +59,48 @@ public:
 	//windows
 	void openDirectInteraction();
 	void openCalibration();
+	void recordTrace(bool record);
+	void saveTrace();
+	void serveMetrics(bool serve);
+	void chooseContentStore();
+	void changeTransferOrder(QAction* action);
 	void splitterChanged(int pos, int index);
 
 protected:
 	void resizeEvent(QResizeEvent *event) override;
 
 private:
-	void setupBroadcastListener();
+	void setupDiscovery();
 	void setupProjectView();
 	void setupProjectTransfer();
-	void clearScanners();
-	void updateLogView(QByteArray);
-	void refreshLogs(bool);
+	void setActiveSession(ScannerSession* session);
+	ScannerInteraction* activeConnection() const { return active == nullptr ? nullptr : active->getConnection(); }
 	void refreshImagePreview() const;
 
-	const int brdPort = 8470; //broadcast port
-
-	ScannerResponseListener* listener;
-	ScannerInteraction* connector;
+	DiscoveryService* discovery;
+	ScannerSessionManager* sessions;
+	DeviceListModel* deviceModel;
+	ScannerSession* active = nullptr;
+	QList<QMetaObject::Connection> sessionLinks;
 	ProjectView* projects;
 	projectTransfer* transfer;
-	QThread* listenerThread;
-	QStringList* scannerItems;
-	std::list<ScannerDeviceInformation*> scanners;
+	QThread* discoveryThread;
 
 	DirectInteractionWindow* directWn;
 	QAction* DirectInteractionBtn;
 	CalibrationWindow* calibWn;
 	QAction* CalibrationBtn;
+	QAction* RecordTraceBtn;
+	QAction* SaveTraceBtn;
+	QErrorMessage* toolsError;
+	MetricsPanel* metricsPanel;
+	MetricsServer* metricsServer;
+	QAction* ServeMetricsBtn;
+	QAction* ContentStoreBtn;
+	QActionGroup* TransferOrderGroup;
 
 	Ui::ScannerInspectionToolClass ui;
-	QByteArray datagram = "InspectionApp";
-	QTimer* timer;
-	QUdpSocket* broadcastSocket;
-	QUdpSocket* listenSocket;
 	QGraphicsScene* scene;
-	bool connected = false;
 
 	//ui elements
 	QListView* deviceList;
@@ -100,5 +113,7 @@ private:
 
 	QPushButton* logRefresh;
 	QListView* logView;
-	QStringList* logData;
+	QLineEdit* logFilter;
+	QComboBox* logRange;
+	QStringListModel* archiveResults;
 };
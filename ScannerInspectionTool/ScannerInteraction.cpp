@@ -1,89 +1,597 @@
 #include "ScannerInteraction.h"
 #include <QNetworkAccessManager>
 #include "ScannerDeviceInformation.h"
+#include "parameterBuilder.h"
+#include <QElapsedTimer>
+#include <QtEndian>
+#include <cctype>
+#include "Trace.h"
+#include "Metrics.h"
+#include "MemoryBudget.h"
 
 ScannerInteraction::ScannerInteraction()
 {
-	connection = new QTcpSocket();
-	connect(connection, &QTcpSocket::connected, this, &ScannerInteraction::scannerConnected);
+	//parented so the socket and timer move to the connection's thread with it
+	connection = new QTcpSocket(this);
+	connect(connection, &QTcpSocket::connected, this, &ScannerInteraction::connectionEstablished);
 	connect(connection, static_cast<void(QAbstractSocket::*)(QAbstractSocket::SocketError)>(&QAbstractSocket::error), this, &ScannerInteraction::connectionError);
-	connect(connection, &QTcpSocket::disconnected, this, &ScannerInteraction::scannerConnectionLost);
+	connect(connection, &QTcpSocket::disconnected, this, &ScannerInteraction::connectionClosed);
+	connect(connection, &QTcpSocket::readyRead, this, &ScannerInteraction::readReply);
+	//bounded so a reply read slower under the rate limit backs up to the scanner instead of into memory
+	connection->setReadBufferSize(readBufferSize);
+
+	stallTimer = new QTimer(this);
+	stallTimer->setSingleShot(true);
+	connect(stallTimer, &QTimer::timeout, this, &ScannerInteraction::replyStalled);
+
+	readThrottle = new QTimer(this);
+	readThrottle->setSingleShot(true);
+	connect(readThrottle, &QTimer::timeout, this, &ScannerInteraction::readReply);
+
+	share = TrafficShaper::join();
+	throttleTimer = new QTimer(this);
+	throttleTimer->setSingleShot(true);
+	connect(throttleTimer, &QTimer::timeout, this, &ScannerInteraction::processRequests);
+
+	//stays on the creating thread and empties the reply ring there,
+	//one wakeup is posted for however many replies arrive before it runs
+	replies = new ReplyRing(replyCapacity);
+	dispatcher = new QObject();
+	connect(this, &ScannerInteraction::repliesReady, dispatcher, [this]() { drainReplies(); }, Qt::QueuedConnection);
 }
 
 
 ScannerInteraction::~ScannerInteraction()
 {
-	delete connection;
+	MemoryBudget::release(MemoryCategory::Network, payloadCharge);
+	ScannerReply reply;
+	while (replies->pop(reply))
+		MemoryBudget::release(MemoryCategory::Network, reply.charged);
+
+	delete dispatcher;
+	delete replies;
+	TrafficShaper::leave(share);
 }
 
 void ScannerInteraction::requestScanner(ScannerCommands command, QString params, IDeviceResponder* responder)
 {
-	if (!connection->isWritable()) return;
+	requestScanner(command, params, responder, TrafficShaper::classOf(command));
+}
+
+void ScannerInteraction::requestScanner(ScannerCommands command, QString params, IDeviceResponder* responder, TrafficClass traffic)
+{
+	if (!isConnected()) return;
+
+	//the responder can be destroyed while its request is in flight, the reply is dropped rather than handed to it
+	QPointer<QObject> owner = dynamic_cast<QObject*>(responder);
+	{
+		QMutexLocker lock(&queueLock);
+		if (traffic == TrafficClass::Interactive) interactive.enqueue(PendingRequest{ command, params, responder, owner });
+		else requests.enqueue(PendingRequest{ command, params, responder, owner });
+	}
+	requestsInFlight()->add(1);
+
+	QMetaObject::invokeMethod(this, "processRequests", Qt::QueuedConnection);
+}
+
+//runs on the connection's thread, sends the next queued request once the last reply has been read
+void ScannerInteraction::processRequests()
+{
+	if (readState != ReadState::Idle)
+	{
+		//a transfer reply held back by the rate limit would keep the interactive request waiting for as long as
+		//the image takes at that rate, the rest of it is read straight away instead
+		if (readThrottle->isActive() && interactiveWaiting())
+		{
+			readThrottle->stop();
+			readReply();
+		}
+		return;
+	}
+	if (!isConnected()) return;
+
+	//wait for the consumer to make room rather than reading replies nobody can take yet
+	if (replies->isFull())
+	{
+		ringStalled.storeRelease(1);
+		if (replies->isFull()) return;
+		ringStalled.storeRelease(0);
+	}
+
+	//the same for replies holding more memory than the budget allows, a connection with nothing waiting
+	//always goes ahead so one large reply can't stop everything
+	if (MemoryBudget::exceeded(MemoryCategory::Network) && !replies->isEmpty())
+	{
+		ringStalled.storeRelease(1);
+		if (!replies->isEmpty()) return;
+		ringStalled.storeRelease(0);
+	}
+
+	//interactive requests go first, transfers wait for room under the rate limit. only this thread takes from the queues
+	bool waitingInteractive = false;
+	bool waitingTransfer = false;
+	{
+		QMutexLocker lock(&queueLock);
+		waitingInteractive = !interactive.isEmpty();
+		waitingTransfer = !requests.isEmpty();
+	}
+	if (!waitingInteractive && !waitingTransfer) return;
+
+	if (!waitingInteractive && !TrafficShaper::mayGo(share))
+	{
+		if (!throttleTimer->isActive()) throttleTimer->start(TrafficShaper::retryDelay());
+		return;
+	}
+
+	PendingRequest request;
+	{
+		QMutexLocker lock(&queueLock);
+		request = waitingInteractive ? interactive.dequeue() : requests.dequeue();
+	}
+
+	//the reply is decoded with what was asked for here, whatever the connection agrees on later
+	request.encoding = encodingFor(request.command);
+	if (request.encoding != ReplyEncoding::Json)
+		request.params += parameterBuilder().addParam("encoding", ReplyEncodings::name(request.encoding))->toString();
+	if (isCompressing() && compressibleReply(request.command))
+		request.params += parameterBuilder().addParam("compress", "zlib")->toString();
+
+	sendRequest(request);
+}
+
+void ScannerInteraction::sendRequest(const PendingRequest& request)
+{
+	QString data = QString(std::to_string(static_cast<int>(request.command)).c_str());
+	data += request.params;
 
-	QString data = QString(std::to_string(static_cast<int>(command)).c_str());
-	data += params;
+	inFlight = request;
+	readState = ReadState::Header;
+	payload = QByteArray();
+	received = 0;
+	accounted = 0;
+	headerLength = 0;
+	lengthKnown = false;
+	compressedReply = false;
+	framingNs = 0;
 
-	connection->write(data.toLatin1());
+	transferTimer.start();
+	requestStart = Trace::enabled() ? Trace::now() : -1;
+	stallTimer->start(stallTimeout);
 
-	connection->waitForReadyRead(-1);
-	QByteArray result = connection->read(returnLengthLimit);
+	TraceSpan span("send request", "network");
+	span.setBytes(connection->write(data.toLatin1()));
 
-	//extract message details
-	bool ok = true;
-	QString resultPrefix = result.mid(0, result.indexOf(">"));
-	int length = resultPrefix.mid(resultPrefix.indexOf(":") + 1).toInt(&ok);
+	//part of the reply may already be waiting
+	if (connection->bytesAvailable() > 0) readReply();
+}
 
-	if (ok)
+//reads whatever part of the reply has arrived.
+//the reply prefix is "<status>:<length>>", a third field of "z" marks a payload compressed with qCompress.
+//once the length is known the payload is read straight into a buffer of that size
+void ScannerInteraction::readReply()
+{
+	framingTimer.start();
+	TraceSpan span("read reply", "network");
+	span.setBytes(connection->bytesAvailable());
+
+	if (readState == ReadState::Header)
 	{
-		//initialise new array
-		int progress = 0;
-		QByteArray correct = QByteArray(length, 'NUL');
+		char prefix[maxHeaderLength];
+		qint64 available = connection->peek(prefix, maxHeaderLength);
+
+		int end = -1;
+		for (int i = 0; i < available; ++i)
 		{
-			int preLen = resultPrefix.length() + 1;
-			for (int i = preLen; i < result.length(); ++i, ++progress)
-				correct[i - preLen] = result[i];
+			if (prefix[i] != '>') continue;
+			end = i;
+			break;
 		}
-		while (progress < correct.length())
+
+		if (end < 0)
 		{
-			connection->waitForReadyRead(20000);
-			if (!connection->isReadable()) break;
-			QByteArray temp = connection->read(returnLengthLimit);
-
-			if (progress + temp.length() > correct.length())
-			{
-				//either there is another command in there or something is wrong
-				break;
-			}
-
-			for (int i = 0; i < temp.length(); ++i, ++progress)
-				correct[progress] = temp[i];
+			//a prefix arriving in pieces is waited for, bytes that can't be the start of one are a reply sent without it
+			framingNs += framingTimer.nsecsElapsed();
+			if (available >= maxHeaderLength || (available > 0 && !prefixStart(prefix, int(available)))) replyStalled();
+			return;
 		}
 
-		result = correct;
+		connection->read(prefix, end + 1);
+		headerLength = end + 1;
+
+		QString resultPrefix = QString::fromLatin1(prefix, end);
+		int length = resultPrefix.section(':', 1, 1).toInt(&lengthKnown);
+		if (length < 0) lengthKnown = false;
+
+		if (!lengthKnown)
+		{
+			payload = connection->readAll();
+			received = payload.size();
+			MemoryBudget::charge(MemoryCategory::Network, payload.size());
+			payloadCharge = payload.size();
+			completeReply();
+			return;
+		}
+
+		compressedReply = resultPrefix.section(':', 2, 2) == "z";
+		payload = QByteArray(length, Qt::Uninitialized);
+		MemoryBudget::charge(MemoryCategory::Network, length);
+		payloadCharge = length;
+		readState = ReadState::Payload;
 	}
-	else result = result.mid(result.indexOf(">") + 1);
 
-	//emit scannerResult(command, result);
-	if (responder == nullptr) return;
-	if (result.size() == 0) return;
+	if (readState == ReadState::Payload)
+	{
+		//transfer replies are read no faster than the rate limit unless an interactive request is waiting behind them,
+		//interactive ones are never held back. what's read is still taken from the bucket
+		qint64 wanted = payload.size() - received;
+		bool throttled = false;
+		if (TrafficShaper::classOf(inFlight.command) == TrafficClass::Transfer && !interactiveWaiting())
+		{
+			qint64 allowed = TrafficShaper::allowance();
+			throttled = allowed >= 0 && allowed < wanted;
+			if (throttled) wanted = allowed;
+		}
+
+		qint64 read = wanted > 0 ? connection->read(payload.data() + received, wanted) : 0;
+		if (read > 0)
+		{
+			received += read;
+			accounted += read;
+			TrafficShaper::consume(share, read);
+		}
+
+		if (received < payload.size())
+		{
+			//what's left in the socket doesn't signal again, it's picked up once the bucket has refilled
+			if (throttled && !readThrottle->isActive()) readThrottle->start(TrafficShaper::retryDelay());
+			framingNs += framingTimer.nsecsElapsed();
+			stallTimer->start(stallTimeout);
+			return;
+		}
 
-	emit responder->respondToScanner(command, result);
+		completeReply();
+	}
+}
+
+bool ScannerInteraction::interactiveWaiting()
+{
+	QMutexLocker lock(&queueLock);
+	return !interactive.isEmpty();
+}
+
+//whether the bytes could still be the start of "<status>:<length>>" or "<status>:<length>:z>"
+bool ScannerInteraction::prefixStart(const char* bytes, int size)
+{
+	int field = 0;
+	int fieldLength = 0;
+	for (int i = 0; i < size; ++i)
+	{
+		char c = bytes[i];
+		if (c == ':' && fieldLength > 0 && field < 2)
+		{
+			field++;
+			fieldLength = 0;
+			continue;
+		}
+
+		bool fits = field == 0 ? isalnum(uchar(c)) != 0 : field == 1 ? isdigit(uchar(c)) != 0 : c == 'z' && fieldLength == 0;
+		if (!fits) return false;
+		fieldLength++;
+	}
+	return true;
+}
+
+//the scanner stopped sending, take what arrived
+void ScannerInteraction::replyStalled()
+{
+	if (readState == ReadState::Idle) return;
+	framingTimer.start();
+
+	if (readState == ReadState::Header)
+	{
+		payload = connection->readAll();
+		received = payload.size();
+		lengthKnown = false;
+		MemoryBudget::charge(MemoryCategory::Network, payload.size());
+		payloadCharge = payload.size();
+	}
+
+	completeReply();
+}
+
+void ScannerInteraction::completeReply()
+{
+	stallTimer->stop();
+	readThrottle->stop();
+	readState = ReadState::Idle;
+	if (received < payload.size()) payload.resize(received);
+
+	qint64 transferNs = transferTimer.nsecsElapsed();
+	framingNs += framingTimer.nsecsElapsed();
+	qint64 wire = received + headerLength;
+	qint64 decompressNs = 0;
+	TrafficShaper::consume(share, wire - accounted);
+	accounted = 0;
+	bool compressed = lengthKnown && compressedReply;
+	bool corrupt = false;
+
+	QByteArray result;
+	result.swap(payload);
+
+	if (compressed)
+	{
+		QElapsedTimer decompressTimer;
+		decompressTimer.start();
+		TraceSpan span("decompress", "network");
+
+		//qUncompress gives back nothing for a corrupt payload, a reply that really was empty says so in its length field
+		bool empty = result.size() >= 4 && qFromBigEndian<quint32>(reinterpret_cast<const uchar*>(result.constData())) == 0;
+		result = qUncompress(result);
+		corrupt = result.isEmpty() && !empty;
+
+		span.setBytes(result.size());
+		decompressNs = decompressTimer.nsecsElapsed();
+	}
+
+	record(inFlight.command, wire, result.size(), transferNs, decompressNs, framingNs, compressed, corrupt);
+	if (corrupt) result = "Fail?The reply couldn't be decompressed";
+	if (requestStart >= 0) Trace::record("request", "network", requestStart, requestStart + transferNs, wire);
+	if (!negotiating) requestsInFlight()->add(-1);
+
+	//the charge follows the reply to its responder
+	qint64 charge = result.size();
+	MemoryBudget::charge(MemoryCategory::Network, charge - payloadCharge);
+	payloadCharge = 0;
+
+	if (negotiating)
+	{
+		negotiating = false;
+		finishNegotiation(QString(result));
+	}
+	else if (inFlight.responder != nullptr)
+	{
+		//empty replies are passed on as well, the responder treats them as a failure rather than waiting for good
+		ScannerReply reply;
+		reply.command = inFlight.command;
+		reply.data.swap(result);
+		reply.responder = inFlight.responder;
+		reply.owner = inFlight.owner;
+		reply.charged = charge;
+		reply.encoding = inFlight.encoding;
+
+		//room was checked before the request was sent
+		replies->push(reply);
+		if (wakePending.testAndSetOrdered(0, 1)) emit repliesReady();
+	}
+	else MemoryBudget::release(MemoryCategory::Network, charge);
+
+	processRequests();
+}
+
+//runs on the thread that created the connection
+void ScannerInteraction::drainReplies()
+{
+	wakePending.storeRelease(0);
+	TraceSpan span("dispatch replies", "network");
+
+	ScannerReply reply;
+	while (replies->pop(reply))
+	{
+		dispatching = reply.encoding;
+		if (!reply.owner.isNull()) reply.responder->respondToScanner(reply.command, reply.data);
+		MemoryBudget::release(MemoryCategory::Network, reply.charged);
+	}
+	reply.data.clear();
+	reply.owner.clear();
+
+	if (ringStalled.testAndSetOrdered(1, 0))
+		QMetaObject::invokeMethod(this, "processRequests", Qt::QueuedConnection);
+}
+
+ReplyEncoding ScannerInteraction::encodingFor(ScannerCommands command) const
+{
+	return binaryReply(command) ? ReplyEncoding(encoding.load()) : ReplyEncoding::Json;
+}
+
+//asks the scanner for a binary encoding and compression, scanners that don't know about them ignore the
+//parameters and reply with only their version, otherwise the reply is "<version>&encoding=<name>&compression=<name>"
+void ScannerInteraction::negotiate()
+{
+	encoding.store(int(ReplyEncoding::Json));
+	compression.store(0);
+	if (preferredEncoding == ReplyEncoding::Json && !compressionPreferred)
+	{
+		finishNegotiation("");
+		return;
+	}
+
+	parameterBuilder params = parameterBuilder();
+	if (preferredEncoding != ReplyEncoding::Json) params.addParam("encodings", ReplyEncodings::name(preferredEncoding));
+	if (compressionPreferred) params.addParam("compression", "zlib");
+
+	//sent ahead of the request queue, which stays closed until the reply is in
+	negotiating = true;
+	sendRequest(PendingRequest{ ScannerCommands::ApiVersion, params.toString(), nullptr });
+}
+
+//the connection counts as established once the encoding is agreed
+void ScannerInteraction::finishNegotiation(const QString& reply)
+{
+	if (!reply.startsWith("Fail")) parseNegotiation(reply);
+
+	online.store(1);
+	emit scannerConnected();
+}
+
+void ScannerInteraction::parseNegotiation(const QString& reply)
+{
+	int index = reply.indexOf("encoding=");
+	if (index >= 0)
+	{
+		ReplyEncoding agreed = ReplyEncodings::fromName(reply.mid(index + 9).section('&', 0, 0).trimmed());
+		if (agreed == preferredEncoding) encoding.store(int(agreed));
+	}
+
+	index = reply.indexOf("compression=");
+	if (index >= 0 && compressionPreferred)
+		compression.store(reply.mid(index + 12).section('&', 0, 0).trimmed() == "zlib" ? 1 : 0);
+}
+
+MetricGauge* ScannerInteraction::requestsInFlight()
+{
+	static MetricGauge* metric = Metrics::gauge("scanner_requests_in_flight", "Requests queued or waiting for their reply");
+	return metric;
+}
+
+MetricCounter* ScannerInteraction::receivedBytesTotal()
+{
+	static MetricCounter* metric = Metrics::counter("scanner_received_bytes_total", "Bytes read from scanner connections");
+	return metric;
+}
+
+MetricCounter* ScannerInteraction::decompressFailures()
+{
+	static MetricCounter* metric = Metrics::counter("scanner_decompress_failures_total", "Compressed replies that couldn't be decompressed");
+	return metric;
+}
+
+QMap<int, CommandStatistics> ScannerInteraction::statistics() const
+{
+	QMutexLocker lock(&statsLock);
+	return stats;
+}
+
+void ScannerInteraction::resetStatistics()
+{
+	{
+		QMutexLocker lock(&statsLock);
+		stats.clear();
+	}
+
+	emit statisticsUpdated();
+}
+
+qint64 ScannerInteraction::receivedBytes() const
+{
+	QMutexLocker lock(&statsLock);
+	return totalWireBytes;
+}
+
+void ScannerInteraction::record(ScannerCommands command, qint64 wire, qint64 payload, qint64 transferNs, qint64 decompressNs, qint64 framingNs, bool compressed, bool corrupt)
+{
+	{
+		QMutexLocker lock(&statsLock);
+		CommandStatistics& entry = stats[static_cast<int>(command)];
+
+		entry.replies++;
+		if (compressed) entry.compressedReplies++;
+		if (corrupt) entry.decompressFailures++;
+		entry.wireBytes += wire;
+		totalWireBytes += wire;
+		entry.payloadBytes += payload;
+		entry.transferNs += transferNs;
+		entry.decompressNs += decompressNs;
+		entry.framingNs += framingNs;
+	}
+
+	receivedBytesTotal()->add(wire);
+	if (corrupt) decompressFailures()->add();
+	Metrics::histogram("scanner_request_seconds", "Time from a request being sent to its whole reply being read",
+		"command=\"" + QString::number(static_cast<int>(command)) + "\"")->observe(transferNs / 1000000000.0);
+
+	emit statisticsUpdated();
+}
+
+//image data is already compressed so it is never asked for
+bool ScannerInteraction::compressibleReply(ScannerCommands command)
+{
+	switch (command)
+	{
+	case ScannerCommands::getRecentLogFile:
+	case ScannerCommands::getRecentLogDiff:
+	case ScannerCommands::getLoadedProjects:
+	case ScannerCommands::CameraPairs:
+	case ScannerCommands::getCameraPairConfiguration:
+	case ScannerCommands::getAllImageSets:
+	case ScannerCommands::ImageSetMetaData:
+	case ScannerCommands::ProjectDetails:
+		return true;
+	default:
+		return false;
+	}
+}
+
+bool ScannerInteraction::binaryReply(ScannerCommands command)
+{
+	switch (command)
+	{
+	case ScannerCommands::ProjectDetails:
+	case ScannerCommands::getAllImageSets:
+	case ScannerCommands::CameraPairs:
+	case ScannerCommands::getRecentLogFile:
+	case ScannerCommands::getRecentLogDiff:
+		return true;
+	default:
+		return false;
+	}
 }
 
 void ScannerInteraction::connectToScanner(ScannerDeviceInformation* device)
 {
-	connection->connectToHost(device->address, communicationPort);
+	address = device->address;
+	QMetaObject::invokeMethod(this, "openConnection", Qt::QueuedConnection);
 }
 
 void ScannerInteraction::disconnect()
 {
-	if (connection->ConnectedState == QAbstractSocket::ConnectedState) {
+	QMetaObject::invokeMethod(this, "closeConnection", Qt::QueuedConnection);
+}
+
+void ScannerInteraction::openConnection()
+{
+	connection->connectToHost(address, communicationPort);
+}
+
+void ScannerInteraction::closeConnection()
+{
+	if (connection->state() == QAbstractSocket::ConnectedState) {
 		connection->disconnectFromHost();
 	}
 }
 
+void ScannerInteraction::connectionEstablished()
+{
+	negotiate();
+}
+
+void ScannerInteraction::connectionClosed()
+{
+	if (readState != ReadState::Idle && !negotiating) requestsInFlight()->add(-1);
+	stallTimer->stop();
+	readThrottle->stop();
+	readState = ReadState::Idle;
+	negotiating = false;
+	payload = QByteArray();
+	MemoryBudget::release(MemoryCategory::Network, payloadCharge);
+	payloadCharge = 0;
+
+	if (online.fetchAndStoreOrdered(0) == 0) return;
+
+	{
+		QMutexLocker lock(&queueLock);
+		requestsInFlight()->add(-requests.size() - interactive.size());
+		requests.clear();
+		interactive.clear();
+	}
+
+	encoding.store(int(ReplyEncoding::Json));
+	compression.store(0);
+	emit scannerConnectionLost();
+}
+
 void ScannerInteraction::connectionError(QAbstractSocket::SocketError)
 {
 	//todo log error
-	emit scannerConnectionLost();
+	if (isConnected()) connectionClosed();
+	else emit scannerConnectionLost();
 }
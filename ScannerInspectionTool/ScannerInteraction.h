@@ -1,11 +1,42 @@
 #pragma once
 #include <QObject>
+#include <QTimer>
 #include <qtcpsocket.h>
+#include <QMap>
+#include <QMutex>
+#include <QQueue>
+#include <QHostAddress>
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QPointer>
 #include "IDeviceResponder.h"
+#include "ReplyEncoding.h"
+#include "ReplyRing.h"
+#include "TrafficShaper.h"
 
 enum class ScannerCommands;
 class ScannerDeviceInformation;
+class MetricGauge;
+class MetricCounter;
 
+//wire cost of the replies to one command
+struct CommandStatistics
+{
+	qint64 replies = 0;
+	qint64 compressedReplies = 0;
+	qint64 decompressFailures = 0; //passed on to the responder as a failure
+	qint64 wireBytes = 0; //read from the socket
+	qint64 payloadBytes = 0; //after decompression
+	qint64 transferNs = 0; //request written to last byte read
+	qint64 decompressNs = 0;
+	qint64 framingNs = 0; //reading the header and payload off the socket on the connection's thread
+};
+
+//connection to one scanner, meant to live on its own thread (see ScannerSession).
+//requests can be made from any thread, they are queued and sent in order from the connection's thread, interactive
+//ones ahead of transfers and transfers within the rate limit (see TrafficShaper).
+//replies are read as they arrive without blocking the thread, then passed through a reply ring to the
+//thread that created the connection and handed to the responder there
 class ScannerInteraction : public QObject
 {
 	Q_OBJECT
@@ -18,23 +49,130 @@ public:
 	void connectToScanner(ScannerDeviceInformation* device);
 	//void requestScanner(ScannerCommands, QString);
 	void requestScanner(ScannerCommands command, QString params, IDeviceResponder* responder);
+	//the class is worked out from the command unless given
+	void requestScanner(ScannerCommands command, QString params, IDeviceResponder* responder, TrafficClass traffic);
 	void disconnect();
 
-	bool isConnected() { return connection->isWritable(); }
+	bool isConnected() const { return online.load() != 0; }
+
+	//encoding of the reply being handed to its responder, the one asked for when the request was sent.
+	//only meaningful inside respondToScanner
+	ReplyEncoding replyEncoding() const { return dispatching; }
+	//binary encoding to ask the scanner for on the next connection, json turns negotiation off
+	void setPreferredEncoding(ReplyEncoding encoding) { preferredEncoding = encoding; }
+	//ask for zlib compressed replies to text heavy commands on the next connection
+	void setCompressionEnabled(bool enabled) { compressionPreferred = enabled; }
+	bool isCompressing() const { return compression.load() != 0; }
+	//this connection's part of the rate limit next to the other scanners', 1 by default
+	void setShareWeight(int weight) { TrafficShaper::setWeight(share, weight); }
+
+	//keyed by command number
+	QMap<int, CommandStatistics> statistics() const;
+	void resetStatistics();
+	//bytes read from the socket since the connection was created, not cleared by resetStatistics
+	qint64 receivedBytes() const;
+
+	//shared by every connection, the reply latency is the scanner_request_seconds histogram
+	static MetricGauge* requestsInFlight();
+	static MetricCounter* receivedBytesTotal();
+	static MetricCounter* decompressFailures();
 
 signals:
 	void scannerConnected();
 	void scannerConnectionLost();
 	void scannerResult(ScannerCommands, QByteArray);
+	void repliesReady();
+	void statisticsUpdated();
 
 	private slots:
+	void openConnection();
+	void closeConnection();
+	void processRequests();
+	void readReply();
+	void replyStalled();
+	void connectionEstablished();
+	void connectionClosed();
 	void connectionError(QAbstractSocket::SocketError);
 
 private:
+	struct PendingRequest
+	{
+		ScannerCommands command;
+		QString params;
+		IDeviceResponder* responder;
+		QPointer<QObject> owner; //the responder as a QObject, null once it has been destroyed
+		ReplyEncoding encoding; //filled in when the request is sent
+	};
+
+	enum class ReadState
+	{
+		Idle,
+		Header,
+		Payload
+	};
+
+	void sendRequest(const PendingRequest& request);
+	void completeReply();
+	void drainReplies();
+	void negotiate();
+	void finishNegotiation(const QString& reply);
+	void parseNegotiation(const QString& reply);
+	void record(ScannerCommands command, qint64 wire, qint64 payload, qint64 transferNs, qint64 decompressNs, qint64 framingNs, bool compressed, bool corrupt);
+	//json unless a binary encoding was agreed on connection
+	ReplyEncoding encodingFor(ScannerCommands command) const;
+	bool interactiveWaiting();
+	static bool binaryReply(ScannerCommands command);
+	static bool prefixStart(const char* bytes, int size);
+	static bool compressibleReply(ScannerCommands command);
+
 	QTcpSocket* connection;
+	QHostAddress address;
+	QAtomicInt online = QAtomicInt(0);
+	QObject* dispatcher;
+	ReplyRing* replies;
+	QAtomicInt wakePending = QAtomicInt(0);
+	QAtomicInt ringStalled = QAtomicInt(0);
+
+	//reply being read, only touched on the connection's thread
+	ReadState readState = ReadState::Idle;
+	PendingRequest inFlight;
+	bool negotiating = false;
+	QByteArray payload;
+	qint64 received = 0;
+	qint64 headerLength = 0;
+	bool lengthKnown = false;
+	bool compressedReply = false;
+	QElapsedTimer transferTimer;
+	QElapsedTimer framingTimer;
+	qint64 requestStart = -1; //trace clock, -1 when tracing was off
+	qint64 framingNs = 0;
+	qint64 payloadCharge = 0; //network memory charged for the reply being read
+	QTimer* stallTimer;
+	QTimer* readThrottle; //reads the rest of a transfer reply once the rate limit allows
+	qint64 accounted = 0; //bytes of the reply already taken from the rate limit
+
+	QMutex queueLock;
+	QQueue<PendingRequest> interactive;
+	QQueue<PendingRequest> requests; //transfers
+	TrafficShare* share;
+	QTimer* throttleTimer;
+
+	ReplyEncoding preferredEncoding = ReplyEncoding::Cbor;
+	bool compressionPreferred = true;
+	//agreed on the connection's thread, read from others
+	QAtomicInt encoding = QAtomicInt(int(ReplyEncoding::Json));
+	QAtomicInt compression = QAtomicInt(0);
+	ReplyEncoding dispatching = ReplyEncoding::Json; //only touched on the thread that created the connection
+
+	mutable QMutex statsLock;
+	QMap<int, CommandStatistics> stats;
+	qint64 totalWireBytes = 0;
 
 	const qint16 communicationPort = 8472;
-	const qint64 returnLengthLimit = 128000; //128Kb
+	static const int maxHeaderLength = 64;
+	const int replyCapacity = 64;
+	const qint64 readBufferSize = 1024 * 1024; //held in the socket before the scanner is slowed down
+	const int stallTimeout = 20000; //20sec
 };
 
 enum class ScannerCommands
@@ -61,7 +199,10 @@ enum class ScannerCommands
 	getAllImageSets = 310,
 	ImageSetMetaData = 320,
 	ImageSetImageData = 321,
+	ImageSetImageBatch = 322, //several images of a set in one reply, see ReplyReader::readImageFrames
 	ProjectDetails = 330,
 	CurrentProject = 331,
 	setProjectNiceName = 350,
-};
\ No newline at end of file
+};
+
+Q_DECLARE_METATYPE(ScannerCommands)
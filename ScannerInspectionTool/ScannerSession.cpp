@@ -0,0 +1,93 @@
+#include "ScannerSession.h"
+#include <QThread>
+#include "DiscoveryService.h"
+
+
+ScannerSession::ScannerSession(ScannerDeviceInformation* device, QObject* parent) : QObject(parent)
+{
+	this->device = device;
+
+	connectionThread = new QThread(this);
+	connectionThread->setObjectName("Scanner " + device->address.toString());
+
+	//the engine and log are created first so they stay on this thread, only the connection moves
+	connection = new ScannerInteraction();
+	engine = new TransferEngine(connection, this);
+	engine->setOrder(TransferScheduler::savedOrder());
+	logs = new LogTail(connection, LogArchive::defaultDirectory(DiscoveryService::deviceId(device->address)), this);
+	connection->moveToThread(connectionThread);
+
+	connect(connection, &ScannerInteraction::scannerConnected, this, &ScannerSession::scannerConnected);
+	connect(connection, &ScannerInteraction::scannerConnectionLost, this, &ScannerSession::scannerDisconnected);
+
+	sampleTimer = new QTimer(this);
+	connect(sampleTimer, &QTimer::timeout, this, &ScannerSession::sampleThroughput);
+	sampleTimer->start(samplePeriod);
+
+	connectionThread->start();
+}
+
+ScannerSession::~ScannerSession()
+{
+	//once the thread has stopped the connection can be removed from here, which also drops any
+	//replies still waiting to be handed to the engine
+	connectionThread->quit();
+	connectionThread->wait();
+	delete connection;
+
+	engine->pause();
+	delete engine;
+	delete device;
+}
+
+void ScannerSession::setName(const QString& name)
+{
+	if (device->name == name) return;
+
+	device->name = name;
+	emit stateChanged(this);
+}
+
+void ScannerSession::connectToScanner()
+{
+	autoConnect = true;
+	if (connected) return;
+
+	emit connection->connectToScanner(device);
+}
+
+void ScannerSession::disconnectFromScanner()
+{
+	autoConnect = false;
+	engine->pause();
+
+	emit connection->disconnect();
+}
+
+void ScannerSession::scannerConnected()
+{
+	connected = true;
+	lastBytes = connection->receivedBytes();
+	emit stateChanged(this);
+}
+
+void ScannerSession::scannerDisconnected()
+{
+	connected = false;
+	bytesPerSecond = 0;
+	emit stateChanged(this);
+}
+
+void ScannerSession::sampleThroughput()
+{
+	if (!connected) return;
+
+	qint64 bytes = connection->receivedBytes();
+	double rate = (bytes - lastBytes) * 1000.0 / samplePeriod;
+	lastBytes = bytes;
+
+	if (rate == bytesPerSecond) return;
+
+	bytesPerSecond = rate;
+	emit stateChanged(this);
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <QObject>
+#include <QTimer>
+#include "ScannerDeviceInformation.h"
+#include "ScannerInteraction.h"
+#include "TransferEngine.h"
+#include "LogTail.h"
+
+QT_BEGIN_NAMESPACE
+class QThread;
+QT_END_NAMESPACE
+
+//a live connection to one scanner, the connection runs on its own thread with its own request queue
+//and the transfer engine follows a project for that scanner alone
+class ScannerSession : public QObject
+{
+	Q_OBJECT
+
+public:
+	ScannerSession(ScannerDeviceInformation* device, QObject* parent = Q_NULLPTR);
+	~ScannerSession();
+
+	QString name() const { return device->name; }
+	void setName(const QString& name);
+	QHostAddress address() const { return device->address; }
+	ScannerInteraction* getConnection() const { return connection; }
+	TransferEngine* getEngine() const { return engine; }
+	LogTail* getLogs() const { return logs; }
+	bool isConnected() const { return connected; }
+	//false once the user has closed the session, it is then left alone when devices are refreshed
+	bool wanted() const { return autoConnect; }
+	//bytes per second received over the last sample period
+	double throughput() const { return bytesPerSecond; }
+
+	signals:
+	void stateChanged(ScannerSession*);
+
+	public slots:
+	void connectToScanner();
+	void disconnectFromScanner();
+
+	private slots:
+	void scannerConnected();
+	void scannerDisconnected();
+	void sampleThroughput();
+
+private:
+	ScannerDeviceInformation* device;
+	ScannerInteraction* connection;
+	TransferEngine* engine;
+	LogTail* logs;
+	QThread* connectionThread;
+	QTimer* sampleTimer;
+
+	bool connected = false;
+	bool autoConnect = true;
+	qint64 lastBytes = 0;
+	double bytesPerSecond = 0;
+
+	const int samplePeriod = 1000; //1sec
+};
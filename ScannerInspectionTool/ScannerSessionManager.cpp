@@ -0,0 +1,89 @@
+#include "ScannerSessionManager.h"
+#include "DiscoveryService.h"
+
+
+ScannerSessionManager::ScannerSessionManager(QObject* parent) : QObject(parent)
+{
+}
+
+ScannerSessionManager::~ScannerSessionManager()
+{
+	for (int i = 0; i < sessions.size(); ++i)
+		delete sessions[i];
+	sessions.clear();
+	lookup.clear();
+}
+
+void ScannerSessionManager::addDevice(ScannerDeviceInformation* device)
+{
+	QString id = DiscoveryService::deviceId(device->address);
+	lost.remove(id);
+
+	ScannerSession* existing = find(id);
+	if (existing != nullptr)
+	{
+		//scanner came back, pick the connection up again unless the user closed it
+		existing->setName(device->name);
+		if (!existing->isConnected() && existing->wanted()) existing->connectToScanner();
+
+		delete device;
+		return;
+	}
+
+	ScannerSession* session = new ScannerSession(device);
+	connect(session, &ScannerSession::stateChanged, this, &ScannerSessionManager::sessionStateChanged);
+
+	sessions.append(session);
+	lookup.insert(id, session);
+	emit sessionAdded(sessions.size() - 1);
+
+	session->connectToScanner();
+}
+
+void ScannerSessionManager::renameDevice(QString id, QString name)
+{
+	ScannerSession* session = find(id);
+	if (session != nullptr) session->setName(name);
+}
+
+void ScannerSessionManager::removeDevice(QString id)
+{
+	ScannerSession* session = find(id);
+	if (session == nullptr) return;
+
+	//an open connection is proof enough that the scanner is still there
+	if (session->isConnected())
+	{
+		lost.insert(id);
+		return;
+	}
+
+	removeSession(sessions.indexOf(session));
+}
+
+void ScannerSessionManager::sessionStateChanged(ScannerSession* session)
+{
+	int index = sessions.indexOf(session);
+	if (index < 0) return;
+
+	if (!session->isConnected() && lost.contains(DiscoveryService::deviceId(session->address())))
+	{
+		removeSession(index);
+		return;
+	}
+
+	emit sessionChanged(index);
+}
+
+void ScannerSessionManager::removeSession(int index)
+{
+	ScannerSession* session = sessions.takeAt(index);
+	QString id = DiscoveryService::deviceId(session->address());
+	lookup.remove(id);
+	lost.remove(id);
+
+	emit sessionRemoved(index, session);
+
+	//may be in the middle of emitting a signal
+	session->deleteLater();
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <QObject>
+#include <QList>
+#include <QHash>
+#include <QSet>
+#include "ScannerSession.h"
+
+//holds a session for every scanner the discovery service knows about and connects to each of them
+class ScannerSessionManager : public QObject
+{
+	Q_OBJECT
+
+public:
+	ScannerSessionManager(QObject* parent = Q_NULLPTR);
+	~ScannerSessionManager();
+
+	int count() const { return sessions.size(); }
+	ScannerSession* session(int index) const { return sessions.at(index); }
+	int indexOf(ScannerSession* session) const { return sessions.indexOf(session); }
+	ScannerSession* find(const QString& id) const { return lookup.value(id, nullptr); }
+
+	signals:
+	void sessionAdded(int index);
+	void sessionChanged(int index);
+	void sessionRemoved(int index, ScannerSession* session);
+
+	public slots:
+	void addDevice(ScannerDeviceInformation* device);
+	void renameDevice(QString id, QString name);
+	//a scanner that stopped answering is dropped once it has no connection
+	void removeDevice(QString id);
+
+	private slots:
+	void sessionStateChanged(ScannerSession* session);
+
+private:
+	void removeSession(int index);
+
+	QList<ScannerSession*> sessions;
+	QHash<QString, ScannerSession*> lookup;
+	QSet<QString> lost;
+};
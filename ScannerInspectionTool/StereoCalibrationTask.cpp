@@ -1,7 +1,10 @@
 #include "StereoCalibrationTask.h"
 #include <map>
 #include "Lib/json.hpp"
-#include <QFileDialog>
+#include "Trace.h"
+#include "Metrics.h"
+#include "CalibrationEngine.h"
+#include <QFile>
 #include <opencv2/core/persistence.hpp>
 #include <opencv2/calib3d/calib3d_c.h>
 #include <opencv2/calib3d.hpp>
@@ -9,16 +12,17 @@
 
 using namespace nlohmann;
 
-StereoCalibrationTask::StereoCalibrationTask(QString leftConfigPath, vector<QString> leftImageConfigLocations, QString rightConfigPath, vector<QString> rightImageConfigLocations, QString sampleImagePath, QString savePath)
+StereoCalibrationTask::StereoCalibrationTask(QString leftConfigPath, vector<QString> leftImageConfigLocations, QString rightConfigPath, vector<QString> rightImageConfigLocations, QString sampleImagePath, QString savePath, bool yaml)
 {
 	leftPath = leftConfigPath;
 	rightPath = rightConfigPath;
 
 	leftConfigImages = leftImageConfigLocations;
-	rightConfigImages = leftImageConfigLocations;
+	rightConfigImages = rightImageConfigLocations;
 
 	imageSamplePath = sampleImagePath;
 	this->savePath = savePath;
+	writeYaml = yaml;
 }
 
 StereoCalibrationTask::~StereoCalibrationTask()
@@ -27,43 +31,82 @@ StereoCalibrationTask::~StereoCalibrationTask()
 
 void StereoCalibrationTask::run()
 {
+	MetricHold busy(CalibrationEngine::busyWorkers(), CalibrationEngine::finishedTasks("pair"));
+
 	generatePointData();
+	if (leftPoints.empty())
+	{
+		error = "No image pairs with matching points";
+		return;
+	}
 
 	Mat K1, K2, D1, D2, R, F, E;
 	Vec3d T;
 	int flags = CV_CALIB_FIX_INTRINSIC;
 	Size imageSize = imread(imageSamplePath.toStdString()).size();
+	if (imageSize.width == 0 || imageSize.height == 0)
 	{
-		FileStorage leftCam(leftPath.toStdString(), FileStorage::READ);
-		leftCam["K"] >> K1;
-		leftCam["D"] >> D1;
-
-		FileStorage rightCam(rightPath.toStdString(), FileStorage::READ);
-		rightCam["K"] >> K2;
-		rightCam["D"] >> D2;
+		error = "No camera image found";
+		return;
 	}
 
+	try {
+		{
+			FileStorage leftCam(leftPath.toStdString(), FileStorage::READ);
+			leftCam["K"] >> K1;
+			leftCam["D"] >> D1;
+
+			FileStorage rightCam(rightPath.toStdString(), FileStorage::READ);
+			rightCam["K"] >> K2;
+			rightCam["D"] >> D2;
+		}
+
+		{
+			TraceSpan span("stereoCalibrate", "opencv");
+			rms = stereoCalibrate(objectPoints, leftPoints, rightPoints, K1, D1, K2, D2, imageSize, R, T, E, F, flags);
+		}
+
+		Mat R1, R2, P1, P2, Q;
+		{
+			TraceSpan span("stereoRectify", "opencv");
+			stereoRectify(K1, D1, K2, D2, imageSize, R, T, R1, R2, P1, P2, Q);
+		}
+
+		//saveResult, the yaml copy is only opened when asked for
+		TraceSpan span("write pair result", "disk");
+		FileStorage stereoSave(savePath.toStdString(), FileStorage::WRITE);
+		FileStorage yamlSave;
+		if (writeYaml) yamlSave.open(savePath.section('.', 0, -2).toStdString() + ".yml", FileStorage::WRITE);
 
-	stereoCalibrate(objectPoints, leftPoints, rightPoints, K1, D1, K2, D2, imageSize, R, T, E, F, flags);
-
-	Mat R1, R2, P1, P2, Q;
-	stereoRectify(K1, D1, K2, D2, imageSize, R, T, R1, R2, P1, P2, Q);
-
-	//saveResult
-	FileStorage stereoSave(savePath.toStdString(), FileStorage::WRITE);
-	stereoSave << "K1" << K1;
-	stereoSave << "K2" << K2;
-	stereoSave << "D1" << D1;
-	stereoSave << "D2" << D2;
-	stereoSave << "R1" << R1;
-	stereoSave << "R2" << R2;
-	stereoSave << "P1" << P1;
-	stereoSave << "P2" << P2;
-	stereoSave << "R" << R;
-	stereoSave << "T" << T;
-	stereoSave << "E" << E;
-	stereoSave << "F" << F;
-	stereoSave << "Q" << Q;
+		FileStorage* outputs[] = { &stereoSave, &yamlSave };
+		for (int i = 0; i < 2; ++i)
+		{
+			if (!outputs[i]->isOpened()) continue;
+
+			FileStorage& output = *outputs[i];
+			output << "K1" << K1;
+			output << "K2" << K2;
+			output << "D1" << D1;
+			output << "D2" << D2;
+			output << "R1" << R1;
+			output << "R2" << R2;
+			output << "P1" << P1;
+			output << "P2" << P2;
+			output << "R" << R;
+			output << "T" << T;
+			output << "E" << E;
+			output << "F" << F;
+			output << "Q" << Q;
+			output << "rms" << rms;
+		}
+	}
+	catch (cv::Exception& e)
+	{
+		error = QString::fromStdString(e.msg);
+		return;
+	}
+
+	success = true;
 }
 
 void StereoCalibrationTask::generatePointData()
@@ -96,6 +139,8 @@ void StereoCalibrationTask::generatePointData()
 		}
 	}
 
+	if (leftConfigImages.empty() || rightConfigImages.empty()) return;
+
 	//calculate greatest set number to avoid skipping a valid image pair
 	int totalSize = leftConfigImages.size();
 	{
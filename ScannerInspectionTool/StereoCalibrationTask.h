@@ -11,11 +11,17 @@ using namespace cv;
 class StereoCalibrationTask : public QRunnable
 {
 public:
-	StereoCalibrationTask(QString leftConfigPath, vector<QString> leftImageConfigLocations, QString rightConfigPath, vector<QString> rightImageConfigLocations, QString sampleImagePath, QString savePath);
+	StereoCalibrationTask(QString leftConfigPath, vector<QString> leftImageConfigLocations, QString rightConfigPath, vector<QString> rightImageConfigLocations, QString sampleImagePath, QString savePath, bool yaml = false);
 	~StereoCalibrationTask();
 
 	void run() override;
 
+	//only valid once the task has run
+	bool succeeded() const { return success; }
+	const QString& failure() const { return error; }
+	//reprojection rms in pixels over both cameras, also saved with the result
+	double reprojectionError() const { return rms; }
+
 private:
 	void generatePointData();
 	vector<Point2f> loadPointData(QString path);
@@ -24,6 +30,10 @@ private:
 	QString imageSamplePath;
 	QString savePath;
 	vector<QString> leftConfigImages, rightConfigImages;
+	bool writeYaml;
+	bool success = false;
+	QString error;
+	double rms = 0;
 
 	const float squareSize = 24.23; // in mm
 	const int boardWidth = 9;
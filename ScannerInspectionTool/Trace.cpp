@@ -0,0 +1,219 @@
+#include "Trace.h"
+#include <QElapsedTimer>
+#include <QFile>
+#include <QMutex>
+#include <QThread>
+#include <QCoreApplication>
+#include <vector>
+#include <algorithm>
+
+std::atomic<bool> Trace::on(false);
+
+namespace
+{
+	const quint64 bufferCapacity = 16384; //events kept per thread
+
+	struct TraceEvent
+	{
+		const char* name;
+		const char* category;
+		qint64 start; //ns on the trace clock
+		qint64 duration;
+		qint64 bytes; //-1 when not set
+	};
+
+	//written by its own thread only, read when the trace is written. a thread that has finished still
+	//shows in the trace until a new thread takes its ring over, so there are only as many rings as threads alive at once
+	struct TraceBuffer
+	{
+		int tid; //guarded by the registry lock, like name and free
+		QString name;
+		bool free;
+		std::vector<TraceEvent> events;
+		std::atomic<quint64> written;
+		std::atomic<quint64> floor; //events before this were cleared
+	};
+
+	QMutex registryLock;
+	std::vector<TraceBuffer*> buffers;
+	int lastTid = 0;
+
+	void releaseBuffer(TraceBuffer* buffer);
+
+	//hands the ring back when its thread exits
+	struct LocalBuffer
+	{
+		TraceBuffer* buffer = nullptr;
+		~LocalBuffer() { if (buffer != nullptr) releaseBuffer(buffer); }
+	};
+	thread_local LocalBuffer localBuffer;
+
+	QElapsedTimer& traceClock()
+	{
+		static QElapsedTimer clock = []() {
+			QElapsedTimer started;
+			started.start();
+			return started;
+		}();
+		return clock;
+	}
+
+	TraceBuffer* acquireBuffer()
+	{
+		QMutexLocker lock(&registryLock);
+		TraceBuffer* buffer = nullptr;
+		for (size_t i = 0; i < buffers.size() && buffer == nullptr; ++i)
+			if (buffers[i]->free) buffer = buffers[i];
+
+		if (buffer == nullptr)
+		{
+			buffer = new TraceBuffer();
+			buffer->events.resize(bufferCapacity);
+			buffer->written.store(0);
+			buffer->floor.store(0);
+			buffers.push_back(buffer);
+		}
+
+		//the last thread's events go with it, the new one shows as a thread of its own
+		buffer->floor.store(buffer->written.load());
+		buffer->free = false;
+		buffer->tid = ++lastTid;
+		QThread* thread = QThread::currentThread();
+		buffer->name = thread->objectName();
+		if (buffer->name.isEmpty() && QCoreApplication::instance() && thread == QCoreApplication::instance()->thread())
+			buffer->name = "Main Thread";
+		if (buffer->name.isEmpty()) buffer->name = "Thread " + QString::number(buffer->tid);
+		return buffer;
+	}
+
+	void releaseBuffer(TraceBuffer* buffer)
+	{
+		QMutexLocker lock(&registryLock);
+		buffer->free = true;
+	}
+
+	TraceBuffer* threadBuffer()
+	{
+		if (localBuffer.buffer == nullptr) localBuffer.buffer = acquireBuffer();
+		return localBuffer.buffer;
+	}
+
+	void appendEscaped(QByteArray& json, const QByteArray& text)
+	{
+		for (int i = 0; i < text.size(); ++i)
+		{
+			char c = text.at(i);
+			if (c == '"' || c == '\\') json.append('\\');
+			if (uchar(c) < 0x20) json.append(' ');
+			else json.append(c);
+		}
+	}
+}
+
+void Trace::setEnabled(bool enabled)
+{
+	traceClock();
+	on.store(enabled);
+}
+
+qint64 Trace::now()
+{
+	return traceClock().nsecsElapsed();
+}
+
+void Trace::record(const char* name, const char* category, qint64 start, qint64 end, qint64 bytes)
+{
+	if (!enabled()) return;
+
+	TraceBuffer* buffer = threadBuffer();
+	quint64 index = buffer->written.load(std::memory_order_relaxed);
+
+	TraceEvent& event = buffer->events[index % bufferCapacity];
+	event.name = name;
+	event.category = category;
+	event.start = start;
+	event.duration = end - start;
+	event.bytes = bytes;
+
+	buffer->written.store(index + 1, std::memory_order_release);
+}
+
+void Trace::nameThread(const QString& name)
+{
+	TraceBuffer* buffer = threadBuffer();
+
+	QMutexLocker lock(&registryLock);
+	buffer->name = name;
+}
+
+QByteArray Trace::chromeJson()
+{
+	QByteArray json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	bool first = true;
+
+	QMutexLocker lock(&registryLock);
+	for (size_t i = 0; i < buffers.size(); ++i)
+	{
+		TraceBuffer* buffer = buffers[i];
+
+		//copied while the thread may still be recording, whatever was overwritten during the copy is dropped
+		quint64 end = buffer->written.load(std::memory_order_acquire);
+		quint64 begin = std::max(buffer->floor.load(), end > bufferCapacity ? end - bufferCapacity : 0);
+		std::vector<TraceEvent> events;
+		events.reserve(end - begin);
+		for (quint64 j = begin; j < end; ++j)
+			events.push_back(buffer->events[j % bufferCapacity]);
+
+		//the slot after the last written one may be half way through being written as well
+		quint64 after = buffer->written.load(std::memory_order_acquire);
+		quint64 overwritten = after >= bufferCapacity ? after - bufferCapacity + 1 : 0;
+		size_t skip = overwritten > begin ? size_t(std::min(overwritten - begin, quint64(events.size()))) : 0;
+
+		json += first ? "" : ",";
+		first = false;
+		json += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" + QByteArray::number(buffer->tid) + ",\"args\":{\"name\":\"";
+		appendEscaped(json, buffer->name.toUtf8());
+		json += "\"}}";
+
+		for (size_t j = skip; j < events.size(); ++j)
+		{
+			const TraceEvent& event = events[j];
+			json += ",{\"name\":\"";
+			appendEscaped(json, event.name);
+			json += "\",\"cat\":\"";
+			appendEscaped(json, event.category);
+			json += "\",\"ph\":\"X\",\"pid\":1,\"tid\":" + QByteArray::number(buffer->tid);
+			json += ",\"ts\":" + QByteArray::number(event.start / 1000.0, 'f', 3);
+			json += ",\"dur\":" + QByteArray::number(event.duration / 1000.0, 'f', 3);
+			if (event.bytes >= 0) json += ",\"args\":{\"bytes\":" + QByteArray::number(event.bytes) + "}";
+			json += "}";
+		}
+	}
+
+	json += "]}";
+	return json;
+}
+
+bool Trace::writeChromeJson(const QString& path)
+{
+	QByteArray json = chromeJson();
+	QFile traceFile(path);
+	bool saved = false;
+
+	try {
+		if (traceFile.open(QIODevice::WriteOnly))
+			saved = traceFile.write(json) == json.size();
+		traceFile.close();
+	}
+	catch (std::exception) {}
+	if (traceFile.isOpen()) traceFile.close();
+
+	return saved;
+}
+
+void Trace::clear()
+{
+	QMutexLocker lock(&registryLock);
+	for (size_t i = 0; i < buffers.size(); ++i)
+		buffers[i]->floor.store(buffers[i]->written.load());
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <QByteArray>
+#include <QString>
+#include <atomic>
+
+//low overhead tracing of where the time goes, written as chrome trace event json (chrome://tracing or
+//ui.perfetto.dev). spans go into a ring per thread that only that thread writes to, so recording takes no lock,
+//and each ring keeps its newest events once full. with tracing off a span costs one relaxed atomic load
+class Trace
+{
+public:
+	static bool enabled() { return on.load(std::memory_order_relaxed); }
+	static void setEnabled(bool enabled);
+
+	//ns on the trace clock
+	static qint64 now();
+	//a span that starts and ends in different places, like a request and its reply. name and category have
+	//to live until the trace is written, string literals are what they are meant for
+	static void record(const char* name, const char* category, qint64 start, qint64 end, qint64 bytes = -1);
+	//how the calling thread shows in the trace, the thread's object name by default
+	static void nameThread(const QString& name);
+
+	static QByteArray chromeJson();
+	static bool writeChromeJson(const QString& path);
+	//drops everything recorded so far
+	static void clear();
+
+private:
+	static std::atomic<bool> on;
+};
+
+//records the time from construction to destruction on the current thread
+class TraceSpan
+{
+public:
+	TraceSpan(const char* name, const char* category) : name(name), category(category)
+	{
+		start = Trace::enabled() ? Trace::now() : -1;
+	}
+	~TraceSpan()
+	{
+		if (start >= 0) Trace::record(name, category, start, Trace::now(), bytes);
+	}
+
+	void setBytes(qint64 bytes) { this->bytes = bytes; }
+
+private:
+	const char* name;
+	const char* category;
+	qint64 start;
+	qint64 bytes = -1;
+};
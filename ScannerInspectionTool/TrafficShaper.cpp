@@ -0,0 +1,164 @@
+#include "TrafficShaper.h"
+#include <QSettings>
+#include <QMutexLocker>
+#include <cmath>
+#include "ScannerInteraction.h"
+#include "Metrics.h"
+
+QMutex TrafficShaper::lock;
+QList<TrafficShare*> TrafficShaper::shares;
+qint64 TrafficShaper::limit = 0;
+double TrafficShaper::tokens = 0;
+QElapsedTimer TrafficShaper::clock;
+qint64 TrafficShaper::refilled = 0;
+
+namespace
+{
+	MetricGauge* rateLimit()
+	{
+		static MetricGauge* metric = Metrics::gauge("scanner_rate_limit_bytes", "Bytes per second the scanner connections may read together, 0 is no limit");
+		return metric;
+	}
+}
+
+//the metadata goes with the images, the transfer relies on a set's hashes arriving before its images
+TrafficClass TrafficShaper::classOf(ScannerCommands command)
+{
+	switch (command)
+	{
+	case ScannerCommands::getAllImageSets:
+	case ScannerCommands::ImageSetMetaData:
+	case ScannerCommands::ImageSetImageData:
+	case ScannerCommands::ImageSetImageBatch:
+		return TrafficClass::Transfer;
+	default:
+		return TrafficClass::Interactive;
+	}
+}
+
+qint64 TrafficShaper::rate()
+{
+	QMutexLocker locker(&lock);
+	return limit;
+}
+
+void TrafficShaper::setRate(qint64 bytesPerSecond)
+{
+	QMutexLocker locker(&lock);
+	refill();
+
+	limit = qMax(qint64(0), bytesPerSecond);
+	tokens = qMin(tokens, limit * burstMs / 1000.0);
+	if (limit == 0) tokens = 0;
+
+	MetricGauge* gauge = rateLimit();
+	gauge->add(limit - gauge->current());
+}
+
+void TrafficShaper::loadSettings()
+{
+	QSettings settings("MultiCapture", "ScannerInspectionTool");
+	setRate(settings.value("network/rateLimit", 0).toLongLong());
+}
+
+void TrafficShaper::saveSettings()
+{
+	QSettings settings("MultiCapture", "ScannerInspectionTool");
+	settings.setValue("network/rateLimit", rate());
+}
+
+TrafficShare* TrafficShaper::join()
+{
+	QMutexLocker locker(&lock);
+	TrafficShare* share = new TrafficShare();
+	shares.append(share);
+	return share;
+}
+
+void TrafficShaper::leave(TrafficShare* share)
+{
+	QMutexLocker locker(&lock);
+	shares.removeOne(share);
+	delete share;
+}
+
+void TrafficShaper::setWeight(TrafficShare* share, int weight)
+{
+	QMutexLocker locker(&lock);
+	share->weight = qMax(1, weight);
+}
+
+bool TrafficShaper::mayGo(TrafficShare* share)
+{
+	QMutexLocker locker(&lock);
+	if (limit <= 0)
+	{
+		share->asked = -1;
+		return true;
+	}
+
+	refill();
+	qint64 now = clock.elapsed();
+
+	//a connection that hasn't asked for a while doesn't bank the share it didn't use, it starts level with the ones that have
+	if (!waiting(share, now))
+	{
+		double least = -1;
+		for (int i = 0; i < shares.size(); ++i)
+		{
+			const TrafficShare* other = shares.at(i);
+			if (other != share && waiting(other, now) && (least < 0 || other->used < least)) least = other->used;
+		}
+		if (least > share->used) share->used = least;
+	}
+	share->asked = now;
+
+	if (tokens < 0) return false;
+	for (int i = 0; i < shares.size(); ++i)
+	{
+		const TrafficShare* other = shares.at(i);
+		if (other != share && waiting(other, now) && other->used < share->used) return false;
+	}
+	return true;
+}
+
+int TrafficShaper::retryDelay()
+{
+	QMutexLocker locker(&lock);
+	if (limit <= 0) return 0;
+	refill();
+
+	//short enough that a connection whose turn it is, or a higher limit, isn't waited on for long
+	int wait = tokens < 0 ? int(std::ceil(-tokens * 1000 / limit)) : 0;
+	return qBound(10, wait, 100);
+}
+
+void TrafficShaper::consume(TrafficShare* share, qint64 bytes)
+{
+	if (bytes <= 0) return;
+
+	QMutexLocker locker(&lock);
+	share->used += double(bytes) / share->weight;
+	if (limit <= 0) return;
+
+	refill();
+	tokens -= bytes;
+}
+
+qint64 TrafficShaper::allowance()
+{
+	QMutexLocker locker(&lock);
+	if (limit <= 0) return -1;
+
+	refill();
+	return tokens > 0 ? qint64(tokens) : 0;
+}
+
+void TrafficShaper::refill()
+{
+	if (!clock.isValid()) clock.start();
+
+	qint64 now = clock.elapsed();
+	tokens = qMin(tokens + (now - refilled) * limit / 1000.0, limit * burstMs / 1000.0);
+	refilled = now;
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <QMutex>
+#include <QList>
+#include <QElapsedTimer>
+
+enum class ScannerCommands;
+
+//how a request waits its turn on its connection
+enum class TrafficClass
+{
+	Interactive, //someone is waiting on the reply, goes ahead of everything and is never held back
+	Transfer //bulk image data, fills what's left of the rate limit
+};
+
+//one connection's part of the shared bandwidth
+struct TrafficShare
+{
+	int weight = 1;
+	double used = 0; //bytes over weight, the waiting connection with the least goes first
+	qint64 asked = -1; //clock ms the connection last wanted to send a transfer request
+};
+
+//caps the bandwidth of the scanner connections so a bulk pull leaves room on a link the scanners need for capturing.
+//one token bucket is shared by every connection, since they normally share the machine's link. every byte read
+//takes from it, transfer requests are held back while it's empty and the connections waiting take turns by weight.
+//transfer replies are also read no faster than the bucket allows, the socket buffers fill and tcp slows the scanner.
+//a reply an interactive request is waiting behind is read at full speed, the bucket still pays for it.
+//the limit is also the scanner_rate_limit_bytes metric, 0 means no limit
+class TrafficShaper
+{
+public:
+	static TrafficClass classOf(ScannerCommands command);
+
+	//bytes per second across every connection, can be changed while requests are waiting
+	static qint64 rate();
+	static void setRate(qint64 bytesPerSecond);
+	//the limit is kept in the user's settings between runs
+	static void loadSettings();
+	static void saveSettings();
+
+	static TrafficShare* join();
+	static void leave(TrafficShare* share);
+	static void setWeight(TrafficShare* share, int weight);
+
+	//whether the connection may send its next transfer request now. it takes part in the sharing for as long as it
+	//keeps asking
+	static bool mayGo(TrafficShare* share);
+	//milliseconds until a held back connection should ask again
+	static int retryDelay();
+	//bytes read by a connection, whatever the request was
+	static void consume(TrafficShare* share, qint64 bytes);
+	//bytes of a transfer reply that may be read now, -1 when there's no limit
+	static qint64 allowance();
+
+private:
+	static void refill();
+	static bool waiting(const TrafficShare* share, qint64 now) { return share->asked >= 0 && now - share->asked <= staleWait; }
+
+	static const int burstMs = 1000; //the bucket holds this much of the rate
+	static const int staleWait = 250; //ms without asking before a connection no longer counts as taking part
+
+	static QMutex lock;
+	static QList<TrafficShare*> shares;
+	static qint64 limit;
+	static double tokens;
+	static QElapsedTimer clock;
+	static qint64 refilled; //clock ms
+};
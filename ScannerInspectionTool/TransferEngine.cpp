@@ -0,0 +1,738 @@
+#include "TransferEngine.h"
+#include "parameterBuilder.h"
+#include "JsonStream.h"
+#include <qdir.h>
+#include <QFile>
+#include <QHash>
+#include <QElapsedTimer>
+#include "Trace.h"
+#include "Metrics.h"
+#include "ReplyReader.h"
+#include "ContentStore.h"
+
+namespace
+{
+	MetricCounter* bytesWritten()
+	{
+		static MetricCounter* metric = Metrics::counter("transfer_written_bytes_total", "Image bytes written to disk by transfers");
+		return metric;
+	}
+
+	MetricCounter* imagesLinked()
+	{
+		static MetricCounter* metric = Metrics::counter("transfer_linked_images_total", "Images linked from the local content store instead of transfered");
+		return metric;
+	}
+
+	MetricCounter* verifyFailures()
+	{
+		static MetricCounter* metric = Metrics::counter("transfer_verify_failures_total", "Images that didn't match the size or hash the scanner reported");
+		return metric;
+	}
+}
+
+
+TransferEngine::TransferEngine(ScannerInteraction* connector, QObject* parent) : QObject(parent)
+{
+	this->connector = connector;
+
+	timer = new QTimer(this);
+	timer->setInterval(60000);
+
+	connect(connector, &ScannerInteraction::scannerConnected, this, &TransferEngine::newScannerConnection);
+	connect(connector, &ScannerInteraction::scannerConnectionLost, this, &TransferEngine::connectionLost);
+	connect(timer, &QTimer::timeout, this, &TransferEngine::timerReset);
+}
+
+
+TransferEngine::~TransferEngine()
+{
+	imagesRemaining()->add(-remaining);
+	delete scheduler;
+	delete modelCharge;
+	delete store;
+	delete timer;
+}
+
+bool TransferEngine::setTarget(const QString& root, int project)
+{
+	if (transfering) return false;
+	if (project == currentProject) timer->start();
+	else timer->stop();
+
+	transferRoot = root;
+	projectId = project;
+	initialLoad = true;
+
+	connector->requestScanner(ScannerCommands::ProjectDetails,
+		parameterBuilder().addParam("id", QString::number(project))->toString(), this);
+	connector->requestScanner(ScannerCommands::CameraPairs, "", this);
+	return true;
+}
+
+void TransferEngine::setOrder(TransferOrder order)
+{
+	transferOrder = order;
+	delete scheduler;
+	scheduler = TransferScheduler::create(order);
+	scheduler->setPairs(pairs);
+	reorder();
+}
+
+void TransferEngine::start()
+{
+	resumeRequired = false;
+	if (transfering) return;
+
+	//images that failed before get another go
+	if (imageInFlight) rewind = true;
+	else initalTransferSetup();
+	if (lastTransferReached())
+	{
+		emit transferComplete();
+		return;
+	}
+
+	transfering = true;
+	emit transferStateChanged(true);
+
+	//an image asked for before the pause carries the transfer on when it arrives
+	if (!imageInFlight) requestCurrentImage();
+}
+
+void TransferEngine::pause()
+{
+	resumeRequired = false;
+	if (!transfering) return;
+
+	transfering = false;
+	emit transferStateChanged(false);
+}
+
+void TransferEngine::respondToScanner(ScannerCommands command, QByteArray data)
+{
+	switch (command)
+	{
+	case ScannerCommands::ProjectDetails:
+		processProjectDetails(data);
+		break;
+	case ScannerCommands::ImageSetMetaData:
+		processContent(data);
+		break;
+	case ScannerCommands::ImageSetImageData:
+		continueTransfer(data);
+		break;
+	case ScannerCommands::ImageSetImageBatch:
+		continueBatch(data);
+		break;
+	case ScannerCommands::CurrentProject:
+		currentScanner(data);
+		break;
+	case ScannerCommands::CameraPairs:
+		processCameraPairs(data);
+		break;
+	default:
+		return;
+	}
+}
+
+void TransferEngine::newScannerConnection()
+{
+	connector->requestScanner(ScannerCommands::CurrentProject, "", this);
+
+	//a transfer cut off by the disconnect carries on once the project has been checked again
+	if (transfering && resumeRequired && projectId >= 0)
+		connector->requestScanner(ScannerCommands::ProjectDetails,
+			parameterBuilder().addParam("id", QString::number(projectId))->toString(), this);
+}
+
+//the requests still queued were dropped with the connection, their replies never come
+void TransferEngine::connectionLost()
+{
+	if (imageInFlight || rewind) initalTransferSetup();
+	imageInFlight = false;
+	rewind = false;
+	retries = 0;
+
+	if (transfering) resumeRequired = true;
+
+	//sets whose content was never sent are asked for again with the project details
+	contentRequested.clear();
+	contentPending.clear();
+}
+
+void TransferEngine::timerReset()
+{
+	connector->requestScanner(ScannerCommands::ProjectDetails,
+		parameterBuilder().addParam("id", QString::number(projectId))->toString(), this);
+
+	if (projectId == currentProject) timer->start();
+}
+
+void TransferEngine::processProjectDetails(QByteArray data)
+{
+	//nothing arrived, the project is asked for again on the next refresh
+	if (data.isEmpty()) return;
+	if (data.startsWith("Fail"))
+	{
+		QString response = QString(data);
+		emit transferError(response.mid(response.indexOf("?") + 1));
+		return;
+	}
+
+	//the scanner sends the whole project every time, nothing to do if it hasn't changed
+	bool unchanged = !initialLoad && data == lastDetails;
+	ReplyEncoding encoding = connector->replyEncoding();
+
+	if (!unchanged)
+	{
+		QString directory = projectDirectory();
+		if (!QDir(directory).exists()) QDir().mkdir(directory);
+
+		QString projectFilePath = directory + "/project.scan";
+		QFile projectFile(projectFilePath);
+
+		TraceSpan span("write project", "disk");
+		try {
+			projectFile.open(QIODevice::WriteOnly);
+			//project.scan stays json whatever the reply was sent as
+			projectFile.write(JsonStream::toJson(data, encoding));
+			projectFile.close();
+		}
+		catch (std::exception) {}
+		if (projectFile.isOpen()) projectFile.close();
+	}
+
+	ProjectSnapshotPtr snapshot = store->snapshot();
+	if (!unchanged)
+	{
+		TraceSpan span("parse project", "model");
+		span.setBytes(data.size());
+		snapshot = ProjectSnapshot::parse(data, encoding);
+	}
+	if (snapshot.isNull()) return;
+	lastDetails = data;
+
+	if (snapshot->projectId() == projectId && !initialLoad)
+	{
+		//must be a potential update to the project
+		int firstNew = store->setCount();
+		ProjectSnapshotPtr previous = store->snapshot();
+		bool appended = unchanged || store->appends(snapshot);
+
+		//the views start again from the new snapshot, they have to know before the store changes under them
+		if (!appended) emit projectAboutToChange();
+		if (!unchanged) store->update(snapshot);
+
+		if (appended)
+		{
+			for (int i = firstNew; i < store->setCount(); ++i)
+				loadTransferState(i);
+
+			emit setsAppended(firstNew);
+			if (store->setCount() > firstNew) emit newProjectImageDetected();
+		}
+		else
+		{
+			//sets that are new or changed are checked on disk, the rest carried their state over in the update
+			for (int i = 0; i < store->setCount(); ++i)
+			{
+				int old = previous.isNull() ? -1 : previous->setRow(store->setId(i));
+				if (old < 0 || previous->imageCount(old) != store->imageCount(i) || previous->setName(old) != store->setName(i))
+					loadTransferState(i);
+			}
+			reorder();
+		}
+		requestContent();
+
+		if (transfering && resumeRequired && !imageInFlight)
+		{
+			iterateTransferIndex();
+			if (!lastTransferReached())
+			{
+				resumeRequired = false;
+				requestCurrentImage();
+			}
+		}
+
+		//existing sets changing means the views need to start again from the new snapshot
+		updateRemaining();
+		modelCharge->resize(store->memoryUsed());
+		if (appended) emit projectUpdated(projectDirectory(), snapshot);
+		else emit projectChanged(projectDirectory(), snapshot);
+	}
+	else
+	{
+		//clear the old project information and regnerate the new stuff
+		emit projectAboutToChange();
+		store->reset(snapshot);
+		for (int i = 0; i < store->setCount(); ++i)
+			loadTransferState(i);
+
+		reorder();
+		initialLoad = false;
+
+		contentRequested.clear();
+		requestContent();
+
+		updateRemaining();
+		modelCharge->resize(store->memoryUsed());
+		emit projectChanged(projectDirectory(), snapshot);
+	}
+}
+
+void TransferEngine::currentScanner(QByteArray data)
+{
+	QString result = QString(data);
+	if (result.isEmpty()) return;
+	if (result.startsWith("Fail")) emit transferError(result.mid(result.indexOf("?") + 1));
+
+	currentProject = result.toInt();
+}
+
+//scanners without pairs leave the pair orders fetching in set order
+void TransferEngine::processCameraPairs(QByteArray data)
+{
+	std::vector<CameraPair> cameras = std::vector<CameraPair>();
+	if (!ReplyReader::readCameraPairs(data, cameras, connector->replyEncoding())) return;
+
+	pairs = cameras;
+	scheduler->setPairs(pairs);
+	reorder();
+}
+
+bool TransferEngine::lastTransferReached() const
+{
+	if (transferSet >= store->setCount() || transferImage >= store->imageCount(transferSet))
+		return true;
+	return false;
+}
+
+//the scheduler is asked after every image so sets that arrive during the transfer are fitted in as they come
+void TransferEngine::iterateTransferIndex()
+{
+	int set = 0;
+	int image = 0;
+	if (scheduler->next(store, set, image))
+	{
+		transferSet = set;
+		transferImage = image - store->firstImage(set);
+	}
+	else
+	{
+		transferSet = store->setCount();
+		transferImage = 0;
+	}
+}
+
+//the order changed, the image being fetched is written first and the next one comes from the new order
+void TransferEngine::reorder()
+{
+	if (imageInFlight) rewind = true;
+	else initalTransferSetup();
+}
+
+//content already in the store from another transfer is linked into the project instead of sent again
+bool TransferEngine::linkExisting()
+{
+	int image = currentImage();
+	const QByteArray& hash = store->contentHash(image);
+	if (!ContentStore::contains(hash, store->contentSize(image))) return false;
+
+	TraceSpan span("link image", "disk");
+	span.setBytes(store->contentSize(image));
+
+	QString dirPath = projectDirectory() + "/" + store->setName(transferSet);
+	if (!QDir().exists(dirPath)) QDir().mkdir(dirPath);
+	if (!ContentStore::checkout(hash, store->contentSize(image), dirPath + "/" + store->fileName(image))) return false;
+
+	imagesLinked()->add();
+	store->setTransfered(image, true);
+	emit imageChanged(transferSet, transferImage);
+	emit imageTransfered(store->setId(transferSet), store->cameraId(image));
+	updateRemaining();
+	return true;
+}
+
+void TransferEngine::requestCurrentImage()
+{
+	while (linkExisting())
+	{
+		iterateTransferIndex();
+		if (lastTransferReached())
+		{
+			finishTransfer();
+			return;
+		}
+	}
+
+	sendImageRequest();
+}
+
+void TransferEngine::sendImageRequest()
+{
+	if (useBatch())
+	{
+		sendBatchRequest();
+		return;
+	}
+
+	QString param = parameterBuilder().addParam("id", QString::number(projectId))
+		->addParam("set", QString::number(store->setId(transferSet)))
+		->addParam("image", QString::number(store->cameraId(currentImage())))
+		->toString();
+
+	markRequested();
+	imageInFlight = true;
+	connector->requestScanner(ScannerCommands::ImageSetImageData, param, this);
+}
+
+//the project details can change the sets while an image is in flight, the reply is matched to what was asked for
+void TransferEngine::markRequested()
+{
+	requestedProject = projectId;
+	requestedSet = store->setId(transferSet);
+	requestedCamera = store->cameraId(currentImage());
+}
+
+//-1 when the image asked for isn't part of the project any more
+int TransferEngine::requestedImage(int& set) const
+{
+	set = requestedProject == projectId ? store->setRow(requestedSet) : -1;
+	return set < 0 ? -1 : store->findImage(set, requestedCamera);
+}
+
+//small images spend more time on the round trip than on the wire, so they're asked for a set at a time
+bool TransferEngine::useBatch() const
+{
+	if (!batching || !batchSupported) return false;
+
+	//the size the scanner reported, otherwise the last image fetched
+	qint64 size = store->contentSize(currentImage());
+	if (size < 0) size = lastImageSize;
+	return size >= 0 && size <= batchImageBytes;
+}
+
+void TransferEngine::sendBatchRequest()
+{
+	int current = currentImage();
+	QStringList cameras = QStringList() << QString::number(store->cameraId(current));
+	qint64 total = store->contentSize(current) >= 0 ? store->contentSize(current) : lastImageSize;
+	int end = store->firstImage(transferSet) + store->imageCount(transferSet);
+
+	//interactive requests wait for the reply being read, under a rate limit a batch holds about a second of it
+	qint64 limit = batchBytes;
+	if (TrafficShaper::rate() > 0) limit = qMin(limit, TrafficShaper::rate());
+
+	//the rest of the set goes with it, apart from images the order leaves till later
+	for (int i = store->firstImage(transferSet); i < end && total < limit; ++i)
+	{
+		if (i == current || store->isTransfered(i) || !scheduler->early(store, i)) continue;
+
+		//images in the content store are linked when the transfer gets to them
+		qint64 size = store->contentSize(i);
+		if (ContentStore::contains(store->contentHash(i), size)) continue;
+
+		cameras.append(QString::number(store->cameraId(i)));
+		total += size >= 0 ? size : lastImageSize;
+	}
+
+	QString param = parameterBuilder().addParam("id", QString::number(projectId))
+		->addParam("set", QString::number(store->setId(transferSet)))
+		->addParam("images", cameras.join(','))
+		->toString();
+
+	markRequested();
+	imageInFlight = true;
+	connector->requestScanner(ScannerCommands::ImageSetImageBatch, param, this);
+}
+
+void TransferEngine::continueTransfer(QByteArray data)
+{
+	imageInFlight = false;
+
+	int set = -1;
+	int image = requestedImage(set);
+	if (image < 0)
+	{
+		if (transfering) resumeTransferRequest();
+		return;
+	}
+
+	if (data.startsWith("Fail"))
+	{
+		QString response = QString(data);
+		emit transferError(response.mid(response.indexOf("?") + 1));
+	}
+	else if (data.isEmpty() || !saveImage(set, image, data.constData(), data.size()))
+	{
+		if (retryImage()) return;
+	}
+	else retries = 0;
+
+	//an image that couldn't be fetched is left until the transfer starts over
+	if (!store->isTransfered(image)) scheduler->skip(image);
+
+	//setup the next request
+	if (transfering) resumeTransferRequest();
+}
+
+void TransferEngine::continueBatch(QByteArray data)
+{
+	imageInFlight = false;
+
+	int set = -1;
+	int requested = requestedImage(set);
+	if (requested < 0)
+	{
+		if (transfering) resumeTransferRequest();
+		return;
+	}
+
+	//an empty reply is retried below like a batch that didn't arrive whole
+	std::vector<ImageFrame> frames = std::vector<ImageFrame>();
+	if (!data.isEmpty() && (data.startsWith("Fail") || !ReplyReader::readImageFrames(data, frames)))
+	{
+		//a scanner from before the command, images are asked for one at a time from now on
+		batchSupported = false;
+		if (transfering) resumeTransferRequest();
+		return;
+	}
+
+	for (size_t i = 0; i < frames.size(); ++i)
+	{
+		int image = store->findImage(set, frames[i].cameraId);
+		if (image < 0 || store->isTransfered(image)) continue;
+
+		saveImage(set, image, data.constData() + frames[i].offset, frames[i].size);
+	}
+
+	//images of the batch that didn't arrive whole are asked for again when the transfer reaches them,
+	//the one asked for first is retried straight away like a single image
+	if (store->isTransfered(requested)) retries = 0;
+	else if (retryImage()) return;
+	else scheduler->skip(requested);
+
+	if (transfering) resumeTransferRequest();
+}
+
+//checked against what the scanner reported before anything is written, false if it didn't match
+bool TransferEngine::saveImage(int set, int image, const char* data, int size)
+{
+	QElapsedTimer clock;
+	clock.start();
+
+	const QByteArray& expected = store->contentHash(image);
+	qint64 expectedSize = store->contentSize(image);
+	QByteArray hash;
+	if (!expected.isEmpty())
+	{
+		TraceSpan span("hash image", "transfer");
+		span.setBytes(size);
+		hash = ContentStore::hash(QByteArray::fromRawData(data, size));
+	}
+
+	if ((expectedSize >= 0 && size != expectedSize) || hash != expected)
+	{
+		verifyFailures()->add();
+		return false;
+	}
+
+	QString dirPath = projectDirectory() + "/" + store->setName(set);
+	if (!QDir().exists(dirPath)) QDir().mkdir(dirPath);
+
+	//an old copy may be a link into the store, writing through it would change the stored content
+	QString savePath = dirPath + "/" + store->fileName(image);
+	QFile::remove(savePath);
+	QFile imageFile(savePath);
+	bool saved = false;
+
+	{
+		TraceSpan span("write image", "disk");
+		span.setBytes(size);
+
+		try {
+			if (imageFile.open(QIODevice::WriteOnly))
+				saved = imageFile.write(data, size) == size;
+			imageFile.close();
+		}
+		catch (std::exception) {}
+		if (imageFile.isOpen()) imageFile.close();
+	}
+
+	timing.writeNs += clock.restart();
+	timing.images++;
+	if (saved)
+	{
+		timing.bytes += size;
+		lastImageSize = size;
+		imagesTransfered()->add();
+		bytesWritten()->add(size);
+		if (!hash.isEmpty()) ContentStore::add(hash, savePath);
+	}
+
+	//the store keeps the transfer state so the set icon doesn't need every file checked again
+	if (store->isTransfered(image) != saved)
+	{
+		store->setTransfered(image, saved);
+		emit imageChanged(set, image - store->firstImage(set));
+	}
+	emit imageTransfered(store->setId(set), store->cameraId(image));
+	updateRemaining();
+	timing.modelNs += clock.nsecsElapsed();
+	return true;
+}
+
+//true when the current image has been asked for again. once the order is starting over it's fetched again from there
+bool TransferEngine::retryImage()
+{
+	if (rewind) return false;
+	if (retries < maxRetries)
+	{
+		retries++;
+		if (transfering) sendImageRequest();
+		return true;
+	}
+
+	retries = 0;
+	emit transferError("Image " + store->fileName(currentImage()) + " of " + store->setName(transferSet) +
+		" didn't match the scanner's copy after " + QString::number(maxRetries + 1) + " attempts");
+	return false;
+}
+
+void TransferEngine::initalTransferSetup()
+{
+	scheduler->reset();
+	iterateTransferIndex();
+}
+
+void TransferEngine::resumeTransferRequest()
+{
+	if (rewind)
+	{
+		rewind = false;
+		initalTransferSetup();
+	}
+	else iterateTransferIndex();
+
+	if (!lastTransferReached())
+	{
+		requestCurrentImage();
+		return;
+	}
+
+	finishTransfer();
+}
+
+void TransferEngine::finishTransfer()
+{
+	emit transferComplete();
+
+	//dont stop transfering if the scanner is still capturing this project, the next refresh picks up new images
+	if (followCapture && currentProject == projectId) resumeRequired = true;
+	else pause();
+}
+
+MetricCounter* TransferEngine::imagesTransfered()
+{
+	static MetricCounter* metric = Metrics::counter("transfer_images_total", "Images written to disk by transfers");
+	return metric;
+}
+
+MetricGauge* TransferEngine::imagesRemaining()
+{
+	static MetricGauge* metric = Metrics::gauge("transfer_images_remaining", "Images of the selected projects not transfered yet");
+	return metric;
+}
+
+void TransferEngine::updateRemaining()
+{
+	int left = store->imageCount() - store->transferedCount();
+	imagesRemaining()->add(left - remaining);
+	remaining = left;
+}
+
+//reads the set directory once rather than checking each image file on its own.
+//once the scanner has reported the sizes a file only counts if it's complete, crashes leave them cut short
+void TransferEngine::loadTransferState(int set) const
+{
+	TraceSpan span("load transfer state", "disk");
+	QDir setDir(projectDirectory() + "/" + store->setName(set));
+	if (!setDir.exists()) return;
+
+	QHash<QString, qint64> existing = QHash<QString, qint64>();
+	QFileInfoList files = setDir.entryInfoList(QDir::Files);
+	for (int i = 0; i < files.size(); ++i)
+		existing.insert(files.at(i).fileName(), files.at(i).size());
+
+	int end = store->firstImage(set) + store->imageCount(set);
+	for (int i = store->firstImage(set); i < end; ++i)
+	{
+		QHash<QString, qint64>::const_iterator file = existing.constFind(store->fileName(i));
+		bool complete = file != existing.constEnd() && (store->contentSize(i) < 0 || file.value() == store->contentSize(i));
+		store->setTransfered(i, complete);
+	}
+}
+
+//replies come back in the order they were asked for, so a set's sizes and hashes arrive before any of its
+//images that are requested after this
+void TransferEngine::requestContent()
+{
+	for (int i = 0; i < store->setCount(); ++i)
+	{
+		int setId = store->setId(i);
+		if (store->hasContent(i) || contentRequested.contains(setId)) continue;
+
+		contentRequested.insert(setId);
+		contentPending.enqueue(projectId);
+		connector->requestScanner(ScannerCommands::ImageSetMetaData, parameterBuilder().addParam("id", QString::number(projectId))
+			->addParam("set", QString::number(setId))->toString(), this);
+	}
+}
+
+void TransferEngine::processContent(QByteArray data)
+{
+	//replies asked for under another project are dropped, the ones for this project are used whenever they were asked for
+	if (contentPending.isEmpty()) return;
+	if (contentPending.dequeue() != projectId) return;
+
+	//older scanners only send the paths, their files are trusted if they exist like before
+	int setId = -1;
+	std::vector<ImageContent> images = std::vector<ImageContent>();
+	if (!ReplyReader::readImageContent(data, setId, images, connector->replyEncoding())) return;
+
+	int set = store->setRow(setId);
+	if (set < 0) return;
+	store->setContent(set, images);
+	modelCharge->resize(store->memoryUsed());
+
+	int first = store->firstImage(set);
+	std::vector<bool> before = std::vector<bool>(store->imageCount(set));
+	for (int i = 0; i < store->imageCount(set); ++i)
+		before[i] = store->isTransfered(first + i);
+
+	loadTransferState(set);
+
+	bool refetch = false;
+	for (int i = 0; i < store->imageCount(set); ++i)
+	{
+		if (before[i] == store->isTransfered(first + i)) continue;
+		if (before[i]) refetch = true;
+		emit imageChanged(set, i);
+	}
+	if (!refetch) return;
+
+	updateRemaining();
+
+	//the image being fetched is written first, the transfer then starts again from the first missing image
+	if (imageInFlight) rewind = true;
+	else
+	{
+		initalTransferSetup();
+		if (transfering && !lastTransferReached())
+		{
+			resumeRequired = false;
+			requestCurrentImage();
+		}
+	}
+}
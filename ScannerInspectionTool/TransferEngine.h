@@ -0,0 +1,146 @@
+#pragma once
+#include <QObject>
+#include <QTimer>
+#include <QSet>
+#include <QQueue>
+#include "IDeviceResponder.h"
+#include "ScannerInteraction.h"
+#include "ProjectStore.h"
+#include "MemoryBudget.h"
+#include "TransferScheduler.h"
+
+//time spent on image replies on the engine's thread
+struct TransferTimings
+{
+	qint64 images = 0;
+	qint64 bytes = 0;
+	qint64 writeNs = 0; //writing the image files
+	qint64 modelNs = 0; //transfer state and the signals the views update from
+};
+
+//pulls the images of one project from a scanner into <root>/<project id>.
+//holds no widgets so it can run for any session, the project transfer panel only controls it
+class TransferEngine : public QObject, public IDeviceResponder
+{
+	Q_OBJECT
+
+public:
+	TransferEngine(ScannerInteraction* connector, QObject* parent = Q_NULLPTR);
+	~TransferEngine();
+
+	ProjectStore* getStore() const { return store; }
+	ScannerInteraction* getConnection() const { return connector; }
+	int project() const { return projectId; }
+	int scannerProject() const { return currentProject; }
+	QString root() const { return transferRoot; }
+	QString projectDirectory() const { return transferRoot + "/" + QString::number(projectId); }
+	bool isTransfering() const { return transfering; }
+	bool isComplete() const { return lastTransferReached(); }
+
+	//starts following a project, returns false if a transfer is running
+	bool setTarget(const QString& root, int project);
+	//keep waiting for new images while the scanner is still capturing the project, otherwise stop once caught up
+	void setFollowCapture(bool follow) { followCapture = follow; }
+	//small images are asked for a set at a time (ImageSetImageBatch) unless turned off, on by default
+	void setBatching(bool batch) { batching = batch; }
+	//the order images are fetched in, can be changed while transfering
+	void setOrder(TransferOrder order);
+	TransferOrder order() const { return transferOrder; }
+	TransferTimings timings() const { return timing; }
+	void resetTimings() { timing = TransferTimings(); }
+
+	//shared by every engine
+	static MetricCounter* imagesTransfered();
+	static MetricGauge* imagesRemaining();
+
+	signals:
+	//the store is about to be replaced or reshuffled, projectChanged follows once it's ready
+	void projectAboutToChange();
+	void projectChanged(QString path, ProjectSnapshotPtr snapshot);
+	void projectUpdated(QString path, ProjectSnapshotPtr snapshot);
+	void setsAppended(int first);
+	void imageChanged(int setRow, int imageRow);
+	void newProjectImageDetected();
+	void imageTransfered(int setId, int imageId);
+	void transferStateChanged(bool transfering);
+	void transferComplete();
+	void transferError(QString message);
+
+	public slots:
+	void start();
+	void pause();
+	void respondToScanner(ScannerCommands, QByteArray) override;
+
+	private slots:
+	void newScannerConnection();
+	void connectionLost();
+	void timerReset();
+
+private:
+	void processProjectDetails(QByteArray);
+	void currentScanner(QByteArray);
+	void processCameraPairs(QByteArray data);
+
+	bool lastTransferReached() const;
+	void iterateTransferIndex();
+	void reorder();
+
+	void loadTransferState(int set) const;
+	void requestContent();
+	void processContent(QByteArray data);
+	int currentImage() const { return store->firstImage(transferSet) + transferImage; }
+	bool linkExisting();
+	void requestCurrentImage();
+	void markRequested();
+	int requestedImage(int& set) const;
+	void sendImageRequest();
+	bool useBatch() const;
+	void sendBatchRequest();
+	void continueTransfer(QByteArray data);
+	void continueBatch(QByteArray data);
+	bool saveImage(int set, int image, const char* data, int size);
+	bool retryImage();
+	void initalTransferSetup();
+	void resumeTransferRequest();
+	void finishTransfer();
+	void updateRemaining();
+
+	int projectId = -1;
+	QString transferRoot;
+	QByteArray lastDetails;
+	ProjectStore* store = new ProjectStore();
+
+	bool transfering = false;
+	bool resumeRequired = false;
+	bool initialLoad = true;
+	bool followCapture = true;
+	int transferSet = 0;
+	int transferImage = 0;
+	int currentProject = -1;
+	int requestedProject = -1; //what the image in flight was asked for as
+	int requestedSet = -1; //set id
+	int requestedCamera = -1;
+	bool imageInFlight = false;
+	bool rewind = false; //an image before the current one needs fetching again
+	int retries = 0; //of the current image after it didn't match the scanner's hash
+	static const int maxRetries = 3;
+
+	TransferOrder transferOrder = TransferOrder::Sequential;
+	TransferScheduler* scheduler = TransferScheduler::create(TransferOrder::Sequential);
+	std::vector<CameraPair> pairs = std::vector<CameraPair>();
+
+	bool batching = true;
+	bool batchSupported = true; //cleared when the scanner doesn't know the batch command
+	qint64 lastImageSize = -1;
+	static const qint64 batchImageBytes = 512 * 1024; //images up to this size are batched
+	static const qint64 batchBytes = 16 * 1024 * 1024; //images in one batch reply
+
+	QSet<int> contentRequested; //set ids
+	QQueue<int> contentPending; //the project each reply still to come was asked for under, in order
+	QTimer* timer;
+	TransferTimings timing;
+	int remaining = 0; //this engine's part of the transfer_images_remaining gauge
+	MemoryCharge* modelCharge = new MemoryCharge(MemoryCategory::Model);
+
+	ScannerInteraction* connector;
+};
@@ -0,0 +1,376 @@
+#include "TransferScheduler.h"
+#include <QSettings>
+
+namespace
+{
+	//the order the scanner lists sets and images in, what transfers always did
+	class SequentialSchedule : public TransferScheduler
+	{
+	public:
+		bool next(const ProjectStore* store, int& set, int& image) override
+		{
+			for (; row < store->setCount(); ++row)
+			{
+				image = complete(store, row) ? -1 : firstWanted(store, row);
+				if (image < 0) continue;
+
+				set = row;
+				return true;
+			}
+			return false;
+		}
+
+		void reset() override
+		{
+			TransferScheduler::reset();
+			row = 0;
+		}
+
+	private:
+		int row = 0;
+	};
+
+	//works back from the latest set, jumping to the end again whenever the scanner captures more
+	class NewestFirstSchedule : public TransferScheduler
+	{
+	public:
+		bool next(const ProjectStore* store, int& set, int& image) override
+		{
+			if (store->setCount() > seen) row = store->setCount() - 1;
+			seen = store->setCount();
+
+			for (; row >= 0; --row)
+			{
+				image = complete(store, row) ? -1 : firstWanted(store, row);
+				if (image < 0) continue;
+
+				set = row;
+				return true;
+			}
+			return false;
+		}
+
+		void reset() override
+		{
+			TransferScheduler::reset();
+			row = -1;
+			seen = 0;
+		}
+
+	private:
+		int row = -1;
+		int seen = 0;
+	};
+
+	//the images of every pair in set order first, then the cameras that aren't in a pair. sets that arrive once
+	//the pairs are done have their pairs fetched before the transfer goes back to the leftovers
+	class PairCompletingSchedule : public TransferScheduler
+	{
+	public:
+		bool next(const ProjectStore* store, int& set, int& image) override
+		{
+			if (store->setCount() > seen && pass > 0)
+			{
+				pass = 0;
+				row = seen;
+			}
+			seen = store->setCount();
+
+			for (; pass < 2; ++pass, row = 0)
+			{
+				for (; row < store->setCount(); ++row)
+				{
+					if (complete(store, row)) continue;
+					image = pass == 0 ? firstPairWanted(store, row) : firstWanted(store, row);
+					if (image < 0) continue;
+
+					set = row;
+					return true;
+				}
+			}
+			return false;
+		}
+
+		bool early(const ProjectStore* store, int image) const override
+		{
+			return pass > 0 || inPair(store->cameraId(image));
+		}
+
+		void reset() override
+		{
+			TransferScheduler::reset();
+			row = 0;
+			pass = 0;
+			seen = 0;
+		}
+
+	private:
+		int row = 0;
+		int pass = 0; //0 pairs, 1 everything else
+		int seen = 0;
+	};
+
+	//sets captured while the transfer runs come first and whole, the operator is waiting on them in the calibration
+	//window. neighbouring sets hold almost the same board pose, so the rest are taken from across the whole session
+	//before the gaps between them are filled in, and pairs short of the views a calibration needs go before the
+	//pairs that have enough. a pair counts as a view once both images are here and validation hasn't ruled it out
+	class CoverageSchedule : public TransferScheduler
+	{
+	public:
+		bool next(const ProjectStore* store, int& set, int& image) override
+		{
+			if (seen < 0) arrange(store);
+			for (; seen < store->setCount(); ++seen)
+				fresh.push_back(seen);
+			counted.resize(store->setCount() * pairs.size(), 0);
+
+			while (!fresh.empty())
+			{
+				int row = fresh.back();
+				image = -1;
+				if (!complete(store, row))
+				{
+					image = firstPairWanted(store, row);
+					if (image < 0) image = firstWanted(store, row);
+				}
+
+				if (image >= 0)
+				{
+					set = row;
+					currentFresh = true;
+					return true;
+				}
+
+				count(store, row);
+				fresh.pop_back();
+			}
+
+			std::vector<bool> needed = std::vector<bool>(pairs.size());
+			for (size_t i = 0; i < pairs.size(); ++i)
+				needed[i] = views[i] < enoughViews;
+
+			for (; pass < 3; ++pass, position = 0)
+			{
+				for (; position < int(order.size()); ++position)
+				{
+					int row = order[position];
+					if (!complete(store, row))
+					{
+						if (pass == 0) image = firstPairWanted(store, row, needed);
+						else if (pass == 1) image = firstPairWanted(store, row);
+						else image = firstWanted(store, row);
+
+						if (image >= 0)
+						{
+							set = row;
+							currentFresh = false;
+							return true;
+						}
+					}
+
+					count(store, row);
+				}
+			}
+			return false;
+		}
+
+		bool early(const ProjectStore* store, int image) const override
+		{
+			if (currentFresh || pass > 1) return true;
+
+			int camera = store->cameraId(image);
+			for (size_t i = 0; i < pairs.size(); ++i)
+			{
+				if (pairs[i].leftId != camera && pairs[i].rightId != camera) continue;
+				if (pass == 1 || views[i] < enoughViews) return true;
+			}
+			return false;
+		}
+
+		void reset() override
+		{
+			TransferScheduler::reset();
+			seen = -1;
+		}
+
+	private:
+		void arrange(const ProjectStore* store)
+		{
+			int sets = store->setCount();
+			int bits = 0;
+			while ((1 << bits) < sets) bits++;
+
+			//bit reversed indices halve the gaps between the sets already taken
+			order.clear();
+			for (int i = 0; i < (1 << bits); ++i)
+			{
+				int row = 0;
+				for (int b = 0; b < bits; ++b)
+					if (i & (1 << b)) row |= 1 << (bits - 1 - b);
+				if (row < sets) order.push_back(row);
+			}
+
+			fresh.clear();
+			views.assign(pairs.size(), 0);
+			counted.assign(sets * pairs.size(), 0);
+			for (int i = 0; i < sets; ++i)
+				count(store, i);
+
+			position = 0;
+			pass = 0;
+			seen = sets;
+		}
+
+		void count(const ProjectStore* store, int set)
+		{
+			for (size_t i = 0; i < pairs.size(); ++i)
+			{
+				quint8& done = counted[set * pairs.size() + i];
+				if (done || !usable(store, set, int(i))) continue;
+
+				done = 1;
+				views[i]++;
+			}
+		}
+
+		bool usable(const ProjectStore* store, int set, int pair) const
+		{
+			int left = store->findImage(set, pairs[pair].leftId);
+			int right = store->findImage(set, pairs[pair].rightId);
+			if (left < 0 || right < 0 || !store->isTransfered(left) || !store->isTransfered(right)) return false;
+
+			//the calibration window's results, when they're for the same pairs
+			if (store->pairCount() != int(pairs.size())) return true;
+			CalibrationValidity state = store->pairValidity(set, pair);
+			return state != Invalid && state != Missing;
+		}
+
+		static const int enoughViews = 15;
+
+		std::vector<int> order; //set rows
+		std::vector<int> fresh; //set rows captured since the order was arranged, newest at the back
+		std::vector<int> views; //per pair
+		std::vector<quint8> counted; //per set and pair
+		int position = 0;
+		int pass = 0; //0 pairs short of views, 1 every pair, 2 everything else
+		int seen = -1; //sets already placed, -1 until the order is arranged
+		bool currentFresh = false;
+	};
+}
+
+
+TransferScheduler* TransferScheduler::create(TransferOrder order)
+{
+	switch (order)
+	{
+	case TransferOrder::NewestFirst:
+		return new NewestFirstSchedule();
+	case TransferOrder::PairCompleting:
+		return new PairCompletingSchedule();
+	case TransferOrder::CalibrationCoverage:
+		return new CoverageSchedule();
+	default:
+		return new SequentialSchedule();
+	}
+}
+
+QString TransferScheduler::name(TransferOrder order)
+{
+	switch (order)
+	{
+	case TransferOrder::NewestFirst:
+		return "newest";
+	case TransferOrder::PairCompleting:
+		return "pairs";
+	case TransferOrder::CalibrationCoverage:
+		return "coverage";
+	default:
+		return "sequential";
+	}
+}
+
+QString TransferScheduler::title(TransferOrder order)
+{
+	switch (order)
+	{
+	case TransferOrder::NewestFirst:
+		return "Newest First";
+	case TransferOrder::PairCompleting:
+		return "Complete Pairs First";
+	case TransferOrder::CalibrationCoverage:
+		return "Calibration Coverage";
+	default:
+		return "Sequential";
+	}
+}
+
+bool TransferScheduler::fromName(const QString& name, TransferOrder& order)
+{
+	for (int i = 0; i <= int(TransferOrder::CalibrationCoverage); ++i)
+	{
+		if (name.compare(TransferScheduler::name(TransferOrder(i)), Qt::CaseInsensitive) != 0) continue;
+
+		order = TransferOrder(i);
+		return true;
+	}
+	return false;
+}
+
+TransferOrder TransferScheduler::savedOrder()
+{
+	QSettings settings("MultiCapture", "ScannerInspectionTool");
+	TransferOrder order = TransferOrder::Sequential;
+	fromName(settings.value("transfer/order").toString(), order);
+	return order;
+}
+
+void TransferScheduler::saveOrder(TransferOrder order)
+{
+	QSettings settings("MultiCapture", "ScannerInspectionTool");
+	settings.setValue("transfer/order", name(order));
+}
+
+void TransferScheduler::setPairs(const std::vector<CameraPair>& cameraPairs)
+{
+	pairs = cameraPairs;
+	pairCameras.clear();
+	for (size_t i = 0; i < pairs.size(); ++i)
+	{
+		pairCameras.insert(pairs[i].leftId);
+		pairCameras.insert(pairs[i].rightId);
+	}
+
+	reset();
+}
+
+int TransferScheduler::firstWanted(const ProjectStore* store, int set) const
+{
+	int end = store->firstImage(set) + store->imageCount(set);
+	for (int i = store->firstImage(set); i < end; ++i)
+		if (wanted(store, i)) return i;
+
+	return -1;
+}
+
+int TransferScheduler::firstPairWanted(const ProjectStore* store, int set, const std::vector<bool>& needed) const
+{
+	for (int half = 0; half < 2; ++half)
+	{
+		for (size_t i = 0; i < pairs.size(); ++i)
+		{
+			if (!needed.empty() && !needed[i]) continue;
+
+			int left = store->findImage(set, pairs[i].leftId);
+			int right = store->findImage(set, pairs[i].rightId);
+			bool leftWanted = wanted(store, left);
+			bool rightWanted = wanted(store, right);
+
+			//first time round only the pairs with one image here already
+			if (half == 0 && leftWanted == rightWanted) continue;
+			if (leftWanted) return left;
+			if (rightWanted) return right;
+		}
+	}
+
+	return -1;
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <QString>
+#include <QSet>
+#include <vector>
+#include "ProjectStore.h"
+#include "JsonTypes.h"
+
+//the orders a transfer can fetch images in
+enum class TransferOrder
+{
+	Sequential, //sets and images as the scanner lists them
+	NewestFirst, //the latest sets first, sets captured during the transfer go ahead of the rest
+	PairCompleting, //both images of every stereo pair before the cameras that aren't in one
+	CalibrationCoverage //new sets whole, then pairs short of views from sets spread over the session
+};
+
+//decides which image a transfer fetches next. it's asked again after every image, so sets that arrive while the
+//transfer runs are fitted in straight away without the order being worked out for the whole project
+class TransferScheduler
+{
+public:
+	virtual ~TransferScheduler() {}
+
+	static TransferScheduler* create(TransferOrder order);
+	//short names for the command line and settings, titles for menus
+	static QString name(TransferOrder order);
+	static QString title(TransferOrder order);
+	//false if the name isn't one of the orders
+	static bool fromName(const QString& name, TransferOrder& order);
+	//the order picked in the inspection tool, sequential unless set
+	static TransferOrder savedOrder();
+	static void saveOrder(TransferOrder order);
+
+	//the next image to fetch as a set row and image index, false once there's nothing left
+	virtual bool next(const ProjectStore* store, int& set, int& image) = 0;
+	//whether an image of the set next gave can be fetched along with it, false for the ones the order leaves till later
+	virtual bool early(const ProjectStore* store, int image) const { return true; }
+	//the order starts again, images may have gone missing anywhere
+	virtual void reset() { skipped.clear(); }
+	//an image that couldn't be fetched isn't given again until the next reset
+	void skip(int image) { skipped.insert(image); }
+	//the scanner's CameraPairs, the order starts again with them
+	void setPairs(const std::vector<CameraPair>& cameraPairs);
+
+protected:
+	bool wanted(const ProjectStore* store, int image) const { return image >= 0 && !store->isTransfered(image) && !skipped.contains(image); }
+	bool complete(const ProjectStore* store, int set) const { return store->transferedCount(set) == store->imageCount(set); }
+	bool inPair(int cameraId) const { return pairCameras.contains(cameraId); }
+	//-1 when the set has nothing left to fetch
+	int firstWanted(const ProjectStore* store, int set) const;
+	//only the images of pairs, or of the pairs marked in needed. pairs that are half here are finished first
+	int firstPairWanted(const ProjectStore* store, int set, const std::vector<bool>& needed = std::vector<bool>()) const;
+
+	std::vector<CameraPair> pairs;
+	QSet<int> pairCameras;
+	QSet<int> skipped; //images
+};
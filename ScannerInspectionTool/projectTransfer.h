@@ -2,10 +2,9 @@
 #include <QPushButton>
 #include "ScannerInteraction.h"
 #include <qdir.h>
-#include <QStandardItemModel.h>
-#include "Lib/json.hpp"
 #include <QErrorMessage>
-#include "JsonTypes.h"
+#include "TransferEngine.h"
+#include "ProjectTreeModel.h"
 
 QT_BEGIN_NAMESPACE
 class QTreeView;
@@ -13,75 +12,41 @@ class QPushButton;
 class QLineEdit;
 QT_END_NAMESPACE
 
-class projectTransfer : public QObject, public IDeviceResponder
+//the project transfer panel, controls the transfer engine of the selected scanner session
+class projectTransfer : public QObject
 {
 	Q_OBJECT
 
 public:
-	projectTransfer(QLineEdit*, QPushButton*, QTreeView*, ScannerInteraction*);
+	projectTransfer(QLineEdit*, QPushButton*, QTreeView*);
 	~projectTransfer();
 
+	void setEngine(TransferEngine* transferEngine);
+	TransferEngine* getEngine() const { return engine; }
 
 	signals:
-	void projectChanged(QString path);
-	void projectUpdated(QString path);
-	void triggerImagePreview(QString);
-	void newProjectImageDetected();
-	void imageTransfered(int setId, int imageId);
+	void triggerImagePreview(QString, QByteArray);
 
 	public slots:
 	void changeTargetProject(int);
-	void respondToScanner(ScannerCommands, QByteArray) override;
 
 	private slots:
 	void changeTransferAction();
-	void newScannerConnection();
-	void timerReset();
 	void changeImagePreview(const QModelIndex&);
+	void transferStateChanged(bool transfering);
+	void projectChanged();
 
 private:
-	void processProjectDetails(QByteArray);
-	void setupModelHeadings() const;
-	void currentScanner(QByteArray);
-
-	bool lastTransferReached() const;
-	void iterateTransferIndex();
-
-	//project detail management
-	void updateProjectTree(nlohmann::json) const;
-	void resetProjectTree(nlohmann::json) const;
-	void generateImageSetModel(int row) const;
-	bool imageSetExists(int setId) const;
-
-	//transfer methods
-	static bool fileExists(QString path);
-	void populateIcons() const;
-	void continueTransfer(QByteArray data);
-	void initalTransferSetup();
-	void resumeTransferRequest();
-
-	int projectId = -1;
 	QDir* transferRoot;
-	QStandardItemModel* model;
-	QList<Set*>* setData = new QList<Set*>();
+	ProjectTreeModel* model;
 	QErrorMessage* projectError;
+	TransferEngine* engine = nullptr;
+	QList<QMetaObject::Connection> engineConnections;
 
-	bool transfering = false;
-	bool resumeRequired = false;
-	bool initialLoad = true;
-	int transferSet = 0;
-	int transferImage = 0;
-	int currentProject = -1;
-	QTimer* timer;
-
-	const QIcon ImageTransfered = QIcon(":/ScannerInspectionTool/transferComplete");
-	const QIcon ImageNotTransfered = QIcon(":/ScannerInspectionTool/transferNeeded");
 	const QIcon Play = QIcon(":/ScannerInspectionTool/play");
 	const QIcon Pause = QIcon(":/ScannerInspectionTool/pause");
 	
 	QLineEdit* path;
 	QPushButton* statusControl;
 	QTreeView* projectView;
-	ScannerInteraction* connector;
 };
-
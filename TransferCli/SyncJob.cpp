@@ -0,0 +1,265 @@
+#include "SyncJob.h"
+#include <qdir.h>
+#include <vector>
+#include "Project.h"
+#include "ReplyReader.h"
+
+
+SyncJob::SyncJob(ScannerSession* session, const QString& root, const QList<int>& projects, int timeout, QObject* parent) : QObject(parent)
+{
+	this->session = session;
+	this->root = root + "/" + session->name();
+	engine = session->getEngine();
+	wanted = projects;
+
+	inactivityTimer = new QTimer(this);
+	inactivityTimer->setSingleShot(true);
+	inactivityTimer->setInterval(timeout);
+
+	connect(inactivityTimer, &QTimer::timeout, this, &SyncJob::inactive);
+	connect(session, &ScannerSession::stateChanged, this, &SyncJob::sessionStateChanged);
+	connect(engine, &TransferEngine::projectChanged, this, &SyncJob::projectReady);
+	connect(engine, &TransferEngine::imageTransfered, this, &SyncJob::imageTransfered);
+	connect(engine, &TransferEngine::transferError, this, &SyncJob::transferError);
+	connect(engine, &TransferEngine::transferComplete, this, &SyncJob::projectComplete);
+}
+
+SyncJob::~SyncJob()
+{
+	delete inactivityTimer;
+}
+
+QJsonObject SyncJob::results() const
+{
+	QJsonObject scanner = QJsonObject();
+	scanner["name"] = session ? session->name() : root.mid(root.lastIndexOf("/") + 1);
+	scanner["status"] = status;
+
+	QJsonArray list = QJsonArray();
+	int images = 0, errors = 0;
+	qint64 bytes = 0;
+	for (int i = 0; i < projects.size(); ++i)
+	{
+		const ProjectResult& result = projects.at(i);
+		QJsonObject item = QJsonObject();
+		item["id"] = result.id;
+		item["name"] = result.name;
+		item["status"] = result.status;
+		item["images"] = result.images;
+		item["errors"] = result.errors;
+		item["bytes"] = result.bytes;
+		item["ms"] = result.ms;
+		list.append(item);
+
+		images += result.images;
+		errors += result.errors;
+		bytes += result.bytes;
+	}
+
+	scanner["projects"] = list;
+	scanner["images"] = images;
+	scanner["errors"] = errors;
+	scanner["bytes"] = bytes;
+	scanner["ms"] = jobClock.isValid() ? jobClock.elapsed() : 0;
+	return scanner;
+}
+
+void SyncJob::start()
+{
+	jobClock.start();
+	if (!QDir().mkpath(root))
+	{
+		finish("unwritable");
+		return;
+	}
+
+	//the session connects by itself once it is created, waiting for it counts as inactivity
+	inactivityTimer->start();
+	if (session->isConnected()) sessionStateChanged(session);
+}
+
+void SyncJob::sessionLost()
+{
+	if (state != Finished)
+	{
+		if (current >= 0) endProject("lost");
+		finish("lost");
+	}
+
+	session = nullptr;
+}
+
+void SyncJob::respondToScanner(ScannerCommands command, QByteArray data)
+{
+	if (command == ScannerCommands::getLoadedProjects) processProjects(data);
+}
+
+void SyncJob::sessionStateChanged(ScannerSession*)
+{
+	if (state == Connecting && session->isConnected())
+	{
+		state = Listing;
+		inactivityTimer->start();
+		session->getConnection()->requestScanner(ScannerCommands::getLoadedProjects, "", this);
+	}
+	else if (state != Finished && !session->isConnected())
+	{
+		if (current >= 0) endProject("disconnected");
+		finish("disconnected");
+	}
+}
+
+void SyncJob::processProjects(QByteArray data)
+{
+	if (state != Listing) return;
+
+	std::vector<project> loaded = std::vector<project>();
+	if (data.startsWith("Fail") ||
+		!ReplyReader::readProjects(data, loaded, session->getConnection()->replyEncoding()))
+	{
+		finish("failed");
+		return;
+	}
+
+	for (int i = 0; i < loaded.size(); ++i)
+	{
+		if (!wanted.isEmpty() && !wanted.contains(loaded[i].id)) continue;
+
+		ProjectResult result = ProjectResult();
+		result.id = loaded[i].id;
+		result.name = QString::fromStdString(loaded[i].name);
+		result.status = "pending";
+		projects.append(result);
+	}
+
+	//projects that were asked for but aren't on the scanner are still reported
+	for (int i = 0; i < wanted.size(); ++i)
+	{
+		bool found = false;
+		for (int j = 0; j < projects.size() && !found; ++j)
+			found = projects.at(j).id == wanted.at(i);
+		if (found) continue;
+
+		ProjectResult missing = ProjectResult();
+		missing.id = wanted.at(i);
+		missing.status = "missing";
+		projects.append(missing);
+	}
+
+	state = Pulling;
+	nextProject();
+}
+
+void SyncJob::nextProject()
+{
+	do {
+		current++;
+	} while (current < projects.size() && projects.at(current).status != "pending");
+
+	if (current >= projects.size())
+	{
+		current = -1;
+
+		bool complete = true;
+		for (int i = 0; i < projects.size(); ++i)
+			complete &= projects.at(i).status == "complete";
+		succeeded = complete;
+		finish(complete ? "complete" : "incomplete");
+		return;
+	}
+
+	started = false;
+	startBytes = imageBytes();
+	projectClock.start();
+	inactivityTimer->start();
+
+	//stop at the last image the scanner had when the details were read, even if it is still capturing
+	engine->setFollowCapture(false);
+	engine->setTarget(root, projects.at(current).id);
+}
+
+void SyncJob::endProject(const QString& status)
+{
+	if (current < 0 || current >= projects.size()) return;
+
+	ProjectResult& result = projects[current];
+	result.status = status;
+	result.bytes = imageBytes() - startBytes;
+	result.ms = projectClock.elapsed();
+
+	inactivityTimer->stop();
+	engine->pause();
+}
+
+void SyncJob::finish(const QString& status)
+{
+	if (state == Finished) return;
+
+	state = Finished;
+	this->status = status;
+	inactivityTimer->stop();
+
+	disconnect(engine, nullptr, this, nullptr);
+	engine->setFollowCapture(true);
+
+	emit finished(this);
+}
+
+qint64 SyncJob::imageBytes() const
+{
+	if (!session) return startBytes;
+
+	//small images come a set at a time in batches
+	QMap<int, CommandStatistics> stats = session->getConnection()->statistics();
+	return stats.value(static_cast<int>(ScannerCommands::ImageSetImageData)).wireBytes +
+		stats.value(static_cast<int>(ScannerCommands::ImageSetImageBatch)).wireBytes;
+}
+
+void SyncJob::projectReady()
+{
+	if (state != Pulling || started) return;
+
+	started = true;
+	inactivityTimer->start();
+	engine->start();
+}
+
+void SyncJob::imageTransfered()
+{
+	if (state != Pulling) return;
+
+	projects[current].images++;
+	inactivityTimer->start();
+}
+
+void SyncJob::transferError(QString)
+{
+	if (state != Pulling) return;
+
+	projects[current].errors++;
+
+	//without the project details there is nothing to pull
+	if (!started)
+	{
+		endProject("failed");
+		nextProject();
+	}
+}
+
+void SyncJob::projectComplete()
+{
+	if (state != Pulling || !started) return;
+
+	endProject(projects.at(current).errors > 0 ? "failed" : "complete");
+	nextProject();
+}
+
+void SyncJob::inactive()
+{
+	if (state == Pulling)
+	{
+		endProject("timeout");
+		nextProject();
+	}
+	else finish(state == Connecting ? "unreachable" : "timeout");
+}
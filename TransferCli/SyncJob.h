@@ -0,0 +1,84 @@
+#pragma once
+#include <QObject>
+#include <QTimer>
+#include <QList>
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QJsonArray>
+#include "IDeviceResponder.h"
+#include "ScannerSession.h"
+
+//pulls every wanted project from one scanner into <root>/<scanner name>/<project id>, one project at a time.
+//the session keeps its own connection thread so jobs for different scanners run side by side
+class SyncJob : public QObject, public IDeviceResponder
+{
+	Q_OBJECT
+
+public:
+	SyncJob(ScannerSession* session, const QString& root, const QList<int>& projects, int timeout, QObject* parent = Q_NULLPTR);
+	~SyncJob();
+
+	ScannerSession* getSession() const { return session; }
+	bool isFinished() const { return state == Finished; }
+	bool isSuccessful() const { return succeeded; }
+	QJsonObject results() const;
+
+	signals:
+	void finished(SyncJob*);
+
+	public slots:
+	void start();
+	//the session is about to be removed, nothing may use it after this
+	void sessionLost();
+	void respondToScanner(ScannerCommands, QByteArray) override;
+
+	private slots:
+	void sessionStateChanged(ScannerSession*);
+	void projectReady();
+	void imageTransfered();
+	void transferError(QString message);
+	void projectComplete();
+	void inactive();
+
+private:
+	enum JobState
+	{
+		Connecting,
+		Listing,
+		Pulling,
+		Finished
+	};
+
+	struct ProjectResult
+	{
+		int id;
+		QString name;
+		QString status;
+		int images = 0;
+		int errors = 0;
+		qint64 bytes = 0;
+		qint64 ms = 0;
+	};
+
+	void processProjects(QByteArray data);
+	void nextProject();
+	void endProject(const QString& status);
+	void finish(const QString& status);
+	qint64 imageBytes() const;
+
+	ScannerSession* session;
+	TransferEngine* engine;
+	QString root;
+	QList<int> wanted;
+	QList<ProjectResult> projects;
+	QTimer* inactivityTimer;
+	QElapsedTimer projectClock;
+	QElapsedTimer jobClock;
+
+	JobState state = Connecting;
+	QString status = "pending";
+	bool succeeded = false;
+	bool started = false;
+	int current = -1;
+	qint64 startBytes = 0;
+};
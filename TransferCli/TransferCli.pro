@@ -0,0 +1,18 @@
+TEMPLATE = app
+CONFIG += console c++11
+CONFIG -= app_bundle
+QT = core network
+TARGET = TransferCli
+
+INCLUDEPATH += ../ScannerInspectionTool
+LIBS += -L$$OUT_PWD/../ScannerCore -lScannerCore
+PRE_TARGETDEPS += $$OUT_PWD/../ScannerCore/libScannerCore.a
+
+HEADERS += \
+	SyncJob.h \
+	TransferDaemon.h
+
+SOURCES += \
+	main.cpp \
+	SyncJob.cpp \
+	TransferDaemon.cpp
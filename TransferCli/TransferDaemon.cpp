@@ -0,0 +1,160 @@
+#include "TransferDaemon.h"
+#include <QCoreApplication>
+#include <QThread>
+#include <QTimer>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <cstdio>
+#include "DiscoveryService.h"
+#include "ScannerSessionManager.h"
+#include "SyncJob.h"
+
+
+TransferDaemon::TransferDaemon(const DaemonOptions& options, QObject* parent) : QObject(parent)
+{
+	this->options = options;
+
+	sessions = new ScannerSessionManager(this);
+	connect(sessions, &ScannerSessionManager::sessionAdded, this, &TransferDaemon::sessionAdded);
+	connect(sessions, &ScannerSessionManager::sessionRemoved, this, &TransferDaemon::sessionRemoved);
+
+	discoveryTimer = new QTimer(this);
+	discoveryTimer->setSingleShot(true);
+	connect(discoveryTimer, &QTimer::timeout, this, &TransferDaemon::discoveryFinished);
+
+	//same layout as the gui, discovery on its own thread feeding the session manager
+	discoveryThread = new QThread(this);
+	discovery = new DiscoveryService();
+	discoveryThread->setObjectName("Discovery Thread");
+	discovery->moveToThread(discoveryThread);
+
+	connect(discoveryThread, &QThread::started, discovery, &DiscoveryService::start);
+	connect(discoveryThread, &QThread::finished, discovery, &QObject::deleteLater);
+	connect(discovery, &DiscoveryService::deviceFound, sessions, &ScannerSessionManager::addDevice);
+	connect(discovery, &DiscoveryService::deviceRenamed, sessions, &ScannerSessionManager::renameDevice);
+	connect(discovery, &DiscoveryService::deviceLost, sessions, &ScannerSessionManager::removeDevice);
+}
+
+TransferDaemon::~TransferDaemon()
+{
+	for (int i = 0; i < jobs.size(); ++i)
+		delete jobs.at(i);
+	delete sessions;
+
+	discoveryThread->quit();
+	discoveryThread->wait();
+	delete discoveryThread;
+}
+
+void TransferDaemon::start()
+{
+	clock.start();
+	discoveryThread->start();
+	discoveryTimer->start(options.discoveryTime);
+}
+
+void TransferDaemon::sessionAdded(int index)
+{
+	if (!discovering) return;
+
+	ScannerSession* session = sessions->session(index);
+	if (!isWanted(session)) return;
+
+	session->getEngine()->setOrder(options.order);
+	SyncJob* job = new SyncJob(session, options.root, options.projects, options.inactivityTimeout);
+	connect(job, &SyncJob::finished, this, &TransferDaemon::jobFinished);
+	jobs.append(job);
+	job->start();
+
+	//every named scanner has been found, no need to wait out the discovery time
+	if (!options.scanners.isEmpty() && jobs.size() >= options.scanners.size()) discoveryFinished();
+}
+
+void TransferDaemon::sessionRemoved(int, ScannerSession* session)
+{
+	for (int i = 0; i < jobs.size(); ++i)
+		if (jobs.at(i)->getSession() == session) jobs.at(i)->sessionLost();
+}
+
+void TransferDaemon::discoveryFinished()
+{
+	if (!discovering) return;
+
+	discovering = false;
+	discoveryTimer->stop();
+
+	if (jobs.isEmpty())
+	{
+		fprintf(stderr, "No scanners found\n");
+		report(2);
+		return;
+	}
+
+	finishIfDone();
+}
+
+void TransferDaemon::jobFinished(SyncJob*)
+{
+	finishIfDone();
+}
+
+bool TransferDaemon::isWanted(ScannerSession* session) const
+{
+	if (options.scanners.isEmpty()) return true;
+
+	QString id = DiscoveryService::deviceId(session->address());
+	for (int i = 0; i < options.scanners.size(); ++i)
+	{
+		const QString& scanner = options.scanners.at(i);
+		if (scanner == session->name() || scanner == id || scanner == session->address().toString()) return true;
+	}
+
+	return false;
+}
+
+void TransferDaemon::finishIfDone()
+{
+	if (discovering || reported) return;
+
+	bool success = true;
+	for (int i = 0; i < jobs.size(); ++i)
+	{
+		if (!jobs.at(i)->isFinished()) return;
+		success &= jobs.at(i)->isSuccessful();
+	}
+
+	report(success ? 0 : 1);
+}
+
+void TransferDaemon::report(int exitCode)
+{
+	reported = true;
+
+	QJsonArray scanners = QJsonArray();
+	int images = 0, errors = 0;
+	qint64 bytes = 0;
+	for (int i = 0; i < jobs.size(); ++i)
+	{
+		QJsonObject result = jobs.at(i)->results();
+		images += result["images"].toInt();
+		errors += result["errors"].toInt();
+		bytes += static_cast<qint64>(result["bytes"].toDouble());
+		scanners.append(result);
+	}
+
+	QJsonObject stats = QJsonObject();
+	stats["root"] = options.root;
+	stats["scanners"] = scanners;
+	stats["images"] = images;
+	stats["errors"] = errors;
+	stats["bytes"] = bytes;
+	stats["ms"] = clock.elapsed();
+	stats["exitCode"] = exitCode;
+
+	QByteArray json = QJsonDocument(stats).toJson(QJsonDocument::Indented);
+	fwrite(json.constData(), 1, json.size(), stdout);
+	fflush(stdout);
+
+	QCoreApplication::exit(exitCode);
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <QObject>
+#include <QStringList>
+#include <QList>
+#include <QElapsedTimer>
+#include "TransferScheduler.h"
+
+class ScannerSession;
+class ScannerSessionManager;
+class DiscoveryService;
+class SyncJob;
+QT_BEGIN_NAMESPACE
+class QThread;
+class QTimer;
+QT_END_NAMESPACE
+
+struct DaemonOptions
+{
+	QString root;
+	QStringList scanners; //names or addresses, empty for every scanner found
+	QList<int> projects; //empty for every project on the scanner
+	int discoveryTime = 5000; //5sec
+	int inactivityTimeout = 120000; //2min
+	TransferOrder order = TransferOrder::Sequential;
+};
+
+//finds scanners for a while, starts a sync job for each one that was asked for and writes
+//the results as json to stdout once every job has finished
+class TransferDaemon : public QObject
+{
+	Q_OBJECT
+
+public:
+	TransferDaemon(const DaemonOptions& options, QObject* parent = Q_NULLPTR);
+	~TransferDaemon();
+
+	public slots:
+	void start();
+
+	private slots:
+	void sessionAdded(int index);
+	void sessionRemoved(int index, ScannerSession* session);
+	void discoveryFinished();
+	void jobFinished(SyncJob* job);
+
+private:
+	bool isWanted(ScannerSession* session) const;
+	void finishIfDone();
+	void report(int exitCode);
+
+	DaemonOptions options;
+	ScannerSessionManager* sessions;
+	DiscoveryService* discovery;
+	QThread* discoveryThread;
+	QTimer* discoveryTimer;
+	QList<SyncJob*> jobs;
+	QElapsedTimer clock;
+
+	bool discovering = true;
+	bool reported = false;
+};
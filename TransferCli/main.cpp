@@ -0,0 +1,94 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QTimer>
+#include <qdir.h>
+#include <cstdio>
+#include "TransferDaemon.h"
+#include "Trace.h"
+#include "MetricsServer.h"
+#include "MemoryBudget.h"
+#include "ContentStore.h"
+#include "TrafficShaper.h"
+
+//pulls projects from the scanners on the network without the gui, for unattended runs.
+//exit code 0 when every project was pulled, 1 when some were not, 2 when no scanner was found
+int main(int argc, char *argv[])
+{
+	QCoreApplication a(argc, argv);
+	QCoreApplication::setApplicationName("TransferCli");
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Pulls projects from the scanners and prints the results as json");
+	parser.addHelpOption();
+	parser.addOption(QCommandLineOption("root", "Directory the projects are written to, one folder per scanner.", "dir"));
+	parser.addOption(QCommandLineOption("scanner", "Scanner name or address to pull from, can be repeated. Every scanner found by default.", "scanner"));
+	parser.addOption(QCommandLineOption("project", "Project id to pull, can be repeated. Every project on the scanner by default.", "id"));
+	parser.addOption(QCommandLineOption("discover", "Milliseconds to wait for scanners to answer.", "ms", "5000"));
+	parser.addOption(QCommandLineOption("timeout", "Seconds without progress before a project is given up on.", "s", "120"));
+	parser.addOption(QCommandLineOption("trace", "Record where the time goes and write it as a chrome trace when done.", "file"));
+	parser.addOption(QCommandLineOption("metrics", "Serve prometheus metrics over http on this port while running.", "port"));
+	parser.addOption(QCommandLineOption("memory-budget", "Megabytes of replies held at once before the connections hold back, 0 for no limit.", "MB"));
+	parser.addOption(QCommandLineOption("store", "Content store shared between project roots, the one set in the inspection tool by default.", "dir"));
+	parser.addOption(QCommandLineOption("rate-limit", "Megabytes per second the transfers may read from every scanner together, 0 for no limit.", "MB/s"));
+	parser.addOption(QCommandLineOption("order", "Order images are fetched in: sequential, newest, pairs or coverage. The one set in the inspection tool by default.", "order"));
+	parser.process(a);
+
+	if (!parser.isSet("root"))
+	{
+		fprintf(stderr, "--root is required\n");
+		parser.showHelp(1);
+	}
+
+	DaemonOptions options = DaemonOptions();
+	options.root = QDir(parser.value("root")).absolutePath();
+	options.scanners = parser.values("scanner");
+	options.discoveryTime = parser.value("discover").toInt();
+	options.inactivityTimeout = parser.value("timeout").toInt() * 1000;
+
+	QStringList projects = parser.values("project");
+	for (int i = 0; i < projects.size(); ++i)
+	{
+		bool valid = false;
+		int id = projects.at(i).toInt(&valid);
+		if (!valid)
+		{
+			fprintf(stderr, "Invalid project id: %s\n", qPrintable(projects.at(i)));
+			return 1;
+		}
+		options.projects.append(id);
+	}
+
+	options.order = TransferScheduler::savedOrder();
+	if (parser.isSet("order") && !TransferScheduler::fromName(parser.value("order"), options.order))
+	{
+		fprintf(stderr, "Unknown order: %s\n", qPrintable(parser.value("order")));
+		return 1;
+	}
+
+	if (options.discoveryTime <= 0) options.discoveryTime = 5000;
+	if (options.inactivityTimeout <= 0) options.inactivityTimeout = 120000;
+
+	if (parser.isSet("trace")) Trace::setEnabled(true);
+	if (parser.isSet("memory-budget"))
+		MemoryBudget::setBudget(MemoryCategory::Network, parser.value("memory-budget").toLongLong() * 1024 * 1024);
+	if (parser.isSet("rate-limit"))
+		TrafficShaper::setRate(qint64(parser.value("rate-limit").toDouble() * 1024 * 1024));
+
+	ContentStore::loadSettings();
+	if (parser.isSet("store")) ContentStore::setRoot(parser.value("store"));
+
+	MetricsServer metrics;
+	if (parser.isSet("metrics") && !metrics.listen(parser.value("metrics").toUShort()))
+	{
+		fprintf(stderr, "Can't serve metrics: %s\n", qPrintable(metrics.errorString()));
+		return 1;
+	}
+
+	TransferDaemon daemon(options);
+	QTimer::singleShot(0, &daemon, &TransferDaemon::start);
+	int result = a.exec();
+
+	if (parser.isSet("trace") && !Trace::writeChromeJson(parser.value("trace")))
+		fprintf(stderr, "Can't write the trace to %s\n", qPrintable(parser.value("trace")));
+	return result;
+}